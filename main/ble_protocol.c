@@ -0,0 +1,187 @@
+/*
+ * BLE数据格式 - 实现文件
+ * 
+ * 功能：LED字符串/二进制帧、舵机角度、连接参数档位的解析与打包
+ */
+
+#include "ble_protocol.h"
+#include <string.h>
+#include <stdio.h>
+
+/* 连接参数档位：按 ble_conn_profile_t 索引，AUTO 不请求 */
+static const ble_conn_profile_params_t s_conn_profiles[BLE_CONN_PROFILE_MAX] = {
+    [BLE_CONN_PROFILE_THROUGHPUT] = {
+        .min_interval = 6,      // 7.5ms
+        .max_interval = 12,     // 15ms
+        .latency = 0,
+        .timeout = 400,         // 4s
+        .tx_octets = 251,       // 单个链路层包承载整条写入/通知
+        .phy_2m = true,
+    },
+    [BLE_CONN_PROFILE_LOW_POWER] = {
+        .min_interval = 80,     // 100ms
+        .max_interval = 160,    // 200ms
+        .latency = 4,           // 无数据时最多跳过4个连接事件（约1s）
+        .timeout = 600,         // 6s，需大于 (1+latency)*max_interval*2
+        .tx_octets = 0,
+        .phy_2m = false,
+    },
+};
+
+/**
+ * @brief 解析LED字符串
+ */
+bool ble_protocol_parse_led_string(const uint8_t *data, uint16_t len, uint8_t *out_led_data, uint16_t led_count)
+{
+    if (!data || !out_led_data || len == 0) {
+        return false;
+    }
+    int count = 0;
+    for (uint16_t i = 0; i < len && count < led_count; i++) {
+        char c = (char)data[i];
+        if (c < '0' || c > '7') {
+            return false;
+        }
+        out_led_data[count++] = (uint8_t)(c - '0');
+    }
+    if (count == 0) {
+        return false;
+    }
+    for (int i = count; i < led_count; i++) {
+        out_led_data[i] = 0;
+    }
+    return true;
+}
+
+/**
+ * @brief 解析LED二进制帧
+ */
+bool ble_protocol_parse_led_binary(const uint8_t *data, uint16_t len, uint8_t *led_data, uint16_t led_count)
+{
+    if (!data || !led_data || len < BLE_LED_BIN_HEADER_LEN || data[0] != BLE_LED_BIN_FMT_PACKED3) {
+        return false;
+    }
+    uint16_t offset = data[1] | (data[2] << 8);
+    uint16_t count = data[3] | (data[4] << 8);
+    if (count == 0 || offset >= led_count || count > led_count - offset) {
+        return false;
+    }
+    if (len != BLE_LED_BIN_HEADER_LEN + BLE_LED_BIN_PAYLOAD_LEN(count)) {
+        return false;
+    }
+    
+    const uint8_t *payload = data + BLE_LED_BIN_HEADER_LEN;
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t bit = i * 3;
+        // 3bit索引可能跨越字节边界，取相邻两个字节拼接
+        uint16_t word = payload[bit / 8];
+        if ((bit % 8) > 5) {
+            word |= payload[bit / 8 + 1] << 8;
+        }
+        led_data[offset + i] = (word >> (bit % 8)) & 0x07;
+    }
+    return true;
+}
+
+/**
+ * @brief 将LED数据打包为二进制帧
+ */
+uint16_t ble_protocol_pack_led_binary(const uint8_t *led_data, uint16_t offset, uint16_t count, uint8_t *out)
+{
+    out[0] = BLE_LED_BIN_FMT_PACKED3;
+    out[1] = offset & 0xFF;
+    out[2] = offset >> 8;
+    out[3] = count & 0xFF;
+    out[4] = count >> 8;
+    
+    uint8_t *payload = out + BLE_LED_BIN_HEADER_LEN;
+    memset(payload, 0, BLE_LED_BIN_PAYLOAD_LEN(count));
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t bit = i * 3;
+        uint16_t word = (led_data[offset + i] & 0x07) << (bit % 8);
+        payload[bit / 8] |= word & 0xFF;
+        if (word >> 8) {
+            payload[bit / 8 + 1] |= word >> 8;
+        }
+    }
+    return BLE_LED_BIN_HEADER_LEN + BLE_LED_BIN_PAYLOAD_LEN(count);
+}
+
+/**
+ * @brief 解析舵机角度数据
+ */
+bool ble_protocol_parse_servo(const uint8_t *data, uint16_t len, float *out_angle)
+{
+    if (!data || !out_angle || len == 0) {
+        return false;
+    }
+    
+    // 尝试作为字符串解析
+    char str_buf[16] = {0};
+    uint16_t copy_len = (len < sizeof(str_buf) - 1) ? len : sizeof(str_buf) - 1;
+    memcpy(str_buf, data, copy_len);
+    
+    float angle = 0.0f;
+    if (sscanf(str_buf, "%f", &angle) == 1) {
+        // 成功解析为浮点数
+        if (angle >= 0.0f && angle <= 270.0f) {
+            *out_angle = angle;
+            return true;
+        }
+    }
+    
+    // 如果是单字节，映射0-180到0-270
+    if (len == 1) {
+        uint8_t val = data[0];
+        if (val <= 180) {
+            *out_angle = (float)val * 270.0f / 180.0f;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+/**
+ * @brief 获取连接参数档位的请求参数
+ */
+const ble_conn_profile_params_t *ble_protocol_get_conn_profile(uint8_t profile)
+{
+    if (profile == BLE_CONN_PROFILE_AUTO || profile >= BLE_CONN_PROFILE_MAX) {
+        return NULL;
+    }
+    return &s_conn_profiles[profile];
+}
+
+/**
+ * @brief 解析连接参数档位写入
+ */
+bool ble_protocol_parse_conn_profile(const uint8_t *data, uint16_t len, ble_conn_profile_t *out_profile)
+{
+    if (!data || !out_profile || len != 1) {
+        return false;
+    }
+    uint8_t value = data[0] >= '0' ? data[0] - '0' : data[0];
+    if (value >= BLE_CONN_PROFILE_MAX) {
+        return false;
+    }
+    *out_profile = (ble_conn_profile_t)value;
+    return true;
+}
+
+/**
+ * @brief 打包连接状态
+ */
+uint16_t ble_protocol_pack_conn_status(const ble_conn_status_t *status, uint8_t *out)
+{
+    out[0] = status->profile;
+    out[1] = status->interval & 0xFF;
+    out[2] = status->interval >> 8;
+    out[3] = status->latency & 0xFF;
+    out[4] = status->latency >> 8;
+    out[5] = status->timeout & 0xFF;
+    out[6] = status->timeout >> 8;
+    out[7] = status->tx_phy;
+    out[8] = status->rx_phy;
+    return BLE_CONN_STATUS_LEN;
+}
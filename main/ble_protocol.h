@@ -0,0 +1,158 @@
+/*
+ * BLE数据格式 - 头文件
+ * 
+ * 功能：LED字符串/二进制帧、舵机角度、连接参数档位的解析与打包，与BLE协议栈无关（Bluedroid/NimBLE共用）
+ */
+
+#ifndef BLE_PROTOCOL_H
+#define BLE_PROTOCOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * LED二进制帧格式（特征值0xFF06，支持无响应写入）
+ * 
+ * B0:     格式，BLE_LED_BIN_FMT_PACKED3 = 3bit调色板索引紧凑打包
+ * B1-B2:  起始LED索引 offset（小端）
+ * B3-B4:  LED个数 count（小端）
+ * B5...:  count个3bit颜色索引，按LED顺序从低位开始连续打包，共 ceil(count*3/8) 字节
+ * 
+ * 例：60颗LED整帧为 5 + 23 = 28 字节，ASCII字符串格式需要60字节
+ */
+#define BLE_LED_BIN_FMT_PACKED3     0x01
+#define BLE_LED_BIN_HEADER_LEN      5
+#define BLE_LED_BIN_PAYLOAD_LEN(n)  (((n) * 3 + 7) / 8)
+
+/**
+ * @brief BLE连接参数档位
+ * 
+ * 每个连接单独选择：连接建立时使用 BLE_CONN_DEFAULT_PROFILE，客户端向连接参数特征值（0xFF09）
+ * 写入1字节档位即可切换
+ */
+typedef enum {
+    BLE_CONN_PROFILE_AUTO = 0,      // 跟随电源管理（ble_service_set_conn_params），未设置时由主机决定
+    BLE_CONN_PROFILE_THROUGHPUT,    // LED流式控制：短连接间隔，无从机延迟，DLE，2M PHY
+    BLE_CONN_PROFILE_LOW_POWER,     // 仅传感器：长连接间隔，从机延迟，1M PHY
+    BLE_CONN_PROFILE_MAX,
+} ble_conn_profile_t;
+
+#define BLE_CONN_DEFAULT_PROFILE    BLE_CONN_PROFILE_AUTO
+
+/**
+ * @brief 连接参数档位对应的请求参数
+ */
+typedef struct {
+    uint16_t min_interval;  // 最小连接间隔（1.25ms单位）
+    uint16_t max_interval;  // 最大连接间隔（1.25ms单位）
+    uint16_t latency;       // 从机延迟（连接事件数）
+    uint16_t timeout;       // 监督超时（10ms单位）
+    uint16_t tx_octets;     // DLE发送长度，0=不请求
+    bool phy_2m;            // true=请求2M PHY，false=请求1M PHY
+} ble_conn_profile_params_t;
+
+/*
+ * 连接状态（特征值0xFF09读取/通知，小端）
+ * 
+ * B0:     当前档位 ble_conn_profile_t
+ * B1-B2:  连接间隔（1.25ms单位），0=未知
+ * B3-B4:  从机延迟（连接事件数）
+ * B5-B6:  监督超时（10ms单位）
+ * B7:     TX PHY（1=1M，2=2M）
+ * B8:     RX PHY
+ * 
+ * 连接参数或PHY更新完成后通知订阅的客户端
+ */
+#define BLE_CONN_STATUS_LEN     9
+
+/**
+ * @brief 连接状态
+ */
+typedef struct {
+    uint8_t profile;        // ble_conn_profile_t
+    uint16_t interval;      // 连接间隔（1.25ms单位）
+    uint16_t latency;       // 从机延迟
+    uint16_t timeout;       // 监督超时（10ms单位）
+    uint8_t tx_phy;         // 1=1M，2=2M
+    uint8_t rx_phy;
+} ble_conn_status_t;
+
+/**
+ * @brief 解析LED字符串（ASCII '0'~'7'）
+ * 
+ * 不足 led_count 的部分熄灭，超出的字符忽略
+ * 
+ * @param data 写入数据
+ * @param len 数据长度
+ * @param out_led_data 输出LED颜色索引（led_count个）
+ * @param led_count LED数量
+ * @return true=解析成功
+ */
+bool ble_protocol_parse_led_string(const uint8_t *data, uint16_t len, uint8_t *out_led_data, uint16_t led_count);
+
+/**
+ * @brief 解析LED二进制帧，将指定区间写入LED数据
+ * 
+ * 区间外的LED保持不变
+ * 
+ * @param data 帧数据
+ * @param len 帧长度
+ * @param led_data LED颜色索引数组（led_count个）
+ * @param led_count LED数量
+ * @return true=解析成功
+ */
+bool ble_protocol_parse_led_binary(const uint8_t *data, uint16_t len, uint8_t *led_data, uint16_t led_count);
+
+/**
+ * @brief 将LED数据打包为二进制帧
+ * 
+ * @param led_data LED颜色索引数组
+ * @param offset 起始LED索引
+ * @param count LED个数
+ * @param out 输出缓冲区（至少 BLE_LED_BIN_HEADER_LEN + BLE_LED_BIN_PAYLOAD_LEN(count) 字节）
+ * @return 帧长度
+ */
+uint16_t ble_protocol_pack_led_binary(const uint8_t *led_data, uint16_t offset, uint16_t count, uint8_t *out);
+
+/**
+ * @brief 解析舵机角度数据
+ * 
+ * 支持两种格式：
+ * 1. 字符串：直接解析为角度值（如"135.5"）
+ * 2. 单字节：0-180映射到0-270度
+ * 
+ * @param data 写入数据
+ * @param len 数据长度
+ * @param out_angle 输出角度 (0.0 ~ 270.0度)
+ * @return true=解析成功
+ */
+bool ble_protocol_parse_servo(const uint8_t *data, uint16_t len, float *out_angle);
+
+/**
+ * @brief 获取连接参数档位的请求参数
+ * 
+ * @param profile 档位
+ * @return 请求参数；BLE_CONN_PROFILE_AUTO 或无效档位返回NULL
+ */
+const ble_conn_profile_params_t *ble_protocol_get_conn_profile(uint8_t profile);
+
+/**
+ * @brief 解析连接参数档位写入（1字节，二进制或ASCII数字）
+ * 
+ * @param data 写入数据
+ * @param len 数据长度
+ * @param out_profile 输出档位
+ * @return true=解析成功
+ */
+bool ble_protocol_parse_conn_profile(const uint8_t *data, uint16_t len, ble_conn_profile_t *out_profile);
+
+/**
+ * @brief 打包连接状态
+ * 
+ * @param status 连接状态
+ * @param out 输出缓冲区（至少 BLE_CONN_STATUS_LEN 字节）
+ * @return 数据长度
+ */
+uint16_t ble_protocol_pack_conn_status(const ble_conn_status_t *status, uint8_t *out);
+
+#endif // BLE_PROTOCOL_H
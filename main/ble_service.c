@@ -6,12 +6,15 @@
 
 #include "ble_service.h"
 #include "ws2812_driver.h"
+#include "metrics.h"
+#include "cycle_trace.h"
 #include "esp_log.h"
 #include "esp_bt.h"
 #include "esp_gap_ble_api.h"
 #include "esp_gatts_api.h"
 #include "esp_bt_main.h"
 #include "esp_gatt_common_api.h"
+#include "freertos/FreeRTOS.h"
 #include <string.h>
 #include <ctype.h>
 #include <stdio.h>
@@ -20,12 +23,64 @@
 static const char* TAG = "BLE_SERVICE";
 
 /* GATT服务配置 */
-#define GATTS_NUM_HANDLE    16      // 服务(1) + 5个特征值
+#define CHAR_VAL_MAX_LEN    ESP_GATT_MAX_ATTR_LEN   // 特征值最大长度（值由应用响应，协议栈不分配存储）
 #define ADV_CONFIG_FLAG     BIT0
 #define SCAN_RSP_CONFIG_FLAG BIT1
 
-/* CCCD UUID (固定值 0x2902) */
-#define CCCD_UUID           0x2902
+/* 写入缓冲区：ATT属性值最长512字节，GATTS回调只在BTU任务中执行，不占用BTU任务栈 */
+#define WRITE_BUF_SIZE      (ESP_GATT_MAX_ATTR_LEN + 1)
+
+/* 连接已订阅的通知（CCCD位） */
+#define CCCD_BIT_SENSOR     BIT0
+#define CCCD_BIT_PROV       BIT1
+#define CCCD_BIT_CONN       BIT2
+
+/**
+ * @brief GATT属性表索引
+ * 
+ * 与 gatt_db 一一对应，创建后 ble_handles[索引] 即为属性句柄。
+ * 新增特征值时只需在这里和 gatt_db 各加一项
+ */
+enum {
+    IDX_SVC,
+    IDX_LED_CHAR,           // LED控制
+    IDX_LED_VAL,
+    IDX_SERVO_CHAR,         // 舵机控制
+    IDX_SERVO_VAL,
+    IDX_SENSOR_CHAR,        // 传感器数据
+    IDX_SENSOR_VAL,
+    IDX_SENSOR_CCCD,
+    IDX_WIFI_CHAR,          // WiFi配置
+    IDX_WIFI_VAL,
+    IDX_MQTT_CHAR,          // MQTT配置
+    IDX_MQTT_VAL,
+    IDX_LED_BIN_CHAR,       // LED二进制控制
+    IDX_LED_BIN_VAL,
+    IDX_EFFECT_CHAR,        // 灯效控制
+    IDX_EFFECT_VAL,
+    IDX_PROV_CHAR,          // 配网状态
+    IDX_PROV_VAL,
+    IDX_PROV_CCCD,
+    IDX_CONN_CHAR,          // 连接参数档位
+    IDX_CONN_VAL,
+    IDX_CONN_CCCD,
+    IDX_STATS_CHAR,         // 运行统计
+    IDX_STATS_VAL,
+    ATTR_IDX_COUNT,
+};
+
+/**
+ * @brief 单个连接的状态
+ */
+typedef struct {
+    bool in_use;
+    uint16_t conn_id;
+    uint16_t mtu;                           // 协商后的MTU
+    uint8_t cccd;                           // 已订阅的通知，CCCD_BIT_*
+    m701_payload_format_t sensor_format;    // 传感器通知格式（每个连接单独选择）
+    esp_bd_addr_t bda;                      // 对端地址
+    ble_conn_status_t status;               // 连接参数档位和实际生效的参数
+} ble_conn_t;
 
 /* 全局变量 */
 static uint8_t g_led_data[WS2812_LED_COUNT] = {0};      // 当前LED数据
@@ -34,41 +89,16 @@ static ble_servo_callback_t g_servo_callback = NULL;    // 舵机数据回调
 static float g_servo_angle = 135.0f;                    // 当前舵机角度(默认中立位置)
 static uint8_t adv_config_state = ADV_CONFIG_FLAG | SCAN_RSP_CONFIG_FLAG;
 static esp_gatt_if_t ble_gatts_if = ESP_GATT_IF_NONE;
-static uint16_t ble_service_handle = 0;
-static uint16_t ble_char_handle = 0;          // LED特征值句柄
-static uint16_t ble_servo_char_handle = 0;    // 舵机特征值句柄
-static uint16_t ble_sensor_char_handle = 0;   // 传感器特征值句柄
-static uint16_t ble_sensor_cccd_handle = 0;   // 传感器CCCD句柄
-static uint16_t ble_wifi_config_handle = 0;   // WiFi配置特征值句柄
-static uint16_t ble_mqtt_config_handle = 0;   // MQTT配置特征值句柄
-static uint16_t ble_conn_id = 0;
-static bool ble_connected = false;            // 连接状态
-static bool sensor_notify_enabled = false;    // 传感器通知是否已启用
-static uint8_t char_add_count = 0;            // 特征值添加计数器
+static uint16_t ble_handles[ATTR_IDX_COUNT] = {0};    // 属性句柄，按 IDX_* 索引，创建完成前全为0
+static ble_conn_t ble_conns[BLE_MAX_CONNECTIONS] = {0};  // 连接表（GATTS回调中修改，其他任务持锁读取）
+static portMUX_TYPE ble_conn_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool ble_advertising = false;          // 广播已启动或正在启动
+static esp_ble_conn_update_params_t ble_conn_params = {0};    // 期望的连接参数，min_int为0表示不请求（持 ble_conn_lock 访问）
 static ble_wifi_config_callback_t g_wifi_config_callback = NULL;
 static ble_mqtt_config_callback_t g_mqtt_config_callback = NULL;
-
-static bool parse_led_data_string(const uint8_t *data, uint16_t len, uint8_t *out_led_data)
-{
-    if (!data || !out_led_data || len == 0) {
-        return false;
-    }
-    int count = 0;
-    for (uint16_t i = 0; i < len && count < WS2812_LED_COUNT; i++) {
-        char c = (char)data[i];
-        if (c < '0' || c > '7') {
-            return false;
-        }
-        out_led_data[count++] = (uint8_t)(c - '0');
-    }
-    if (count == 0) {
-        return false;
-    }
-    for (int i = count; i < WS2812_LED_COUNT; i++) {
-        out_led_data[i] = 0;
-    }
-    return true;
-}
+static ble_effect_callback_t g_effect_callback = NULL;
+static char s_write_buf[WRITE_BUF_SIZE];                // 文本写入（以'\0'结尾）
+static uint8_t s_led_scratch[WS2812_LED_COUNT];         // LED写入解析结果
 
 static uint8_t adv_payload[] = {
     0x02, 0x01, 0x06,
@@ -85,84 +115,304 @@ static esp_ble_adv_params_t adv_params = {
     .adv_filter_policy = ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY,
 };
 
-static esp_gatt_srvc_id_t ble_service_id = {
-    .is_primary = true,
-    .id = {
-        .inst_id = 0x00,
-        .uuid = {
-            .len = ESP_UUID_LEN_16,
-            .uuid = {.uuid16 = BLE_SERVICE_UUID}
+/**
+ * @brief 按conn_id查找连接（GATTS回调中调用）
+ * 
+ * @return 连接状态，未找到返回NULL
+ */
+static ble_conn_t *find_conn(uint16_t conn_id)
+{
+    for (int i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (ble_conns[i].in_use && ble_conns[i].conn_id == conn_id) {
+            return &ble_conns[i];
         }
     }
-};
-
-static esp_bt_uuid_t ble_char_uuid = {
-    .len = ESP_UUID_LEN_16,
-    .uuid = {.uuid16 = BLE_CHAR_UUID}
-};
-
-static esp_bt_uuid_t ble_servo_char_uuid = {
-    .len = ESP_UUID_LEN_16,
-    .uuid = {.uuid16 = BLE_SERVO_CHAR_UUID}
-};
-
-static esp_bt_uuid_t ble_sensor_char_uuid = {
-    .len = ESP_UUID_LEN_16,
-    .uuid = {.uuid16 = BLE_SENSOR_CHAR_UUID}
-};
+    return NULL;
+}
 
-static esp_bt_uuid_t cccd_uuid = {
-    .len = ESP_UUID_LEN_16,
-    .uuid = {.uuid16 = CCCD_UUID}
-};
+/**
+ * @brief 当前连接数（GATTS回调中调用）
+ */
+static int conn_count(void)
+{
+    int count = 0;
+    for (int i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (ble_conns[i].in_use) {
+            count++;
+        }
+    }
+    return count;
+}
 
-static esp_bt_uuid_t ble_wifi_config_uuid = {
-    .len = ESP_UUID_LEN_16,
-    .uuid = {.uuid16 = BLE_WIFI_CONFIG_UUID}
-};
+/**
+ * @brief 连接数未达上限时启动广播
+ * 
+ * 可连接广播在建立连接后由控制器自动停止，每次连接/断开后都调用一次
+ */
+static void start_advertising(void)
+{
+    if (ble_advertising || conn_count() >= BLE_MAX_CONNECTIONS) {
+        return;
+    }
+    if (esp_ble_gap_start_advertising(&adv_params) == ESP_OK) {
+        ble_advertising = true;
+    }
+}
 
-static esp_bt_uuid_t ble_mqtt_config_uuid = {
-    .len = ESP_UUID_LEN_16,
-    .uuid = {.uuid16 = BLE_MQTT_CONFIG_UUID}
-};
+/**
+ * @brief 设置或清除连接的订阅位（GATTS回调中调用）
+ */
+static void set_cccd_bit(ble_conn_t *conn, uint8_t bit, bool enable)
+{
+    portENTER_CRITICAL(&ble_conn_lock);
+    if (enable) {
+        conn->cccd |= bit;
+    } else {
+        conn->cccd &= ~bit;
+    }
+    portEXIT_CRITICAL(&ble_conn_lock);
+}
 
 /**
- * @brief 解析舵机角度数据
+ * @brief 向主机请求期望的连接参数
  * 
- * 支持两种格式：
- * 1. 单字节：0-180映射到0-270度
- * 2. 字符串：直接解析为角度值（如"135.5"）
+ * @param bda 对端地址
  */
-static bool parse_servo_data(const uint8_t *data, uint16_t len, float *out_angle)
+static void request_conn_params(const esp_bd_addr_t bda)
 {
-    if (!data || !out_angle || len == 0) {
-        return false;
+    portENTER_CRITICAL(&ble_conn_lock);
+    esp_ble_conn_update_params_t params = ble_conn_params;
+    portEXIT_CRITICAL(&ble_conn_lock);
+    if (params.min_int == 0) {
+        return;
     }
     
-    // 尝试作为字符串解析
-    char str_buf[16] = {0};
-    uint16_t copy_len = (len < sizeof(str_buf) - 1) ? len : sizeof(str_buf) - 1;
-    memcpy(str_buf, data, copy_len);
+    memcpy(params.bda, bda, sizeof(esp_bd_addr_t));
+    esp_err_t ret = esp_ble_gap_update_conn_params(&params);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Conn params update failed: %s", esp_err_to_name(ret));
+    }
+}
+
+/**
+ * @brief 向指定连接发送通知，失败计入运行统计
+ */
+static esp_err_t send_notify(uint16_t conn_id, uint16_t handle, uint16_t len, const void *data)
+{
+    esp_err_t ret = esp_ble_gatts_send_indicate(ble_gatts_if, conn_id, handle, len, (uint8_t *)data, false);
+    if (ret != ESP_OK) {
+        metrics_count(METRICS_COUNTER_BLE_NOTIFY_FAIL);
+    }
+    return ret;
+}
+
+/**
+ * @brief 向所有已订阅的连接发送通知
+ * 
+ * 先持锁复制conn_id再逐个发送，发送期间连接表可被GATTS回调修改
+ * 
+ * @param cccd_bit 需要的订阅位
+ * @param format 传感器通知格式，仅 CCCD_BIT_SENSOR 时比较
+ * @param handle 特征值句柄
+ * @return 成功发送的连接数
+ */
+static int notify_subscribers(uint8_t cccd_bit, m701_payload_format_t format,
+                              uint16_t handle, const void *data, uint16_t len)
+{
+    uint16_t conn_ids[BLE_MAX_CONNECTIONS];
+    int count = 0;
     
-    float angle = 0.0f;
-    if (sscanf(str_buf, "%f", &angle) == 1) {
-        // 成功解析为浮点数
-        if (angle >= 0.0f && angle <= 270.0f) {
-            *out_angle = angle;
-            return true;
+    portENTER_CRITICAL(&ble_conn_lock);
+    for (int i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        const ble_conn_t *conn = &ble_conns[i];
+        if (conn->in_use && (conn->cccd & cccd_bit) &&
+            (cccd_bit != CCCD_BIT_SENSOR || conn->sensor_format == format)) {
+            conn_ids[count++] = conn->conn_id;
         }
     }
+    portEXIT_CRITICAL(&ble_conn_lock);
     
-    // 如果是单字节，映射0-180到0-270
-    if (len == 1) {
-        uint8_t val = data[0];
-        if (val <= 180) {
-            *out_angle = (float)val * 270.0f / 180.0f;
-            return true;
+    int sent = 0;
+    for (int i = 0; i < count; i++) {
+        esp_err_t ret = send_notify(conn_ids[i], handle, len, data);
+        if (ret == ESP_OK) {
+            sent++;
+        } else {
+            ESP_LOGW(TAG, "Notify conn_id=%d failed: %s", conn_ids[i], esp_err_to_name(ret));
+        }
+    }
+    return sent;
+}
+
+/**
+ * @brief 按对端地址查找连接（GAP回调中调用）
+ * 
+ * @return 连接状态，未找到返回NULL
+ */
+static ble_conn_t *find_conn_by_bda(const esp_bd_addr_t bda)
+{
+    for (int i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (ble_conns[i].in_use && memcmp(ble_conns[i].bda, bda, sizeof(esp_bd_addr_t)) == 0) {
+            return &ble_conns[i];
         }
     }
+    return NULL;
+}
+
+/**
+ * @brief CCCD句柄对应的订阅位
+ * 
+ * @return CCCD_BIT_*，不是CCCD返回0
+ */
+static uint8_t cccd_bit_from_handle(uint16_t handle)
+{
+    if (handle == 0) {
+        return 0;
+    } else if (handle == ble_handles[IDX_SENSOR_CCCD]) {
+        return CCCD_BIT_SENSOR;
+    } else if (handle == ble_handles[IDX_PROV_CCCD]) {
+        return CCCD_BIT_PROV;
+    } else if (handle == ble_handles[IDX_CONN_CCCD]) {
+        return CCCD_BIT_CONN;
+    }
+    return 0;
+}
+
+/**
+ * @brief 应用连接的参数档位
+ * 
+ * 请求连接参数、DLE和PHY，实际生效的参数在GAP更新完成事件中记录并通知
+ */
+static void apply_conn_profile(const ble_conn_t *conn)
+{
+    const ble_conn_profile_params_t *profile = ble_protocol_get_conn_profile(conn->status.profile);
+    if (!profile) {
+        // AUTO：跟随电源管理设置的参数
+        request_conn_params(conn->bda);
+        return;
+    }
     
-    return false;
+    esp_ble_conn_update_params_t params = {
+        .min_int = profile->min_interval,
+        .max_int = profile->max_interval,
+        .latency = profile->latency,
+        .timeout = profile->timeout,
+    };
+    memcpy(params.bda, conn->bda, sizeof(esp_bd_addr_t));
+    esp_err_t ret = esp_ble_gap_update_conn_params(&params);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Conn params update failed: %s", esp_err_to_name(ret));
+    }
+    
+    esp_bd_addr_t bda;
+    memcpy(bda, conn->bda, sizeof(esp_bd_addr_t));
+    if (profile->tx_octets) {
+        esp_ble_gap_set_pkt_data_len(bda, profile->tx_octets);
+    }
+#if CONFIG_BT_BLE_50_FEATURES_SUPPORTED
+    esp_ble_gap_phy_mask_t phy_mask = profile->phy_2m ? ESP_BLE_GAP_PHY_2M_PREF_MASK : ESP_BLE_GAP_PHY_1M_PREF_MASK;
+    esp_ble_gap_set_preferred_phy(bda, 0, phy_mask, phy_mask, ESP_BLE_GAP_PHY_OPTIONS_NO_PREF);
+#endif
+}
+
+/**
+ * @brief 向订阅了连接状态的客户端通知当前参数
+ */
+static void notify_conn_status(const ble_conn_t *conn)
+{
+    if (!(conn->cccd & CCCD_BIT_CONN) || ble_handles[IDX_CONN_VAL] == 0) {
+        return;
+    }
+    
+    uint8_t buf[BLE_CONN_STATUS_LEN];
+    uint16_t len = ble_protocol_pack_conn_status(&conn->status, buf);
+    send_notify(conn->conn_id, ble_handles[IDX_CONN_VAL], len, buf);
+}
+
+/* 属性表用到的UUID和特征值属性 */
+static const uint16_t primary_service_uuid = ESP_GATT_UUID_PRI_SERVICE;
+static const uint16_t char_decl_uuid = ESP_GATT_UUID_CHAR_DECLARE;
+static const uint16_t cccd_uuid = ESP_GATT_UUID_CHAR_CLIENT_CONFIG;
+static const uint16_t ble_service_uuid = BLE_SERVICE_UUID;
+static const uint16_t ble_char_uuid = BLE_CHAR_UUID;
+static const uint16_t ble_servo_char_uuid = BLE_SERVO_CHAR_UUID;
+static const uint16_t ble_sensor_char_uuid = BLE_SENSOR_CHAR_UUID;
+static const uint16_t ble_wifi_config_uuid = BLE_WIFI_CONFIG_UUID;
+static const uint16_t ble_mqtt_config_uuid = BLE_MQTT_CONFIG_UUID;
+static const uint16_t ble_led_bin_uuid = BLE_LED_BIN_CHAR_UUID;
+static const uint16_t ble_effect_uuid = BLE_EFFECT_CHAR_UUID;
+static const uint16_t ble_prov_char_uuid = BLE_PROV_CHAR_UUID;
+static const uint16_t ble_conn_char_uuid = BLE_CONN_CHAR_UUID;
+static const uint16_t ble_stats_char_uuid = BLE_STATS_CHAR_UUID;
+static const uint8_t prop_read_write_notify = ESP_GATT_CHAR_PROP_BIT_READ | ESP_GATT_CHAR_PROP_BIT_WRITE | ESP_GATT_CHAR_PROP_BIT_NOTIFY;
+static const uint8_t prop_read_write = ESP_GATT_CHAR_PROP_BIT_READ | ESP_GATT_CHAR_PROP_BIT_WRITE;
+static const uint8_t prop_read_write_nr = ESP_GATT_CHAR_PROP_BIT_READ | ESP_GATT_CHAR_PROP_BIT_WRITE | ESP_GATT_CHAR_PROP_BIT_WRITE_NR;
+static const uint8_t prop_read = ESP_GATT_CHAR_PROP_BIT_READ;
+static const uint8_t prop_write = ESP_GATT_CHAR_PROP_BIT_WRITE;
+static const uint8_t prop_notify = ESP_GATT_CHAR_PROP_BIT_NOTIFY;
+
+/* 特征值声明：协议栈自动响应 */
+#define ATTR_CHAR_DECL(prop) \
+    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&char_decl_uuid, ESP_GATT_PERM_READ, \
+                           sizeof(uint8_t), sizeof(uint8_t), (uint8_t *)&(prop)}}
+
+/* 特征值/CCCD：读写事件由应用处理并响应 */
+#define ATTR_VALUE(uuid, perm, max_len) \
+    {{ESP_GATT_RSP_BY_APP}, {ESP_UUID_LEN_16, (uint8_t *)&(uuid), (perm), (max_len), 0, NULL}}
+
+/**
+ * @brief GATT服务属性表
+ * 
+ * 由 esp_ble_gatts_create_attr_tab 一次创建整个服务，替代逐个添加特征值
+ */
+static const esp_gatts_attr_db_t gatt_db[ATTR_IDX_COUNT] = {
+    [IDX_SVC] =
+        {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&primary_service_uuid, ESP_GATT_PERM_READ,
+                               sizeof(uint16_t), sizeof(ble_service_uuid), (uint8_t *)&ble_service_uuid}},
+
+    [IDX_LED_CHAR]      = ATTR_CHAR_DECL(prop_read_write_notify),
+    [IDX_LED_VAL]       = ATTR_VALUE(ble_char_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, CHAR_VAL_MAX_LEN),
+
+    [IDX_SERVO_CHAR]    = ATTR_CHAR_DECL(prop_read_write_notify),
+    [IDX_SERVO_VAL]     = ATTR_VALUE(ble_servo_char_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, CHAR_VAL_MAX_LEN),
+
+    [IDX_SENSOR_CHAR]   = ATTR_CHAR_DECL(prop_read_write_notify),
+    [IDX_SENSOR_VAL]    = ATTR_VALUE(ble_sensor_char_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, CHAR_VAL_MAX_LEN),
+    [IDX_SENSOR_CCCD]   = ATTR_VALUE(cccd_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, sizeof(uint16_t)),
+
+    [IDX_WIFI_CHAR]     = ATTR_CHAR_DECL(prop_read_write),
+    [IDX_WIFI_VAL]      = ATTR_VALUE(ble_wifi_config_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, CHAR_VAL_MAX_LEN),
+
+    [IDX_MQTT_CHAR]     = ATTR_CHAR_DECL(prop_read_write),
+    [IDX_MQTT_VAL]      = ATTR_VALUE(ble_mqtt_config_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, CHAR_VAL_MAX_LEN),
+
+    [IDX_LED_BIN_CHAR]  = ATTR_CHAR_DECL(prop_read_write_nr),
+    [IDX_LED_BIN_VAL]   = ATTR_VALUE(ble_led_bin_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, CHAR_VAL_MAX_LEN),
+
+    [IDX_EFFECT_CHAR]   = ATTR_CHAR_DECL(prop_write),
+    [IDX_EFFECT_VAL]    = ATTR_VALUE(ble_effect_uuid, ESP_GATT_PERM_WRITE, CHAR_VAL_MAX_LEN),
+
+    [IDX_PROV_CHAR]     = ATTR_CHAR_DECL(prop_notify),
+    [IDX_PROV_VAL]      = ATTR_VALUE(ble_prov_char_uuid, ESP_GATT_PERM_READ, CHAR_VAL_MAX_LEN),
+    [IDX_PROV_CCCD]     = ATTR_VALUE(cccd_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, sizeof(uint16_t)),
+
+    [IDX_CONN_CHAR]     = ATTR_CHAR_DECL(prop_read_write_notify),
+    [IDX_CONN_VAL]      = ATTR_VALUE(ble_conn_char_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, BLE_CONN_STATUS_LEN),
+    [IDX_CONN_CCCD]     = ATTR_VALUE(cccd_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, sizeof(uint16_t)),
+
+    [IDX_STATS_CHAR]    = ATTR_CHAR_DECL(prop_read),
+    [IDX_STATS_VAL]     = ATTR_VALUE(ble_stats_char_uuid, ESP_GATT_PERM_READ, METRICS_BIN_MAX_LEN),
+};
+
+/**
+ * @brief 复制文本写入到 s_write_buf 并添加结束符，超长截断，返回复制的字节数
+ */
+static int copy_write_text(const uint8_t *value, uint16_t len)
+{
+    int copy_len = (len < WRITE_BUF_SIZE - 1) ? len : WRITE_BUF_SIZE - 1;
+    memcpy(s_write_buf, value, copy_len);
+    s_write_buf[copy_len] = '\0';
+    return copy_len;
 }
 
 /**
@@ -179,6 +429,7 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
         break;
     case ESP_GAP_BLE_ADV_START_COMPLETE_EVT:
         if (param->adv_start_cmpl.status != ESP_BT_STATUS_SUCCESS) {
+            ble_advertising = false;
             ESP_LOGE(TAG, "Advertising start failed: %d", param->adv_start_cmpl.status);
         } else {
             ESP_LOGI(TAG, "Advertising started");
@@ -189,15 +440,47 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
             ESP_LOGE(TAG, "Advertising stop failed");
         } else {
             ESP_LOGW(TAG, "Advertising stopped, restarting");
-            esp_ble_gap_start_advertising(&adv_params);
+            ble_advertising = false;
+            start_advertising();
         }
         break;
+    case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT: {
+        ESP_LOGI(TAG, "Conn params updated: status=%d, interval=%d, latency=%d, timeout=%d",
+                 param->update_conn_params.status, param->update_conn_params.conn_int,
+                 param->update_conn_params.latency, param->update_conn_params.timeout);
+        ble_conn_t *conn = find_conn_by_bda(param->update_conn_params.bda);
+        if (conn && param->update_conn_params.status == ESP_BT_STATUS_SUCCESS) {
+            conn->status.interval = param->update_conn_params.conn_int;
+            conn->status.latency = param->update_conn_params.latency;
+            conn->status.timeout = param->update_conn_params.timeout;
+            notify_conn_status(conn);
+        }
+        break;
+    }
+    case ESP_GAP_BLE_SET_PKT_LENGTH_COMPLETE_EVT:
+        ESP_LOGI(TAG, "Data length updated: status=%d, rx=%d, tx=%d",
+                 param->pkt_data_length_cmpl.status, param->pkt_data_length_cmpl.params.rx_len,
+                 param->pkt_data_length_cmpl.params.tx_len);
+        break;
+#if CONFIG_BT_BLE_50_FEATURES_SUPPORTED
+    case ESP_GAP_BLE_PHY_UPDATE_COMPLETE_EVT: {
+        ESP_LOGI(TAG, "PHY updated: status=%d, tx=%d, rx=%d",
+                 param->phy_update.status, param->phy_update.tx_phy, param->phy_update.rx_phy);
+        ble_conn_t *conn = find_conn_by_bda(param->phy_update.bda);
+        if (conn && param->phy_update.status == ESP_BT_STATUS_SUCCESS) {
+            conn->status.tx_phy = param->phy_update.tx_phy;
+            conn->status.rx_phy = param->phy_update.rx_phy;
+            notify_conn_status(conn);
+        }
+        break;
+    }
+#endif
     default:
         break;
     }
 
     if (adv_config_state == 0) {
-        esp_ble_gap_start_advertising(&adv_params);
+        start_advertising();
         adv_config_state = 0xFF; // prevent repeated start until reconfigured
     }
 }
@@ -215,117 +498,150 @@ static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_
         esp_ble_gap_set_device_name(BLE_DEVICE_NAME);
         esp_ble_gap_config_adv_data_raw(adv_payload, sizeof(adv_payload));
         esp_ble_gap_config_scan_rsp_data_raw(adv_payload, sizeof(adv_payload));
-        esp_ble_gatts_create_service(gatts_if, &ble_service_id, GATTS_NUM_HANDLE);
+        esp_ble_gatts_create_attr_tab(gatt_db, gatts_if, ATTR_IDX_COUNT, 0);
         break;
 
-    case ESP_GATTS_CREATE_EVT:
-        ble_service_handle = param->create.service_handle;
-        esp_ble_gatts_start_service(ble_service_handle);
-        char_add_count = 0;
-        // 添加LED控制特征值
-        esp_ble_gatts_add_char(ble_service_handle, &ble_char_uuid,
-                               ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
-                               ESP_GATT_CHAR_PROP_BIT_READ |
-                               ESP_GATT_CHAR_PROP_BIT_WRITE |
-                               ESP_GATT_CHAR_PROP_BIT_NOTIFY,
-                               NULL, NULL);
+    case ESP_GATTS_CREAT_ATTR_TAB_EVT:
+        if (param->add_attr_tab.status != ESP_GATT_OK || param->add_attr_tab.num_handle != ATTR_IDX_COUNT) {
+            ESP_LOGE(TAG, "Create attribute table failed: status=%d, handles=%d",
+                     param->add_attr_tab.status, param->add_attr_tab.num_handle);
+            break;
+        }
+        memcpy(ble_handles, param->add_attr_tab.handles, sizeof(ble_handles));
+        esp_ble_gatts_start_service(ble_handles[IDX_SVC]);
+        ESP_LOGI(TAG, "All char handles - LED:%d, Servo:%d, Sensor:%d, WiFi:%d, MQTT:%d, LED-BIN:%d, Effect:%d, Prov:%d, Conn:%d, Stats:%d", 
+                 ble_handles[IDX_LED_VAL], ble_handles[IDX_SERVO_VAL], ble_handles[IDX_SENSOR_VAL],
+                 ble_handles[IDX_WIFI_VAL], ble_handles[IDX_MQTT_VAL], ble_handles[IDX_LED_BIN_VAL],
+                 ble_handles[IDX_EFFECT_VAL], ble_handles[IDX_PROV_VAL], ble_handles[IDX_CONN_VAL],
+                 ble_handles[IDX_STATS_VAL]);
         break;
 
-    case ESP_GATTS_ADD_CHAR_EVT:
-        if (char_add_count == 0) {
-            // 第一个特征值：LED控制
-            ble_char_handle = param->add_char.attr_handle;
-            char_add_count++;
-            // 添加舵机控制特征值
-            esp_ble_gatts_add_char(ble_service_handle, &ble_servo_char_uuid,
-                                   ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
-                                   ESP_GATT_CHAR_PROP_BIT_READ |
-                                   ESP_GATT_CHAR_PROP_BIT_WRITE |
-                                   ESP_GATT_CHAR_PROP_BIT_NOTIFY,
-                                   NULL, NULL);
-        } else if (char_add_count == 1) {
-            // 第二个特征值：舵机控制
-            ble_servo_char_handle = param->add_char.attr_handle;
-            char_add_count++;
-            // 添加传感器数据特征值
-            esp_ble_gatts_add_char(ble_service_handle, &ble_sensor_char_uuid,
-                                   ESP_GATT_PERM_READ,
-                                   ESP_GATT_CHAR_PROP_BIT_READ |
-                                   ESP_GATT_CHAR_PROP_BIT_NOTIFY,
-                                   NULL, NULL);
-        } else if (char_add_count == 2) {
-            // 第三个特征值：传感器数据
-            ble_sensor_char_handle = param->add_char.attr_handle;
-            char_add_count++;
-            // 为传感器特征值添加CCCD描述符
-            esp_ble_gatts_add_char_descr(ble_service_handle, &cccd_uuid,
-                                         ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
-                                         NULL, NULL);
-        } else if (char_add_count == 3) {
-            // 第四个特征值：WiFi配置
-            ble_wifi_config_handle = param->add_char.attr_handle;
-            char_add_count++;
-            // 添加MQTT配置特征值
-            esp_ble_gatts_add_char(ble_service_handle, &ble_mqtt_config_uuid,
-                                   ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
-                                   ESP_GATT_CHAR_PROP_BIT_READ |
-                                   ESP_GATT_CHAR_PROP_BIT_WRITE,
-                                   NULL, NULL);
-        } else if (char_add_count == 4) {
-            // 第五个特征值：MQTT配置
-            ble_mqtt_config_handle = param->add_char.attr_handle;
-            ESP_LOGI(TAG, "All char handles - LED:%d, Servo:%d, Sensor:%d, WiFi:%d, MQTT:%d", 
-                     ble_char_handle, ble_servo_char_handle, ble_sensor_char_handle,
-                     ble_wifi_config_handle, ble_mqtt_config_handle);
+    case ESP_GATTS_CONNECT_EVT: {
+        // 建立连接后控制器已停止广播
+        ble_advertising = false;
+        ble_conn_t *conn = find_conn(param->connect.conn_id);
+        for (int i = 0; i < BLE_MAX_CONNECTIONS && !conn; i++) {
+            if (!ble_conns[i].in_use) {
+                conn = &ble_conns[i];
+            }
         }
+        if (!conn) {
+            ESP_LOGW(TAG, "Connection table full, rejecting conn_id=%d", param->connect.conn_id);
+            esp_ble_gap_disconnect(param->connect.remote_bda);
+            break;
+        }
+        
+        portENTER_CRITICAL(&ble_conn_lock);
+        conn->in_use = true;
+        conn->conn_id = param->connect.conn_id;
+        conn->mtu = ESP_GATT_DEF_BLE_MTU_SIZE;
+        conn->cccd = 0;
+        conn->sensor_format = M701_PAYLOAD_JSON;
+        memcpy(conn->bda, param->connect.remote_bda, sizeof(esp_bd_addr_t));
+        conn->status = (ble_conn_status_t) {
+            .profile = BLE_CONN_DEFAULT_PROFILE,
+            .interval = param->connect.conn_params.interval,
+            .latency = param->connect.conn_params.latency,
+            .timeout = param->connect.conn_params.timeout,
+            .tx_phy = 1,
+            .rx_phy = 1,
+        };
+        portEXIT_CRITICAL(&ble_conn_lock);
+        
+        ESP_LOGI(TAG, "Client connected, conn_id=%d (%d/%d)",
+                 conn->conn_id, conn_count(), BLE_MAX_CONNECTIONS);
+        apply_conn_profile(conn);
+        start_advertising();
         break;
+    }
 
-    case ESP_GATTS_ADD_CHAR_DESCR_EVT:
-        ble_sensor_cccd_handle = param->add_char_descr.attr_handle;
-        // 添加WiFi配置特征值
-        esp_ble_gatts_add_char(ble_service_handle, &ble_wifi_config_uuid,
-                               ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
-                               ESP_GATT_CHAR_PROP_BIT_READ |
-                               ESP_GATT_CHAR_PROP_BIT_WRITE,
-                               NULL, NULL);
+    case ESP_GATTS_MTU_EVT: {
+        ble_conn_t *conn = find_conn(param->mtu.conn_id);
+        if (conn) {
+            portENTER_CRITICAL(&ble_conn_lock);
+            conn->mtu = param->mtu.mtu;
+            portEXIT_CRITICAL(&ble_conn_lock);
+        }
+        ESP_LOGI(TAG, "MTU updated to %d, conn_id=%d", param->mtu.mtu, param->mtu.conn_id);
         break;
+    }
 
-    case ESP_GATTS_CONNECT_EVT:
-        ble_conn_id = param->connect.conn_id;
-        ble_connected = true;
-        ESP_LOGI(TAG, "Client connected, conn_id=%d", ble_conn_id);
+    case ESP_GATTS_CONF_EVT:
+        // 通知已交给协议栈但未能发出（链路断开、缓冲不足等）
+        if (param->conf.status != ESP_GATT_OK) {
+            metrics_count(METRICS_COUNTER_BLE_NOTIFY_FAIL);
+            ESP_LOGD(TAG, "Notify conn_id=%d not sent: status=%d", param->conf.conn_id, param->conf.status);
+        }
         break;
 
-    case ESP_GATTS_DISCONNECT_EVT:
-        ble_connected = false;
-        sensor_notify_enabled = false;  // 断开时重置通知状态
-        ESP_LOGI(TAG, "Client disconnected");
-        esp_ble_gap_start_advertising(&adv_params);
+    case ESP_GATTS_DISCONNECT_EVT: {
+        // 断开时清除该连接的通知订阅和格式选择
+        ble_conn_t *conn = find_conn(param->disconnect.conn_id);
+        if (conn) {
+            portENTER_CRITICAL(&ble_conn_lock);
+            conn->in_use = false;
+            portEXIT_CRITICAL(&ble_conn_lock);
+        }
+        ESP_LOGI(TAG, "Client disconnected, conn_id=%d (%d/%d)",
+                 param->disconnect.conn_id, conn_count(), BLE_MAX_CONNECTIONS);
+        start_advertising();
         break;
+    }
 
-    case ESP_GATTS_WRITE_EVT:
-        if (param->write.handle == ble_char_handle) {
+    case ESP_GATTS_WRITE_EVT: {
+        CYCLE_TRACE_SCOPE(CYCLE_TRACE_BLE_WRITE);
+        ble_conn_t *conn = find_conn(param->write.conn_id);
+        if (param->write.handle == ble_handles[IDX_LED_VAL]) {
             // LED控制特征值写入
-            if (parse_led_data_string(param->write.value, param->write.len, g_led_data)) {
-                if (g_led_callback) {
-                    g_led_callback(g_led_data);
+            uint8_t *led_data = s_led_scratch;
+            if (ble_protocol_parse_led_string(param->write.value, param->write.len, led_data, WS2812_LED_COUNT)) {
+                // 与当前状态相同的帧不再回调和回传通知
+                bool changed = memcmp(led_data, g_led_data, WS2812_LED_COUNT) != 0;
+                if (changed) {
+                    memcpy(g_led_data, led_data, WS2812_LED_COUNT);
+                    if (g_led_callback) {
+                        g_led_callback(g_led_data);
+                    }
                 }
                 if (param->write.need_rsp) {
                     esp_ble_gatts_send_response(gatts_if, param->write.conn_id,
                                                 param->write.trans_id, ESP_GATT_OK, NULL);
                 }
-                esp_ble_gatts_send_indicate(gatts_if, param->write.conn_id, ble_char_handle,
-                                            WS2812_LED_COUNT, g_led_data, false);
+                if (changed) {
+                    send_notify(param->write.conn_id, ble_handles[IDX_LED_VAL], WS2812_LED_COUNT, g_led_data);
+                }
             } else {
                 if (param->write.need_rsp) {
                     esp_ble_gatts_send_response(gatts_if, param->write.conn_id,
                                                 param->write.trans_id, ESP_GATT_INVALID_ATTR_LEN, NULL);
                 }
             }
-        } else if (param->write.handle == ble_servo_char_handle) {
+        } else if (param->write.handle == ble_handles[IDX_LED_BIN_VAL]) {
+            // LED二进制控制特征值写入（局部或整帧）
+            uint8_t *led_data = s_led_scratch;
+            memcpy(led_data, g_led_data, WS2812_LED_COUNT);
+            if (ble_protocol_parse_led_binary(param->write.value, param->write.len, led_data, WS2812_LED_COUNT)) {
+                if (memcmp(led_data, g_led_data, WS2812_LED_COUNT) != 0) {
+                    memcpy(g_led_data, led_data, WS2812_LED_COUNT);
+                    if (g_led_callback) {
+                        g_led_callback(g_led_data);
+                    }
+                }
+                if (param->write.need_rsp) {
+                    esp_ble_gatts_send_response(gatts_if, param->write.conn_id,
+                                                param->write.trans_id, ESP_GATT_OK, NULL);
+                }
+            } else {
+                if (param->write.need_rsp) {
+                    esp_ble_gatts_send_response(gatts_if, param->write.conn_id,
+                                                param->write.trans_id, ESP_GATT_INVALID_ATTR_LEN, NULL);
+                }
+                ESP_LOGW(TAG, "Invalid binary LED frame (len=%d)", param->write.len);
+            }
+        } else if (param->write.handle == ble_handles[IDX_SERVO_VAL]) {
             // 舵机控制特征值写入
             float angle;
-            if (parse_servo_data(param->write.value, param->write.len, &angle)) {
+            if (ble_protocol_parse_servo(param->write.value, param->write.len, &angle)) {
                 g_servo_angle = angle;
                 if (g_servo_callback) {
                     g_servo_callback(angle);
@@ -337,8 +653,7 @@ static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_
                 // 发送通知，返回当前角度
                 char angle_str[16];
                 int len = snprintf(angle_str, sizeof(angle_str), "%.1f", g_servo_angle);
-                esp_ble_gatts_send_indicate(gatts_if, param->write.conn_id, ble_servo_char_handle,
-                                            len, (uint8_t*)angle_str, false);
+                send_notify(param->write.conn_id, ble_handles[IDX_SERVO_VAL], len, angle_str);
                 ESP_LOGI(TAG, "Servo angle set to %.1f", angle);
             } else {
                 if (param->write.need_rsp) {
@@ -347,55 +662,95 @@ static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_
                 }
                 ESP_LOGW(TAG, "Invalid servo data");
             }
-        } else if (param->write.handle == ble_sensor_cccd_handle) {
-            // CCCD写入 - 启用/禁用通知
-            if (param->write.len == 2) {
+        } else if (param->write.handle == ble_handles[IDX_SENSOR_VAL]) {
+            // 传感器通知格式选择：0x00/'0' = JSON，0x01/'1' = 二进制
+            esp_gatt_status_t status = ESP_GATT_OK;
+            m701_payload_format_t sensor_format = M701_PAYLOAD_JSON;
+            uint8_t value = param->write.len == 1 ? param->write.value[0] : 0xFF;
+            if (value == 0x00 || value == '0') {
+                sensor_format = M701_PAYLOAD_JSON;
+            } else if (value == 0x01 || value == '1') {
+                sensor_format = M701_PAYLOAD_BINARY;
+            } else {
+                status = ESP_GATT_INVALID_ATTR_LEN;
+            }
+            if (status == ESP_GATT_OK && conn) {
+                portENTER_CRITICAL(&ble_conn_lock);
+                conn->sensor_format = sensor_format;
+                portEXIT_CRITICAL(&ble_conn_lock);
+                ESP_LOGI(TAG, "Sensor format %s, conn_id=%d",
+                         sensor_format == M701_PAYLOAD_BINARY ? "BINARY" : "JSON", conn->conn_id);
+            }
+            if (param->write.need_rsp) {
+                esp_ble_gatts_send_response(gatts_if, param->write.conn_id,
+                                            param->write.trans_id, status, NULL);
+            }
+        } else if (cccd_bit_from_handle(param->write.handle)) {
+            // CCCD写入 - 启用/禁用该连接的通知
+            if (param->write.len == 2 && conn) {
+                uint8_t bit = cccd_bit_from_handle(param->write.handle);
                 uint16_t cccd_value = param->write.value[0] | (param->write.value[1] << 8);
-                sensor_notify_enabled = (cccd_value == 0x0001);
-                ESP_LOGI(TAG, "Sensor notify %s", sensor_notify_enabled ? "ENABLED" : "DISABLED");
+                set_cccd_bit(conn, bit, cccd_value == 0x0001);
+                ESP_LOGI(TAG, "%s notify %s, conn_id=%d",
+                         bit == CCCD_BIT_SENSOR ? "Sensor" : bit == CCCD_BIT_PROV ? "Provisioning" : "Conn status",
+                         cccd_value == 0x0001 ? "ENABLED" : "DISABLED", conn->conn_id);
             }
             if (param->write.need_rsp) {
                 esp_ble_gatts_send_response(gatts_if, param->write.conn_id,
                                             param->write.trans_id, ESP_GATT_OK, NULL);
             }
-        } else if (param->write.handle == ble_wifi_config_handle) {
-            // WiFi配置写入
-            char config_str[256] = {0};
-            int copy_len = (param->write.len < sizeof(config_str) - 1) ? param->write.len : sizeof(config_str) - 1;
-            memcpy(config_str, param->write.value, copy_len);
-            config_str[copy_len] = '\0';
+        } else if (param->write.handle == ble_handles[IDX_CONN_VAL]) {
+            // 连接参数档位切换
+            esp_gatt_status_t status = ESP_GATT_OK;
+            ble_conn_profile_t profile;
+            if (!conn || !ble_protocol_parse_conn_profile(param->write.value, param->write.len, &profile)) {
+                status = ESP_GATT_INVALID_ATTR_LEN;
+            }
+            if (param->write.need_rsp) {
+                esp_ble_gatts_send_response(gatts_if, param->write.conn_id,
+                                            param->write.trans_id, status, NULL);
+            }
+            if (status == ESP_GATT_OK) {
+                portENTER_CRITICAL(&ble_conn_lock);
+                conn->status.profile = profile;
+                portEXIT_CRITICAL(&ble_conn_lock);
+                ESP_LOGI(TAG, "Conn profile %d, conn_id=%d", profile, conn->conn_id);
+                apply_conn_profile(conn);
+            }
+        } else if (param->write.handle == ble_handles[IDX_WIFI_VAL]) {
+            // WiFi配网请求写入，JSON在应用层解析（含密码，不打印内容）
+            int copy_len = copy_write_text(param->write.value, param->write.len);
             
-            ESP_LOGI(TAG, "WiFi config received: %s", config_str);
+            ESP_LOGI(TAG, "WiFi config received (%d bytes)", copy_len);
             
-            // 解析JSON: {"ssid":"xxx","password":"xxx"}
-            char ssid[64] = {0};
-            char password[64] = {0};
+            if (g_wifi_config_callback) {
+                g_wifi_config_callback(s_write_buf);
+            }
             
-            // 简单JSON解析（可以使用cJSON库，这里简化处理）
-            if (sscanf(config_str, "{\"ssid\":\"%63[^\"]\",\"password\":\"%63[^\"]\"}", ssid, password) == 2 ||
-                sscanf(config_str, "{\"ssid\":\"%63[^\"]\"}", ssid) == 1) {
-                if (g_wifi_config_callback) {
-                    g_wifi_config_callback(ssid, password);
-                }
-            } else {
-                ESP_LOGW(TAG, "Invalid WiFi config format");
+            if (param->write.need_rsp) {
+                esp_ble_gatts_send_response(gatts_if, param->write.conn_id,
+                                            param->write.trans_id, ESP_GATT_OK, NULL);
+            }
+        } else if (param->write.handle == ble_handles[IDX_EFFECT_VAL]) {
+            // 灯效控制写入
+            copy_write_text(param->write.value, param->write.len);
+            
+            if (g_effect_callback) {
+                g_effect_callback(s_write_buf);
             }
             
             if (param->write.need_rsp) {
                 esp_ble_gatts_send_response(gatts_if, param->write.conn_id,
                                             param->write.trans_id, ESP_GATT_OK, NULL);
             }
-        } else if (param->write.handle == ble_mqtt_config_handle) {
+        } else if (param->write.handle == ble_handles[IDX_MQTT_VAL]) {
             // MQTT配置写入
-            char config_str[512] = {0};
-            int copy_len = (param->write.len < sizeof(config_str) - 1) ? param->write.len : sizeof(config_str) - 1;
-            memcpy(config_str, param->write.value, copy_len);
-            config_str[copy_len] = '\0';
+            copy_write_text(param->write.value, param->write.len);
             
-            ESP_LOGI(TAG, "MQTT config received: %s", config_str);
+            ESP_LOGI(TAG, "MQTT config received: %s", s_write_buf);
             
             if (g_mqtt_config_callback) {
-                g_mqtt_config_callback(config_str);
+                g_mqtt_config_callback(s_write_buf);
             }
             
             if (param->write.need_rsp) {
@@ -404,21 +759,55 @@ static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_
             }
         }
         break;
+    }
 
     case ESP_GATTS_READ_EVT: {
         esp_gatt_rsp_t rsp = {0};
         rsp.attr_value.handle = param->read.handle;
         
-        if (param->read.handle == ble_char_handle) {
+        if (param->read.handle == ble_handles[IDX_LED_VAL]) {
             // 读取LED数据
             rsp.attr_value.len = WS2812_LED_COUNT;
             memcpy(rsp.attr_value.value, g_led_data, WS2812_LED_COUNT);
-        } else if (param->read.handle == ble_servo_char_handle) {
+        } else if (param->read.handle == ble_handles[IDX_SERVO_VAL]) {
             // 读取舵机角度
             char angle_str[16];
             int len = snprintf(angle_str, sizeof(angle_str), "%.1f", g_servo_angle);
             rsp.attr_value.len = len;
             memcpy(rsp.attr_value.value, angle_str, len);
+        } else if (param->read.handle == ble_handles[IDX_LED_BIN_VAL]) {
+            // 读取LED数据（二进制整帧），超过MTU时由客户端按offset长读取
+            uint8_t frame[BLE_LED_BIN_HEADER_LEN + BLE_LED_BIN_PAYLOAD_LEN(WS2812_LED_COUNT)];
+            uint16_t frame_len = ble_protocol_pack_led_binary(g_led_data, 0, WS2812_LED_COUNT, frame);
+            uint16_t offset = param->read.offset < frame_len ? param->read.offset : frame_len;
+            uint16_t len = frame_len - offset;
+            ble_conn_t *conn = find_conn(param->read.conn_id);
+            uint16_t mtu = conn ? conn->mtu : ESP_GATT_DEF_BLE_MTU_SIZE;
+            if (len > mtu - 1) {
+                len = mtu - 1;
+            }
+            rsp.attr_value.offset = offset;
+            rsp.attr_value.len = len;
+            memcpy(rsp.attr_value.value, frame + offset, len);
+        } else if (param->read.handle == ble_handles[IDX_CONN_VAL]) {
+            // 读取连接参数档位和实际生效的参数
+            ble_conn_t *conn = find_conn(param->read.conn_id);
+            if (conn) {
+                rsp.attr_value.len = ble_protocol_pack_conn_status(&conn->status, rsp.attr_value.value);
+            }
+        } else if (param->read.handle == ble_handles[IDX_STATS_VAL]) {
+            // 读取运行统计，超过MTU时由客户端按offset长读取（后续分段沿用同一份快照）
+            ble_conn_t *conn = find_conn(param->read.conn_id);
+            uint16_t mtu = conn ? conn->mtu : ESP_GATT_DEF_BLE_MTU_SIZE;
+            rsp.attr_value.offset = param->read.offset;
+            rsp.attr_value.len = metrics_read_binary(param->read.offset, rsp.attr_value.value, mtu - 1);
+        } else if (cccd_bit_from_handle(param->read.handle)) {
+            // 读取CCCD：返回该连接的订阅状态
+            ble_conn_t *conn = find_conn(param->read.conn_id);
+            uint8_t bit = cccd_bit_from_handle(param->read.handle);
+            rsp.attr_value.len = 2;
+            rsp.attr_value.value[0] = (conn && (conn->cccd & bit)) ? 0x01 : 0x00;
+            rsp.attr_value.value[1] = 0x00;
         }
         
         esp_ble_gatts_send_response(gatts_if, param->read.conn_id,
@@ -475,7 +864,7 @@ esp_err_t ble_service_init(ble_led_data_callback_t led_callback, ble_servo_callb
     ESP_ERROR_CHECK(esp_ble_gatts_register_callback(gatts_event_handler));
     ESP_ERROR_CHECK(esp_ble_gap_register_callback(gap_event_handler));
     ESP_ERROR_CHECK(esp_ble_gatts_app_register(0));
-    esp_ble_gatt_set_local_mtu(128);
+    esp_ble_gatt_set_local_mtu(BLE_LOCAL_MTU);
 
     ESP_LOGI(TAG, "BLE ready, waiting for connections");
     return ESP_OK;
@@ -489,27 +878,111 @@ uint8_t* ble_service_get_led_data(void)
     return g_led_data;
 }
 
+/**
+ * @brief 是否有连接以指定格式订阅了传感器通知
+ */
+bool ble_service_sensor_subscribed(m701_payload_format_t format)
+{
+    bool subscribed = false;
+    
+    portENTER_CRITICAL(&ble_conn_lock);
+    for (int i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (ble_conns[i].in_use && (ble_conns[i].cccd & CCCD_BIT_SENSOR) &&
+            ble_conns[i].sensor_format == format) {
+            subscribed = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&ble_conn_lock);
+    
+    return subscribed;
+}
+
 /**
  * @brief 发送传感器数据通知
  */
-esp_err_t ble_service_notify_sensor_data(const char *data, uint16_t len)
+esp_err_t ble_service_notify_sensor_data(m701_payload_format_t format, const void *data, uint16_t len)
 {
-    if (!ble_connected || !sensor_notify_enabled) {
+    if (ble_gatts_if == ESP_GATT_IF_NONE || ble_handles[IDX_SENSOR_VAL] == 0) {
         return ESP_FAIL;
     }
     
-    if (ble_gatts_if == ESP_GATT_IF_NONE || ble_sensor_char_handle == 0) {
+    return notify_subscribers(CCCD_BIT_SENSOR, format, ble_handles[IDX_SENSOR_VAL], data, len) > 0 ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * @brief 发送配网状态通知
+ */
+esp_err_t ble_service_notify_prov(const void *data, uint16_t len)
+{
+    if (ble_gatts_if == ESP_GATT_IF_NONE || ble_handles[IDX_PROV_VAL] == 0) {
         return ESP_FAIL;
     }
     
-    esp_err_t ret = esp_ble_gatts_send_indicate(ble_gatts_if, ble_conn_id, 
-                                                 ble_sensor_char_handle,
-                                                 len, (uint8_t*)data, false);
-    if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to send sensor notify: %s", esp_err_to_name(ret));
+    return notify_subscribers(CCCD_BIT_PROV, M701_PAYLOAD_JSON, ble_handles[IDX_PROV_VAL], data, len) > 0 ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * @brief 获取配网通知可用的MTU
+ */
+uint16_t ble_service_get_mtu(void)
+{
+    uint16_t mtu = 0;
+    
+    portENTER_CRITICAL(&ble_conn_lock);
+    for (int i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (ble_conns[i].in_use && (ble_conns[i].cccd & CCCD_BIT_PROV) &&
+            (mtu == 0 || ble_conns[i].mtu < mtu)) {
+            mtu = ble_conns[i].mtu;
+        }
     }
+    portEXIT_CRITICAL(&ble_conn_lock);
     
-    return ret;
+    return mtu ? mtu : ESP_GATT_DEF_BLE_MTU_SIZE;
+}
+
+/**
+ * @brief 设置期望的BLE连接间隔
+ */
+void ble_service_set_conn_params(uint16_t min_interval_ms, uint16_t max_interval_ms)
+{
+    // 连接间隔单位1.25ms，范围 6~3200；监督超时单位10ms，需大于2倍连接间隔
+    uint16_t min_int = min_interval_ms * 4 / 5;
+    uint16_t max_int = max_interval_ms * 4 / 5;
+    if (min_int < 6) {
+        min_int = 6;
+    }
+    if (max_int > 3200) {
+        max_int = 3200;
+    }
+    if (max_int < min_int) {
+        max_int = min_int;
+    }
+    uint32_t timeout_ms = max_interval_ms * 6;
+    if (timeout_ms < 4000) {
+        timeout_ms = 4000;
+    } else if (timeout_ms > 32000) {
+        timeout_ms = 32000;
+    }
+    
+    // 对所有跟随电源管理（AUTO档位）的连接请求新参数
+    esp_bd_addr_t bdas[BLE_MAX_CONNECTIONS];
+    int count = 0;
+    portENTER_CRITICAL(&ble_conn_lock);
+    ble_conn_params.min_int = min_int;
+    ble_conn_params.max_int = max_int;
+    ble_conn_params.latency = 0;
+    ble_conn_params.timeout = timeout_ms / 10;
+    for (int i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (ble_conns[i].in_use && ble_conns[i].status.profile == BLE_CONN_PROFILE_AUTO) {
+            memcpy(bdas[count++], ble_conns[i].bda, sizeof(esp_bd_addr_t));
+        }
+    }
+    portEXIT_CRITICAL(&ble_conn_lock);
+    
+    for (int i = 0; i < count; i++) {
+        request_conn_params(bdas[i]);
+    }
 }
 
 /**
@@ -527,3 +1000,11 @@ void ble_service_set_mqtt_config_callback(ble_mqtt_config_callback_t callback)
 {
     g_mqtt_config_callback = callback;
 }
+
+/**
+ * @brief 设置灯效控制回调
+ */
+void ble_service_set_effect_callback(ble_effect_callback_t callback)
+{
+    g_effect_callback = callback;
+}
@@ -2,13 +2,18 @@
  * BLE服务模块 - 头文件
  * 
  * 功能：提供蓝牙BLE GATT服务，用于接收LED控制数据和舵机角度控制
+ * 
+ * 实现：ble_service.c（Bluedroid）或 ble_service_nimble.c（NimBLE），由 CONFIG_BT_NIMBLE_ENABLED 在编译时选择
  */
 
 #ifndef BLE_SERVICE_H
 #define BLE_SERVICE_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "esp_err.h"
+#include "m701_codec.h"
+#include "ble_protocol.h"
 
 /* BLE配置参数 */
 #define BLE_DEVICE_NAME         "Jasper-C3"
@@ -18,6 +23,14 @@
 #define BLE_SENSOR_CHAR_UUID    0xFF03      // 传感器数据特征值
 #define BLE_WIFI_CONFIG_UUID    0xFF04      // WiFi配置特征值
 #define BLE_MQTT_CONFIG_UUID    0xFF05      // MQTT配置特征值
+#define BLE_LED_BIN_CHAR_UUID   0xFF06      // LED二进制控制特征值
+#define BLE_EFFECT_CHAR_UUID    0xFF07      // 灯效控制特征值
+#define BLE_PROV_CHAR_UUID      0xFF08      // 配网状态特征值（通知，格式见 wifi_prov.h）
+#define BLE_CONN_CHAR_UUID      0xFF09      // 连接参数档位特征值（读写通知，格式见 ble_protocol.h）
+#define BLE_STATS_CHAR_UUID     0xFF0A      // 运行统计特征值（只读，格式见 metrics.h）
+#define BLE_LOCAL_MTU           247         // 本地MTU（由中心设备发起协商）
+#define BLE_MAX_CONNECTIONS     3           // 同时连接数上限（不超过 CONFIG_BT_ACL_CONNECTIONS / CONFIG_BT_NIMBLE_MAX_CONNECTIONS），未满时持续广播
+
  
 /**
  * @brief LED数据接收回调函数类型
@@ -51,26 +64,67 @@ esp_err_t ble_service_init(ble_led_data_callback_t led_callback, ble_servo_callb
  */
 uint8_t* ble_service_get_led_data(void);
 
+/**
+ * @brief 是否有连接以指定格式订阅了传感器通知
+ * 
+ * 客户端向传感器特征值写入 0x01 选择二进制，写入 0x00 恢复JSON；每个连接单独选择，断开后恢复JSON。
+ * 发送前按格式查询，只编码有订阅者的格式
+ * 
+ * @param format 负载格式
+ * @return true=至少一个连接订阅
+ */
+bool ble_service_sensor_subscribed(m701_payload_format_t format);
+
 /**
  * @brief 发送传感器数据通知
  * 
- * 通过BLE向连接的客户端发送传感器数据
+ * 发送给所有订阅了传感器通知且选择该格式的连接
  * 
- * @param data JSON格式的传感器数据字符串
+ * @param format 负载格式
+ * @param data 传感器数据（JSON字符串或二进制）
  * @param len 数据长度
  * @return 
- *     - ESP_OK: 成功
- *     - ESP_FAIL: 失败（未连接等）
+ *     - ESP_OK: 至少发送给一个连接
+ *     - ESP_FAIL: 失败（无订阅者等）
+ */
+esp_err_t ble_service_notify_sensor_data(m701_payload_format_t format, const void *data, uint16_t len);
+
+/**
+ * @brief 发送配网状态通知
+ * 
+ * 发送给所有订阅了配网状态通知的连接
+ * 
+ * @param data 通知数据（不超过 ble_service_get_mtu()-3 字节）
+ * @param len 数据长度
+ * @return 
+ *     - ESP_OK: 至少发送给一个连接
+ *     - ESP_FAIL: 失败（未连接或未订阅等）
+ */
+esp_err_t ble_service_notify_prov(const void *data, uint16_t len);
+
+/**
+ * @brief 获取配网通知可用的MTU
+ * 
+ * @return 订阅了配网状态通知的连接中最小的MTU，无订阅者或未协商时为23
+ */
+uint16_t ble_service_get_mtu(void);
+
+/**
+ * @brief 设置期望的BLE连接间隔
+ * 
+ * 连接建立时向主机请求该参数，已连接时立即对所有连接请求更新；最终参数由主机决定
+ * 
+ * @param min_interval_ms 最小连接间隔(ms, >= 7.5)
+ * @param max_interval_ms 最大连接间隔(ms, <= 4000)
  */
-esp_err_t ble_service_notify_sensor_data(const char *data, uint16_t len);
+void ble_service_set_conn_params(uint16_t min_interval_ms, uint16_t max_interval_ms);
 
 /**
- * @brief WiFi配置回调函数类型
+ * @brief WiFi配网请求回调函数类型
  * 
- * @param ssid WiFi SSID
- * @param password WiFi密码
+ * @param request_json 配网请求JSON字符串（格式见 wifi_prov.h）
  */
-typedef void (*ble_wifi_config_callback_t)(const char *ssid, const char *password);
+typedef void (*ble_wifi_config_callback_t)(const char *request_json);
 
 /**
  * @brief MQTT配置回调函数类型
@@ -79,6 +133,13 @@ typedef void (*ble_wifi_config_callback_t)(const char *ssid, const char *passwor
  */
 typedef void (*ble_mqtt_config_callback_t)(const char *config_json);
 
+/**
+ * @brief 灯效控制回调函数类型
+ * 
+ * @param config_json 灯效参数JSON字符串
+ */
+typedef void (*ble_effect_callback_t)(const char *config_json);
+
 /**
  * @brief 设置WiFi配置回调
  * 
@@ -93,4 +154,11 @@ void ble_service_set_wifi_config_callback(ble_wifi_config_callback_t callback);
  */
 void ble_service_set_mqtt_config_callback(ble_mqtt_config_callback_t callback);
 
+/**
+ * @brief 设置灯效控制回调
+ * 
+ * @param callback 灯效控制回调函数
+ */
+void ble_service_set_effect_callback(ble_effect_callback_t callback);
+
 #endif // BLE_SERVICE_H
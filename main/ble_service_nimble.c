@@ -0,0 +1,909 @@
+/*
+ * BLE服务模块 - NimBLE实现文件
+ * 
+ * 功能：基于NimBLE协议栈实现 ble_service.h 接口（CONFIG_BT_NIMBLE_ENABLED 时编译）
+ * 
+ * 与Bluedroid实现的区别：
+ * - GATT服务用静态属性表一次注册，句柄在主机启动时直接填入，无需逐个等待添加事件
+ * - 带通知属性的特征值由协议栈自动生成CCCD，订阅状态通过 BLE_GAP_EVENT_SUBSCRIBE 获取
+ * - 长读取的offset由协议栈处理，读取回调只需返回完整值
+ */
+
+#include "ble_service.h"
+#include "ws2812_driver.h"
+#include "metrics.h"
+#include "cycle_trace.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "nimble/nimble_port.h"
+#include "nimble/nimble_port_freertos.h"
+#include "host/ble_hs.h"
+#include "host/util/util.h"
+#include "services/gap/ble_svc_gap.h"
+#include "services/gatt/ble_svc_gatt.h"
+#include <string.h>
+#include <stdio.h>
+
+/* 日志标签 */
+static const char* TAG = "BLE_SERVICE";
+
+/* 写入缓冲区：ATT属性值最长512字节，访问回调只在NimBLE主机任务中执行 */
+#define WRITE_BUF_SIZE      (512 + 1)
+
+/* 连接已订阅的通知（CCCD位） */
+#define CCCD_BIT_SENSOR     BIT0
+#define CCCD_BIT_PROV       BIT1
+#define CCCD_BIT_CONN       BIT2
+
+/* DLE最大发送时间(us)：251字节在1M PHY上 (251+14)*8 */
+#define DLE_TX_TIME_US      2120
+
+/**
+ * @brief 单个连接的状态
+ */
+typedef struct {
+    bool in_use;
+    uint16_t conn_id;                       // NimBLE连接句柄
+    uint16_t mtu;                           // 协商后的MTU
+    uint8_t cccd;                           // 已订阅的通知，CCCD_BIT_*
+    m701_payload_format_t sensor_format;    // 传感器通知格式（每个连接单独选择）
+    ble_conn_status_t status;               // 连接参数档位和实际生效的参数
+} ble_conn_t;
+
+/* 全局变量 */
+static uint8_t g_led_data[WS2812_LED_COUNT] = {0};      // 当前LED数据
+static ble_led_data_callback_t g_led_callback = NULL;   // LED数据回调
+static ble_servo_callback_t g_servo_callback = NULL;    // 舵机数据回调
+static float g_servo_angle = 135.0f;                    // 当前舵机角度(默认中立位置)
+static uint16_t ble_char_handle = 0;          // LED特征值句柄
+static uint16_t ble_servo_char_handle = 0;    // 舵机特征值句柄
+static uint16_t ble_sensor_char_handle = 0;   // 传感器特征值句柄
+static uint16_t ble_wifi_config_handle = 0;   // WiFi配置特征值句柄
+static uint16_t ble_mqtt_config_handle = 0;   // MQTT配置特征值句柄
+static uint16_t ble_led_bin_handle = 0;       // LED二进制特征值句柄
+static uint16_t ble_effect_handle = 0;        // 灯效控制特征值句柄
+static uint16_t ble_prov_char_handle = 0;     // 配网状态特征值句柄
+static uint16_t ble_conn_char_handle = 0;     // 连接参数档位特征值句柄
+static uint16_t ble_stats_char_handle = 0;    // 运行统计特征值句柄
+static ble_conn_t ble_conns[BLE_MAX_CONNECTIONS] = {0};  // 连接表（主机任务中修改，其他任务持锁读取）
+static portMUX_TYPE ble_conn_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool ble_synced = false;               // 主机与控制器已同步，可以广播
+static bool ble_advertising = false;          // 广播已启动
+static uint8_t ble_own_addr_type = 0;
+static struct ble_gap_upd_params ble_conn_params = {0};  // 期望的连接参数，itvl_min为0表示不请求（持 ble_conn_lock 访问）
+static uint8_t s_write_buf[WRITE_BUF_SIZE];
+static uint8_t s_led_scratch[WS2812_LED_COUNT];         // LED写入解析结果（只在主机任务中使用）
+static ble_wifi_config_callback_t g_wifi_config_callback = NULL;
+static ble_mqtt_config_callback_t g_mqtt_config_callback = NULL;
+static ble_effect_callback_t g_effect_callback = NULL;
+
+static uint8_t adv_payload[] = {
+    0x02, 0x01, 0x06,
+    0x0A, 0x09, 'J', 'a', 's', 'p', 'e', 'r', '-', 'C', '3',
+    0x03, 0x03, 0xFF, 0x00,
+};
+
+static int gap_event_handler(struct ble_gap_event *event, void *arg);
+
+/**
+ * @brief 按连接句柄查找连接（主机任务中调用）
+ * 
+ * @return 连接状态，未找到返回NULL
+ */
+static ble_conn_t *find_conn(uint16_t conn_id)
+{
+    for (int i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (ble_conns[i].in_use && ble_conns[i].conn_id == conn_id) {
+            return &ble_conns[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 当前连接数（主机任务中调用）
+ */
+static int conn_count(void)
+{
+    int count = 0;
+    for (int i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (ble_conns[i].in_use) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief 连接数未达上限时启动广播
+ * 
+ * 可连接广播在建立连接后由协议栈自动停止，每次连接/断开后都调用一次
+ */
+static void start_advertising(void)
+{
+    if (!ble_synced || ble_advertising || conn_count() >= BLE_MAX_CONNECTIONS) {
+        return;
+    }
+    
+    struct ble_gap_adv_params params = {0};
+    params.conn_mode = BLE_GAP_CONN_MODE_UND;
+    params.disc_mode = BLE_GAP_DISC_MODE_GEN;
+    params.itvl_min = 0x40;   // 40ms
+    params.itvl_max = 0x80;   // 80ms
+    
+    int rc = ble_gap_adv_start(ble_own_addr_type, NULL, BLE_HS_FOREVER, &params, gap_event_handler, NULL);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "Advertising start failed: %d", rc);
+        return;
+    }
+    ble_advertising = true;
+    ESP_LOGI(TAG, "Advertising started");
+}
+
+/**
+ * @brief 设置或清除连接的订阅位（主机任务中调用）
+ */
+static void set_cccd_bit(ble_conn_t *conn, uint8_t bit, bool enable)
+{
+    portENTER_CRITICAL(&ble_conn_lock);
+    if (enable) {
+        conn->cccd |= bit;
+    } else {
+        conn->cccd &= ~bit;
+    }
+    portEXIT_CRITICAL(&ble_conn_lock);
+}
+
+/**
+ * @brief 向主机请求期望的连接参数
+ * 
+ * @param conn_id 连接句柄
+ */
+static void request_conn_params(uint16_t conn_id)
+{
+    portENTER_CRITICAL(&ble_conn_lock);
+    struct ble_gap_upd_params params = ble_conn_params;
+    portEXIT_CRITICAL(&ble_conn_lock);
+    if (params.itvl_min == 0) {
+        return;
+    }
+    
+    int rc = ble_gap_update_params(conn_id, &params);
+    if (rc != 0) {
+        ESP_LOGW(TAG, "Conn params update failed: %d", rc);
+    }
+}
+
+/**
+ * @brief 向指定连接发送通知
+ * 
+ * 协议栈发送失败时由 BLE_GAP_EVENT_NOTIFY_TX 计入运行统计
+ * 
+ * @return 0=成功，其他为NimBLE错误码
+ */
+static int notify_conn(uint16_t conn_id, uint16_t handle, const void *data, uint16_t len)
+{
+    struct os_mbuf *om = ble_hs_mbuf_from_flat(data, len);
+    if (!om) {
+        metrics_count(METRICS_COUNTER_BLE_NOTIFY_FAIL);
+        return BLE_HS_ENOMEM;
+    }
+    // om 由协议栈释放（失败时也是）
+    return ble_gatts_notify_custom(conn_id, handle, om);
+}
+
+/**
+ * @brief 向所有已订阅的连接发送通知
+ * 
+ * 先持锁复制连接句柄再逐个发送，发送期间连接表可被主机任务修改
+ * 
+ * @param cccd_bit 需要的订阅位
+ * @param format 传感器通知格式，仅 CCCD_BIT_SENSOR 时比较
+ * @param handle 特征值句柄
+ * @return 成功发送的连接数
+ */
+static int notify_subscribers(uint8_t cccd_bit, m701_payload_format_t format,
+                              uint16_t handle, const void *data, uint16_t len)
+{
+    uint16_t conn_ids[BLE_MAX_CONNECTIONS];
+    int count = 0;
+    
+    portENTER_CRITICAL(&ble_conn_lock);
+    for (int i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        const ble_conn_t *conn = &ble_conns[i];
+        if (conn->in_use && (conn->cccd & cccd_bit) &&
+            (cccd_bit != CCCD_BIT_SENSOR || conn->sensor_format == format)) {
+            conn_ids[count++] = conn->conn_id;
+        }
+    }
+    portEXIT_CRITICAL(&ble_conn_lock);
+    
+    int sent = 0;
+    for (int i = 0; i < count; i++) {
+        int rc = notify_conn(conn_ids[i], handle, data, len);
+        if (rc == 0) {
+            sent++;
+        } else {
+            ESP_LOGW(TAG, "Notify conn_id=%d failed: %d", conn_ids[i], rc);
+        }
+    }
+    return sent;
+}
+
+/**
+ * @brief 从协议栈读取连接当前的间隔/延迟/超时
+ */
+static void update_conn_status(ble_conn_t *conn)
+{
+    struct ble_gap_conn_desc desc;
+    if (ble_gap_conn_find(conn->conn_id, &desc) == 0) {
+        conn->status.interval = desc.conn_itvl;
+        conn->status.latency = desc.conn_latency;
+        conn->status.timeout = desc.supervision_timeout;
+    }
+}
+
+/**
+ * @brief 应用连接的参数档位
+ * 
+ * 请求连接参数、DLE和PHY，实际生效的参数在GAP更新完成事件中记录并通知
+ */
+static void apply_conn_profile(const ble_conn_t *conn)
+{
+    const ble_conn_profile_params_t *profile = ble_protocol_get_conn_profile(conn->status.profile);
+    if (!profile) {
+        // AUTO：跟随电源管理设置的参数
+        request_conn_params(conn->conn_id);
+        return;
+    }
+    
+    struct ble_gap_upd_params params = {
+        .itvl_min = profile->min_interval,
+        .itvl_max = profile->max_interval,
+        .latency = profile->latency,
+        .supervision_timeout = profile->timeout,
+    };
+    int rc = ble_gap_update_params(conn->conn_id, &params);
+    if (rc != 0) {
+        ESP_LOGW(TAG, "Conn params update failed: %d", rc);
+    }
+    
+    if (profile->tx_octets) {
+        ble_gap_set_data_len(conn->conn_id, profile->tx_octets, DLE_TX_TIME_US);
+    }
+    uint8_t phy_mask = profile->phy_2m ? BLE_GAP_LE_PHY_2M_MASK : BLE_GAP_LE_PHY_1M_MASK;
+    ble_gap_set_prefered_le_phy(conn->conn_id, phy_mask, phy_mask, BLE_GAP_LE_PHY_CODED_ANY);
+}
+
+/**
+ * @brief 向订阅了连接状态的客户端通知当前参数
+ */
+static void notify_conn_status(const ble_conn_t *conn)
+{
+    if (!(conn->cccd & CCCD_BIT_CONN)) {
+        return;
+    }
+    
+    uint8_t buf[BLE_CONN_STATUS_LEN];
+    uint16_t len = ble_protocol_pack_conn_status(&conn->status, buf);
+    notify_conn(conn->conn_id, ble_conn_char_handle, buf, len);
+}
+
+/**
+ * @brief 特征值读取
+ */
+static int gatt_read(uint16_t conn_id, uint16_t attr_handle, struct os_mbuf *om)
+{
+    int rc = 0;
+    
+    if (attr_handle == ble_char_handle) {
+        // 读取LED数据
+        rc = os_mbuf_append(om, g_led_data, WS2812_LED_COUNT);
+    } else if (attr_handle == ble_servo_char_handle) {
+        // 读取舵机角度
+        char angle_str[16];
+        int len = snprintf(angle_str, sizeof(angle_str), "%.1f", g_servo_angle);
+        rc = os_mbuf_append(om, angle_str, len);
+    } else if (attr_handle == ble_led_bin_handle) {
+        // 读取LED数据（二进制整帧），超过MTU时协议栈按offset长读取
+        uint8_t frame[BLE_LED_BIN_HEADER_LEN + BLE_LED_BIN_PAYLOAD_LEN(WS2812_LED_COUNT)];
+        uint16_t frame_len = ble_protocol_pack_led_binary(g_led_data, 0, WS2812_LED_COUNT, frame);
+        rc = os_mbuf_append(om, frame, frame_len);
+    } else if (attr_handle == ble_conn_char_handle) {
+        // 读取连接参数档位和实际生效的参数
+        ble_conn_t *conn = find_conn(conn_id);
+        if (conn) {
+            uint8_t buf[BLE_CONN_STATUS_LEN];
+            uint16_t len = ble_protocol_pack_conn_status(&conn->status, buf);
+            rc = os_mbuf_append(om, buf, len);
+        }
+    } else if (attr_handle == ble_stats_char_handle) {
+        // 读取运行统计：协议栈按offset长读取时会多次回调，快照缓存保证各分段一致
+        static uint8_t stats[METRICS_BIN_MAX_LEN];
+        uint16_t len = metrics_read_binary(0, stats, sizeof(stats));
+        rc = os_mbuf_append(om, stats, len);
+    }
+    
+    return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+/**
+ * @brief 特征值写入
+ * 
+ * 写入数据已复制到 s_write_buf 并以'\0'结尾
+ */
+static int gatt_write(uint16_t conn_id, uint16_t attr_handle, uint16_t len)
+{
+    ble_conn_t *conn = find_conn(conn_id);
+    
+    if (attr_handle == ble_char_handle) {
+        // LED控制特征值写入
+        uint8_t *led_data = s_led_scratch;
+        if (!ble_protocol_parse_led_string(s_write_buf, len, led_data, WS2812_LED_COUNT)) {
+            return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        // 与当前状态相同的帧不再回调和回传通知
+        if (memcmp(led_data, g_led_data, WS2812_LED_COUNT) != 0) {
+            memcpy(g_led_data, led_data, WS2812_LED_COUNT);
+            if (g_led_callback) {
+                g_led_callback(g_led_data);
+            }
+            notify_conn(conn_id, ble_char_handle, g_led_data, WS2812_LED_COUNT);
+        }
+    } else if (attr_handle == ble_led_bin_handle) {
+        // LED二进制控制特征值写入（局部或整帧）
+        uint8_t *led_data = s_led_scratch;
+        memcpy(led_data, g_led_data, WS2812_LED_COUNT);
+        if (!ble_protocol_parse_led_binary(s_write_buf, len, led_data, WS2812_LED_COUNT)) {
+            ESP_LOGW(TAG, "Invalid binary LED frame (len=%d)", len);
+            return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        if (memcmp(led_data, g_led_data, WS2812_LED_COUNT) != 0) {
+            memcpy(g_led_data, led_data, WS2812_LED_COUNT);
+            if (g_led_callback) {
+                g_led_callback(g_led_data);
+            }
+        }
+    } else if (attr_handle == ble_servo_char_handle) {
+        // 舵机控制特征值写入
+        float angle;
+        if (!ble_protocol_parse_servo(s_write_buf, len, &angle)) {
+            ESP_LOGW(TAG, "Invalid servo data");
+            return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        g_servo_angle = angle;
+        if (g_servo_callback) {
+            g_servo_callback(angle);
+        }
+        // 发送通知，返回当前角度
+        char angle_str[16];
+        int str_len = snprintf(angle_str, sizeof(angle_str), "%.1f", g_servo_angle);
+        notify_conn(conn_id, ble_servo_char_handle, angle_str, str_len);
+        ESP_LOGI(TAG, "Servo angle set to %.1f", angle);
+    } else if (attr_handle == ble_sensor_char_handle) {
+        // 传感器通知格式选择：0x00/'0' = JSON，0x01/'1' = 二进制
+        m701_payload_format_t sensor_format;
+        uint8_t value = len == 1 ? s_write_buf[0] : 0xFF;
+        if (value == 0x00 || value == '0') {
+            sensor_format = M701_PAYLOAD_JSON;
+        } else if (value == 0x01 || value == '1') {
+            sensor_format = M701_PAYLOAD_BINARY;
+        } else {
+            return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        if (conn) {
+            portENTER_CRITICAL(&ble_conn_lock);
+            conn->sensor_format = sensor_format;
+            portEXIT_CRITICAL(&ble_conn_lock);
+            ESP_LOGI(TAG, "Sensor format %s, conn_id=%d",
+                     sensor_format == M701_PAYLOAD_BINARY ? "BINARY" : "JSON", conn_id);
+        }
+    } else if (attr_handle == ble_conn_char_handle) {
+        // 连接参数档位切换
+        ble_conn_profile_t profile;
+        if (!conn || !ble_protocol_parse_conn_profile(s_write_buf, len, &profile)) {
+            return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        portENTER_CRITICAL(&ble_conn_lock);
+        conn->status.profile = profile;
+        portEXIT_CRITICAL(&ble_conn_lock);
+        ESP_LOGI(TAG, "Conn profile %d, conn_id=%d", profile, conn_id);
+        apply_conn_profile(conn);
+    } else if (attr_handle == ble_wifi_config_handle) {
+        // WiFi配网请求写入，JSON在应用层解析（含密码，不打印内容）
+        ESP_LOGI(TAG, "WiFi config received (%d bytes)", len);
+        if (g_wifi_config_callback) {
+            g_wifi_config_callback((const char *)s_write_buf);
+        }
+    } else if (attr_handle == ble_effect_handle) {
+        // 灯效控制写入
+        if (g_effect_callback) {
+            g_effect_callback((const char *)s_write_buf);
+        }
+    } else if (attr_handle == ble_mqtt_config_handle) {
+        // MQTT配置写入
+        ESP_LOGI(TAG, "MQTT config received: %s", (const char *)s_write_buf);
+        if (g_mqtt_config_callback) {
+            g_mqtt_config_callback((const char *)s_write_buf);
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief GATT访问回调（所有特征值共用）
+ */
+static int gatt_access_cb(uint16_t conn_handle, uint16_t attr_handle,
+                          struct ble_gatt_access_ctxt *ctxt, void *arg)
+{
+    switch (ctxt->op) {
+    case BLE_GATT_ACCESS_OP_READ_CHR:
+        return gatt_read(conn_handle, attr_handle, ctxt->om);
+    
+    case BLE_GATT_ACCESS_OP_WRITE_CHR: {
+        CYCLE_TRACE_SCOPE(CYCLE_TRACE_BLE_WRITE);
+        uint16_t len = 0;
+        if (ble_hs_mbuf_to_flat(ctxt->om, s_write_buf, WRITE_BUF_SIZE - 1, &len) != 0) {
+            return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        s_write_buf[len] = '\0';
+        return gatt_write(conn_handle, attr_handle, len);
+    }
+    
+    default:
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+}
+
+/* GATT服务属性表：注册时一次性生成全部特征值和CCCD，句柄写入 val_handle */
+static const struct ble_gatt_svc_def gatt_svcs[] = {
+    {
+        .type = BLE_GATT_SVC_TYPE_PRIMARY,
+        .uuid = BLE_UUID16_DECLARE(BLE_SERVICE_UUID),
+        .characteristics = (struct ble_gatt_chr_def[]) {
+            {
+                // LED控制
+                .uuid = BLE_UUID16_DECLARE(BLE_CHAR_UUID),
+                .access_cb = gatt_access_cb,
+                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_NOTIFY,
+                .val_handle = &ble_char_handle,
+            },
+            {
+                // 舵机控制
+                .uuid = BLE_UUID16_DECLARE(BLE_SERVO_CHAR_UUID),
+                .access_cb = gatt_access_cb,
+                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_NOTIFY,
+                .val_handle = &ble_servo_char_handle,
+            },
+            {
+                // 传感器数据
+                .uuid = BLE_UUID16_DECLARE(BLE_SENSOR_CHAR_UUID),
+                .access_cb = gatt_access_cb,
+                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_NOTIFY,
+                .val_handle = &ble_sensor_char_handle,
+            },
+            {
+                // WiFi配置
+                .uuid = BLE_UUID16_DECLARE(BLE_WIFI_CONFIG_UUID),
+                .access_cb = gatt_access_cb,
+                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+                .val_handle = &ble_wifi_config_handle,
+            },
+            {
+                // MQTT配置
+                .uuid = BLE_UUID16_DECLARE(BLE_MQTT_CONFIG_UUID),
+                .access_cb = gatt_access_cb,
+                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+                .val_handle = &ble_mqtt_config_handle,
+            },
+            {
+                // LED二进制控制（支持无响应写入）
+                .uuid = BLE_UUID16_DECLARE(BLE_LED_BIN_CHAR_UUID),
+                .access_cb = gatt_access_cb,
+                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_NO_RSP,
+                .val_handle = &ble_led_bin_handle,
+            },
+            {
+                // 灯效控制
+                .uuid = BLE_UUID16_DECLARE(BLE_EFFECT_CHAR_UUID),
+                .access_cb = gatt_access_cb,
+                .flags = BLE_GATT_CHR_F_WRITE,
+                .val_handle = &ble_effect_handle,
+            },
+            {
+                // 配网状态（仅通知）
+                .uuid = BLE_UUID16_DECLARE(BLE_PROV_CHAR_UUID),
+                .access_cb = gatt_access_cb,
+                .flags = BLE_GATT_CHR_F_NOTIFY,
+                .val_handle = &ble_prov_char_handle,
+            },
+            {
+                // 连接参数档位
+                .uuid = BLE_UUID16_DECLARE(BLE_CONN_CHAR_UUID),
+                .access_cb = gatt_access_cb,
+                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_NOTIFY,
+                .val_handle = &ble_conn_char_handle,
+            },
+            {
+                // 运行统计（只读）
+                .uuid = BLE_UUID16_DECLARE(BLE_STATS_CHAR_UUID),
+                .access_cb = gatt_access_cb,
+                .flags = BLE_GATT_CHR_F_READ,
+                .val_handle = &ble_stats_char_handle,
+            },
+            {
+                0,  // 结束标记
+            },
+        },
+    },
+    {
+        0,  // 结束标记
+    },
+};
+
+/**
+ * @brief GAP事件处理函数
+ */
+static int gap_event_handler(struct ble_gap_event *event, void *arg)
+{
+    switch (event->type) {
+    case BLE_GAP_EVENT_CONNECT: {
+        // 建立连接（或失败）后广播已停止
+        ble_advertising = false;
+        if (event->connect.status != 0) {
+            ESP_LOGW(TAG, "Connection failed: %d", event->connect.status);
+            start_advertising();
+            break;
+        }
+        
+        uint16_t conn_id = event->connect.conn_handle;
+        ble_conn_t *conn = find_conn(conn_id);
+        for (int i = 0; i < BLE_MAX_CONNECTIONS && !conn; i++) {
+            if (!ble_conns[i].in_use) {
+                conn = &ble_conns[i];
+            }
+        }
+        if (!conn) {
+            ESP_LOGW(TAG, "Connection table full, rejecting conn_id=%d", conn_id);
+            ble_gap_terminate(conn_id, BLE_ERR_REM_USER_CONN_TERM);
+            break;
+        }
+        
+        portENTER_CRITICAL(&ble_conn_lock);
+        conn->in_use = true;
+        conn->conn_id = conn_id;
+        conn->mtu = BLE_ATT_MTU_DFLT;
+        conn->cccd = 0;
+        conn->sensor_format = M701_PAYLOAD_JSON;
+        conn->status = (ble_conn_status_t) {
+            .profile = BLE_CONN_DEFAULT_PROFILE,
+            .tx_phy = 1,
+            .rx_phy = 1,
+        };
+        portEXIT_CRITICAL(&ble_conn_lock);
+        update_conn_status(conn);
+        
+        ESP_LOGI(TAG, "Client connected, conn_id=%d (%d/%d)",
+                 conn_id, conn_count(), BLE_MAX_CONNECTIONS);
+        apply_conn_profile(conn);
+        start_advertising();
+        break;
+    }
+    
+    case BLE_GAP_EVENT_DISCONNECT: {
+        // 断开时清除该连接的通知订阅和格式选择
+        uint16_t conn_id = event->disconnect.conn.conn_handle;
+        ble_conn_t *conn = find_conn(conn_id);
+        if (conn) {
+            portENTER_CRITICAL(&ble_conn_lock);
+            conn->in_use = false;
+            portEXIT_CRITICAL(&ble_conn_lock);
+        }
+        ESP_LOGI(TAG, "Client disconnected, conn_id=%d, reason=0x%x (%d/%d)",
+                 conn_id, event->disconnect.reason, conn_count(), BLE_MAX_CONNECTIONS);
+        start_advertising();
+        break;
+    }
+    
+    case BLE_GAP_EVENT_ADV_COMPLETE:
+        ble_advertising = false;
+        ESP_LOGW(TAG, "Advertising stopped, restarting");
+        start_advertising();
+        break;
+    
+    case BLE_GAP_EVENT_MTU: {
+        ble_conn_t *conn = find_conn(event->mtu.conn_handle);
+        if (conn) {
+            portENTER_CRITICAL(&ble_conn_lock);
+            conn->mtu = event->mtu.value;
+            portEXIT_CRITICAL(&ble_conn_lock);
+        }
+        ESP_LOGI(TAG, "MTU updated to %d, conn_id=%d", event->mtu.value, event->mtu.conn_handle);
+        break;
+    }
+    
+    case BLE_GAP_EVENT_NOTIFY_TX:
+        // 通知未能发出（链路断开、缓冲不足等）
+        if (!event->notify_tx.indication && event->notify_tx.status != 0) {
+            metrics_count(METRICS_COUNTER_BLE_NOTIFY_FAIL);
+        }
+        break;
+    
+    case BLE_GAP_EVENT_SUBSCRIBE: {
+        // CCCD写入 - 启用/禁用通知
+        ble_conn_t *conn = find_conn(event->subscribe.conn_handle);
+        if (!conn) {
+            break;
+        }
+        if (event->subscribe.attr_handle == ble_sensor_char_handle) {
+            set_cccd_bit(conn, CCCD_BIT_SENSOR, event->subscribe.cur_notify);
+            ESP_LOGI(TAG, "Sensor notify %s, conn_id=%d",
+                     event->subscribe.cur_notify ? "ENABLED" : "DISABLED", conn->conn_id);
+        } else if (event->subscribe.attr_handle == ble_prov_char_handle) {
+            set_cccd_bit(conn, CCCD_BIT_PROV, event->subscribe.cur_notify);
+            ESP_LOGI(TAG, "Provisioning notify %s, conn_id=%d",
+                     event->subscribe.cur_notify ? "ENABLED" : "DISABLED", conn->conn_id);
+        } else if (event->subscribe.attr_handle == ble_conn_char_handle) {
+            set_cccd_bit(conn, CCCD_BIT_CONN, event->subscribe.cur_notify);
+            ESP_LOGI(TAG, "Conn status notify %s, conn_id=%d",
+                     event->subscribe.cur_notify ? "ENABLED" : "DISABLED", conn->conn_id);
+        }
+        break;
+    }
+    
+    case BLE_GAP_EVENT_CONN_UPDATE: {
+        ble_conn_t *conn = find_conn(event->conn_update.conn_handle);
+        if (!conn) {
+            break;
+        }
+        update_conn_status(conn);
+        ESP_LOGI(TAG, "Conn params updated: status=%d, interval=%d, latency=%d, timeout=%d",
+                 event->conn_update.status, conn->status.interval,
+                 conn->status.latency, conn->status.timeout);
+        notify_conn_status(conn);
+        break;
+    }
+    
+    case BLE_GAP_EVENT_PHY_UPDATE_COMPLETE: {
+        ESP_LOGI(TAG, "PHY updated: status=%d, tx=%d, rx=%d",
+                 event->phy_updated.status, event->phy_updated.tx_phy, event->phy_updated.rx_phy);
+        ble_conn_t *conn = find_conn(event->phy_updated.conn_handle);
+        if (conn && event->phy_updated.status == 0) {
+            conn->status.tx_phy = event->phy_updated.tx_phy;
+            conn->status.rx_phy = event->phy_updated.rx_phy;
+            notify_conn_status(conn);
+        }
+        break;
+    }
+    
+    default:
+        break;
+    }
+    return 0;
+}
+
+/**
+ * @brief 主机与控制器同步完成：确定地址类型，配置广播数据并开始广播
+ */
+static void on_sync(void)
+{
+    int rc = ble_hs_util_ensure_addr(0);
+    if (rc == 0) {
+        rc = ble_hs_id_infer_auto(0, &ble_own_addr_type);
+    }
+    if (rc != 0) {
+        ESP_LOGE(TAG, "Failed to determine address type: %d", rc);
+        return;
+    }
+    
+    ble_gap_adv_set_data(adv_payload, sizeof(adv_payload));
+    ble_gap_adv_rsp_set_data(adv_payload, sizeof(adv_payload));
+    
+    ESP_LOGI(TAG, "All char handles - LED:%d, Servo:%d, Sensor:%d, WiFi:%d, MQTT:%d, LED-BIN:%d, Effect:%d, Prov:%d, Conn:%d, Stats:%d",
+             ble_char_handle, ble_servo_char_handle, ble_sensor_char_handle,
+             ble_wifi_config_handle, ble_mqtt_config_handle, ble_led_bin_handle,
+             ble_effect_handle, ble_prov_char_handle, ble_conn_char_handle, ble_stats_char_handle);
+    
+    ble_synced = true;
+    start_advertising();
+}
+
+/**
+ * @brief 主机复位（控制器异常），重新同步后 on_sync 再次开始广播
+ */
+static void on_reset(int reason)
+{
+    ESP_LOGE(TAG, "NimBLE host reset, reason=%d", reason);
+    ble_synced = false;
+    ble_advertising = false;
+}
+
+/**
+ * @brief NimBLE主机任务
+ */
+static void ble_host_task(void *param)
+{
+    // 返回前一直处理主机事件
+    nimble_port_run();
+    nimble_port_freertos_deinit();
+}
+
+/**
+ * @brief 初始化BLE服务
+ */
+esp_err_t ble_service_init(ble_led_data_callback_t led_callback, ble_servo_callback_t servo_callback)
+{
+    // 保存回调函数
+    g_led_callback = led_callback;
+    g_servo_callback = servo_callback;
+    
+    // 初始化控制器和NimBLE主机
+    esp_err_t ret = nimble_port_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "init nimble failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    ble_hs_cfg.sync_cb = on_sync;
+    ble_hs_cfg.reset_cb = on_reset;
+    
+    ble_svc_gap_init();
+    ble_svc_gatt_init();
+    
+    int rc = ble_gatts_count_cfg(gatt_svcs);
+    if (rc == 0) {
+        rc = ble_gatts_add_svcs(gatt_svcs);
+    }
+    if (rc != 0) {
+        ESP_LOGE(TAG, "GATT service registration failed: %d", rc);
+        return ESP_FAIL;
+    }
+    
+    ble_svc_gap_device_name_set(BLE_DEVICE_NAME);
+    ble_att_set_preferred_mtu(BLE_LOCAL_MTU);
+    
+    nimble_port_freertos_init(ble_host_task);
+    
+    ESP_LOGI(TAG, "BLE ready (NimBLE), waiting for connections");
+    return ESP_OK;
+}
+
+/**
+ * @brief 获取当前LED数据
+ */
+uint8_t* ble_service_get_led_data(void)
+{
+    return g_led_data;
+}
+
+/**
+ * @brief 是否有连接以指定格式订阅了传感器通知
+ */
+bool ble_service_sensor_subscribed(m701_payload_format_t format)
+{
+    bool subscribed = false;
+    
+    portENTER_CRITICAL(&ble_conn_lock);
+    for (int i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (ble_conns[i].in_use && (ble_conns[i].cccd & CCCD_BIT_SENSOR) &&
+            ble_conns[i].sensor_format == format) {
+            subscribed = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&ble_conn_lock);
+    
+    return subscribed;
+}
+
+/**
+ * @brief 发送传感器数据通知
+ */
+esp_err_t ble_service_notify_sensor_data(m701_payload_format_t format, const void *data, uint16_t len)
+{
+    if (ble_sensor_char_handle == 0) {
+        return ESP_FAIL;
+    }
+    
+    return notify_subscribers(CCCD_BIT_SENSOR, format, ble_sensor_char_handle, data, len) > 0 ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * @brief 发送配网状态通知
+ */
+esp_err_t ble_service_notify_prov(const void *data, uint16_t len)
+{
+    if (ble_prov_char_handle == 0) {
+        return ESP_FAIL;
+    }
+    
+    return notify_subscribers(CCCD_BIT_PROV, M701_PAYLOAD_JSON, ble_prov_char_handle, data, len) > 0 ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * @brief 获取配网通知可用的MTU
+ */
+uint16_t ble_service_get_mtu(void)
+{
+    uint16_t mtu = 0;
+    
+    portENTER_CRITICAL(&ble_conn_lock);
+    for (int i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (ble_conns[i].in_use && (ble_conns[i].cccd & CCCD_BIT_PROV) &&
+            (mtu == 0 || ble_conns[i].mtu < mtu)) {
+            mtu = ble_conns[i].mtu;
+        }
+    }
+    portEXIT_CRITICAL(&ble_conn_lock);
+    
+    return mtu ? mtu : BLE_ATT_MTU_DFLT;
+}
+
+/**
+ * @brief 设置期望的BLE连接间隔
+ */
+void ble_service_set_conn_params(uint16_t min_interval_ms, uint16_t max_interval_ms)
+{
+    // 连接间隔单位1.25ms，范围 6~3200；监督超时单位10ms，需大于2倍连接间隔
+    uint16_t min_int = min_interval_ms * 4 / 5;
+    uint16_t max_int = max_interval_ms * 4 / 5;
+    if (min_int < 6) {
+        min_int = 6;
+    }
+    if (max_int > 3200) {
+        max_int = 3200;
+    }
+    if (max_int < min_int) {
+        max_int = min_int;
+    }
+    uint32_t timeout_ms = max_interval_ms * 6;
+    if (timeout_ms < 4000) {
+        timeout_ms = 4000;
+    } else if (timeout_ms > 32000) {
+        timeout_ms = 32000;
+    }
+    
+    // 对所有跟随电源管理（AUTO档位）的连接请求新参数
+    uint16_t conn_ids[BLE_MAX_CONNECTIONS];
+    int count = 0;
+    portENTER_CRITICAL(&ble_conn_lock);
+    ble_conn_params.itvl_min = min_int;
+    ble_conn_params.itvl_max = max_int;
+    ble_conn_params.latency = 0;
+    ble_conn_params.supervision_timeout = timeout_ms / 10;
+    for (int i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (ble_conns[i].in_use && ble_conns[i].status.profile == BLE_CONN_PROFILE_AUTO) {
+            conn_ids[count++] = ble_conns[i].conn_id;
+        }
+    }
+    portEXIT_CRITICAL(&ble_conn_lock);
+    
+    for (int i = 0; i < count; i++) {
+        request_conn_params(conn_ids[i]);
+    }
+}
+
+/**
+ * @brief 设置WiFi配置回调
+ */
+void ble_service_set_wifi_config_callback(ble_wifi_config_callback_t callback)
+{
+    g_wifi_config_callback = callback;
+}
+
+/**
+ * @brief 设置MQTT配置回调
+ */
+void ble_service_set_mqtt_config_callback(ble_mqtt_config_callback_t callback)
+{
+    g_mqtt_config_callback = callback;
+}
+
+/**
+ * @brief 设置灯效控制回调
+ */
+void ble_service_set_effect_callback(ble_effect_callback_t callback)
+{
+    g_effect_callback = callback;
+}
@@ -0,0 +1,175 @@
+/*
+ * 热点路径周期计数 - 实现文件
+ * 
+ * 累计值用临界区保护（计时位置分布在BLE、MQTT、传感器总线等多个任务中）；
+ * 控制台使用 esp_console 的REPL，跟随 sdkconfig 选择的控制台（UART或USB Serial/JTAG）
+ */
+
+#include "cycle_trace.h"
+
+#if CYCLE_TRACE_ENABLED
+
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_cpu.h"
+#include "esp_console.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+#include <string.h>
+#include <stdio.h>
+#if CONFIG_APPTRACE_SV_ENABLE
+#include "SEGGER_SYSVIEW.h"
+#endif
+
+/* 日志标签 */
+static const char* TAG = "TRACE";
+
+/**
+ * @brief 周期累计值
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} cycle_acc_t;
+
+/* 输出中的名称，与枚举顺序一致 */
+static const char *s_site_names[CYCLE_TRACE_SITE_MAX] = {
+    [CYCLE_TRACE_BLE_WRITE] = "ble_write",
+    [CYCLE_TRACE_LED_SUBMIT] = "led_submit",
+    [CYCLE_TRACE_SENSOR_FRAME] = "sensor_frame",
+    [CYCLE_TRACE_MQTT_DATA] = "mqtt_data",
+};
+
+/* 全局变量 */
+static cycle_acc_t s_acc[CYCLE_TRACE_SITE_MAX];
+static portMUX_TYPE s_acc_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief 开始计时
+ */
+cycle_trace_scope_t cycle_trace_begin(cycle_trace_site_t site)
+{
+#if CONFIG_APPTRACE_SV_ENABLE
+    SEGGER_SYSVIEW_OnUserStart(site);
+#endif
+    cycle_trace_scope_t scope = {
+        .site = site,
+        .start = esp_cpu_get_cycle_count(),
+    };
+    return scope;
+}
+
+/**
+ * @brief 结束计时并累计
+ */
+void cycle_trace_end(cycle_trace_scope_t *scope)
+{
+    uint32_t cycles = esp_cpu_get_cycle_count() - scope->start;     // 无符号差值，计数器回绕也正确
+#if CONFIG_APPTRACE_SV_ENABLE
+    SEGGER_SYSVIEW_OnUserStop(scope->site);
+#endif
+    if (scope->site >= CYCLE_TRACE_SITE_MAX) {
+        return;
+    }
+    
+    portENTER_CRITICAL(&s_acc_lock);
+    cycle_acc_t *acc = &s_acc[scope->site];
+    if (acc->count == 0 || cycles < acc->min) {
+        acc->min = cycles;
+    }
+    if (cycles > acc->max) {
+        acc->max = cycles;
+    }
+    acc->count++;
+    acc->sum += cycles;
+    portEXIT_CRITICAL(&s_acc_lock);
+}
+
+/**
+ * @brief 清零统计
+ */
+void cycle_trace_reset(void)
+{
+    portENTER_CRITICAL(&s_acc_lock);
+    memset(s_acc, 0, sizeof(s_acc));
+    portEXIT_CRITICAL(&s_acc_lock);
+}
+
+/**
+ * @brief 向标准输出打印各位置的统计
+ */
+void cycle_trace_dump(void)
+{
+    cycle_acc_t acc[CYCLE_TRACE_SITE_MAX];
+    portENTER_CRITICAL(&s_acc_lock);
+    memcpy(acc, s_acc, sizeof(acc));
+    portEXIT_CRITICAL(&s_acc_lock);
+    
+    uint32_t ticks_per_us = esp_rom_get_cpu_ticks_per_us();
+    if (ticks_per_us == 0) {
+        ticks_per_us = 1;
+    }
+    
+    printf("%-14s %10s %10s %10s %10s %10s\n", "site", "count", "min", "avg", "max", "avg_us");
+    for (int i = 0; i < CYCLE_TRACE_SITE_MAX; i++) {
+        uint32_t avg = acc[i].count ? (uint32_t)(acc[i].sum / acc[i].count) : 0;
+        printf("%-14s %10lu %10lu %10lu %10lu %10lu\n", s_site_names[i],
+               (unsigned long)acc[i].count, (unsigned long)acc[i].min, (unsigned long)avg,
+               (unsigned long)acc[i].max, (unsigned long)(avg / ticks_per_us));
+    }
+    printf("cpu %lu MHz\n", (unsigned long)ticks_per_us);
+}
+
+/**
+ * @brief 控制台命令：trace [reset]
+ */
+static int trace_cmd(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        cycle_trace_reset();
+        printf("cycle trace reset\n");
+        return 0;
+    }
+    if (argc > 1) {
+        printf("usage: trace [reset]\n");
+        return 1;
+    }
+    
+    cycle_trace_dump();
+    return 0;
+}
+
+/**
+ * @brief 初始化周期计数并启动串口控制台
+ */
+esp_err_t cycle_trace_init(void)
+{
+    esp_console_repl_t *repl = NULL;
+    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    repl_config.prompt = CYCLE_TRACE_CONSOLE_PROMPT;
+
+#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+    esp_console_dev_usb_serial_jtag_config_t dev_config = ESP_CONSOLE_DEV_USB_SERIAL_JTAG_CONFIG_DEFAULT();
+    ESP_RETURN_ON_ERROR(esp_console_new_repl_usb_serial_jtag(&dev_config, &repl_config, &repl), TAG, "create console failed");
+#else
+    esp_console_dev_uart_config_t dev_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    ESP_RETURN_ON_ERROR(esp_console_new_repl_uart(&dev_config, &repl_config, &repl), TAG, "create console failed");
+#endif
+
+    const esp_console_cmd_t cmd = {
+        .command = "trace",
+        .help = "Dump per-site CPU cycle statistics, 'trace reset' clears them",
+        .hint = "[reset]",
+        .func = trace_cmd,
+    };
+    ESP_RETURN_ON_ERROR(esp_console_cmd_register(&cmd), TAG, "register command failed");
+    ESP_RETURN_ON_ERROR(esp_console_start_repl(repl), TAG, "start console failed");
+    
+    ESP_LOGI(TAG, "Cycle trace enabled, %d sites, type 'trace' on the console", CYCLE_TRACE_SITE_MAX);
+    return ESP_OK;
+}
+
+#endif // CYCLE_TRACE_ENABLED
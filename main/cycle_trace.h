@@ -0,0 +1,97 @@
+/*
+ * 热点路径周期计数 - 头文件
+ * 
+ * 功能：在真机上（BLE+Wi-Fi共存）测量热点路径的CPU周期数
+ * - 作用域计时：CYCLE_TRACE_SCOPE(site) 从声明处计到所在代码块结束（含提前return）
+ * - 每个位置统计 次数/最小/最大/平均 周期
+ * - 启用 CONFIG_APPTRACE_SV_ENABLE 时同时输出 SystemView 用户事件（OnUserStart/OnUserStop，ID为 cycle_trace_site_t）
+ * - 串口控制台命令 `trace` 输出统计，`trace reset` 清零
+ * 
+ * 编译时开关：CYCLE_TRACE_ENABLED 为0（默认）时所有宏展开为空，不占用任何代码和RAM。
+ * 可在此处改为1，或通过编译选项 -DCYCLE_TRACE_ENABLED=1 开启
+ * 
+ * 周期数包含作用域内的阻塞等待；读数按当前CPU频率计，低功耗模式下会随DFS变化
+ */
+
+#ifndef CYCLE_TRACE_H
+#define CYCLE_TRACE_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/* 配置参数 */
+#ifndef CYCLE_TRACE_ENABLED
+#define CYCLE_TRACE_ENABLED         0           // 1=编译周期计数和控制台命令
+#endif
+#define CYCLE_TRACE_CONSOLE_PROMPT  "jasper> "  // 控制台提示符
+
+/**
+ * @brief 计时位置
+ */
+typedef enum {
+    CYCLE_TRACE_BLE_WRITE = 0,      // BLE特征值写入处理
+    CYCLE_TRACE_LED_SUBMIT,         // LED帧提交（整帧或局部）
+    CYCLE_TRACE_SENSOR_FRAME,       // UART传感器接收窗口扫描和解码
+    CYCLE_TRACE_MQTT_DATA,          // MQTT_EVENT_DATA 处理
+    CYCLE_TRACE_SITE_MAX,
+} cycle_trace_site_t;
+
+#if CYCLE_TRACE_ENABLED
+
+/**
+ * @brief 作用域计时状态（由 CYCLE_TRACE_SCOPE 声明，不直接使用）
+ */
+typedef struct {
+    cycle_trace_site_t site;
+    uint32_t start;                 // 起始周期数
+} cycle_trace_scope_t;
+
+/**
+ * @brief 开始计时
+ * 
+ * @param site 计时位置
+ * @return 作用域计时状态
+ */
+cycle_trace_scope_t cycle_trace_begin(cycle_trace_site_t site);
+
+/**
+ * @brief 结束计时并累计（作用域结束时自动调用）
+ * 
+ * @param scope 作用域计时状态
+ */
+void cycle_trace_end(cycle_trace_scope_t *scope);
+
+/**
+ * @brief 初始化周期计数并启动串口控制台（注册 `trace` 命令）
+ * 
+ * @return 
+ *     - ESP_OK: 成功
+ *     - 其他: 控制台启动失败
+ */
+esp_err_t cycle_trace_init(void);
+
+/**
+ * @brief 向标准输出打印各位置的统计
+ */
+void cycle_trace_dump(void);
+
+/**
+ * @brief 清零统计
+ */
+void cycle_trace_reset(void);
+
+/* 从此处计时到所在代码块结束，每个代码块最多使用一次 */
+#define CYCLE_TRACE_SCOPE(site) \
+    cycle_trace_scope_t _cycle_trace_scope __attribute__((cleanup(cycle_trace_end))) = cycle_trace_begin(site)
+
+#else
+
+#define CYCLE_TRACE_SCOPE(site)     ((void)0)
+
+static inline esp_err_t cycle_trace_init(void) { return ESP_OK; }
+static inline void cycle_trace_dump(void) {}
+static inline void cycle_trace_reset(void) {}
+
+#endif // CYCLE_TRACE_ENABLED
+
+#endif // CYCLE_TRACE_H
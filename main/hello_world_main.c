@@ -12,77 +12,302 @@
  * - BLE服务层：ble_service.c/h - 处理蓝牙通信
  * - LED驱动层：ws2812_driver.c/h - 控制WS2812 LED
  * - 舵机驱动层：servo_driver.c/h - 控制TD-8120MG舵机
- * - 传感器驱动层：m701_sensor.c/h - 读取M701SC空气质量数据
+ * - 传感器框架：sensor_hub.c/h - 多传感器总线读取、时间戳和合批分发
+ * - 传感器驱动层：m701_sensor.c/h - M701SC空气质量帧格式解码
+ * - 灯效引擎：led_effect.c/h - 设备端生成追逐/渐变/彩虹/呼吸灯效
+ * - 运行统计：metrics.c/h - 计数器、延迟和内存/栈低水位，BLE读取和MQTT周期发布
+ * - 静态内存：msg_pool.c/h - 任务间传递的命令块池；json_arena.c/h - cJSON解析静态区
+ * - 固件升级：ota_update.c/h - MQTT分块接收固件，双OTA分区，启动失败回滚
  * - 应用层：hello_world_main.c - 协调各模块工作
  */
 
 #include <stdio.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "esp_system.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
+#include "nvs.h"
 #include <string.h>
 
 #include "ble_service.h"
 #include "ws2812_driver.h"
+#include "led_effect.h"
 #include "servo_driver.h"
 #include "m701_sensor.h"
+#include "sensor_telemetry.h"
+#include "sensor_hub.h"
 #include "wifi_manager.h"
+#include "wifi_prov.h"
 #include "mqtt_wrapper.h"
+#include "power_manager.h"
+#include "metrics.h"
+#include "cycle_trace.h"
+#include "msg_pool.h"
+#include "json_arena.h"
+#include "ota_update.h"
+#include "esp_timer.h"
 #include "cJSON.h"
 
 /* 日志标签 */
 static const char* TAG = "MAIN";
 
+/* 命令队列配置 */
+#define APP_CMD_POOL_SIZE       8           // 预分配命令块数量
+#define APP_CMD_TEXT_MAX        512         // 文本负载最大长度（含结束符）
+#define APP_CMD_TASK_STACK      4096        // 命令分发任务栈大小
+#define APP_CMD_TASK_PRIO       5           // 命令分发任务优先级
+
+/* 持久化配置 */
+#define APP_NVS_NAMESPACE       "app"       // NVS命名空间
+#define APP_NVS_KEY_MQTT        "mqtt_cfg"  // MQTT配置JSON
+
+/* 启动时的运行模式 */
+#define APP_POWER_PROFILE       POWER_PROFILE_LOW_LATENCY
+
 /**
- * @brief LED数据接收回调函数
- * 
- * 当通过蓝牙接收到LED控制数据时调用
+ * @brief 命令类型
+ */
+typedef enum {
+    APP_CMD_LED_FRAME = 0,      // LED帧
+    APP_CMD_SERVO_ANGLE,        // 舵机角度
+    APP_CMD_EFFECT_CONFIG,      // 灯效JSON
+    APP_CMD_WIFI_CONFIG,        // WiFi配网请求JSON
+    APP_CMD_MQTT_CONFIG,        // MQTT配置JSON
+    APP_CMD_MQTT_MESSAGE,       // MQTT控制消息
+    APP_CMD_MQTT_CONNECT,       // WiFi就绪，连接MQTT
+} app_cmd_type_t;
+
+/**
+ * @brief 命令块（固定大小，来自预分配池）
+ */
+typedef struct {
+    app_cmd_type_t type;
+    uint16_t len;                               // text 有效长度
+    mqtt_topic_id_t topic;                      // 仅 APP_CMD_MQTT_MESSAGE
+    int64_t received_us;                        // 接收时间，统计命令延迟
+    union {
+        uint8_t led_data[WS2812_LED_COUNT];
+        float angle;
+        char text[APP_CMD_TEXT_MAX];
+    };
+} app_cmd_t;
+
+/* 命令池：空闲队列和待处理队列中传递的都是命令块指针，运行期不分配内存 */
+static app_cmd_t s_cmd_blocks[APP_CMD_POOL_SIZE];
+static msg_pool_t s_cmd_pool;
+static QueueHandle_t s_cmd_queue = NULL;
+static StaticQueue_t s_cmd_queue_buf;
+static uint8_t s_cmd_queue_storage[APP_CMD_POOL_SIZE * sizeof(app_cmd_t *)];
+static uint32_t s_cmd_dropped = 0;
+static bool s_mqtt_configured = false;
+
+static app_cmd_t *cmd_alloc(app_cmd_type_t type);
+static void cmd_post(app_cmd_t *cmd);
+
+/**
+ * @brief 处理LED帧
  * 
  * @param led_data 60字节LED控制数组
  */
-static void on_led_data_received(uint8_t *led_data)
+static void handle_led_data(const uint8_t *led_data)
 {
-    // 更新LED状态
-    // ws2812_update_leds(led_data);
+    // 手动帧优先：停止正在运行的灯效，再更新LED状态
+    // led_effect_stop();
+    // ws2812_submit_frame(led_data);
 }
 
 /**
- * @brief 舵机角度接收回调函数
- * 
- * 当通过蓝牙接收到舵机角度数据时调用
+ * @brief 处理舵机角度
  * 
  * @param angle 目标角度 (0.0 ~ 270.0度)
  */
-static void on_servo_angle_received(float angle)
+static void handle_servo_angle(float angle)
 {
-    // 设置舵机角度
-    // servo_set_angle(angle);
+    // 按梯形速度曲线平滑移动，连续写入时从当前速度转向新目标
+    // servo_set_target(angle);
 }
 
 /**
- * @brief 传感器数据回调函数
+ * @brief 读取可选的整数字段并检查范围
  * 
- * 当M701传感器读取到新数据时调用
+ * @param json JSON对象
+ * @param name 字段名
+ * @param min 最小值
+ * @param max 最大值
+ * @param out 输出值，字段不存在时保持不变
+ * @return false=字段存在但不是数字或超出范围
+ */
+static bool json_get_int_in_range(const cJSON *json, const char *name, int min, int max, int *out)
+{
+    cJSON *item = cJSON_GetObjectItem(json, name);
+    if (!item) {
+        return true;
+    }
+    if (!cJSON_IsNumber(item) || item->valuedouble < min || item->valuedouble > max) {
+        ESP_LOGW(TAG, "Invalid %s (expected %d~%d)", name, min, max);
+        return false;
+    }
+    *out = item->valueint;
+    return true;
+}
+
+/**
+ * @brief 处理灯效控制
+ * 
+ * 解析灯效JSON并启动，例如：
+ * {"effect":"chase","color":1,"bg":0,"length":5,"period":2000}
+ * {"effect":"none"} 停止灯效
  * 
- * @param data 传感器数据指针
+ * @param config_json 灯效参数JSON字符串
  */
-static void on_sensor_data_received(const m701_sensor_data_t *data)
+static void handle_effect_config(const char *config_json)
 {
-    // 将数据转换为JSON
-    char json_buf[128];
-    int len = m701_sensor_to_json(data, json_buf, sizeof(json_buf));
+    cJSON *json = cJSON_Parse(config_json);
+    if (!json) {
+        ESP_LOGE(TAG, "Invalid effect JSON");
+        return;
+    }
     
-    if (len > 0) {
-        // 通过BLE发送
-        ble_service_notify_sensor_data(json_buf, len);
-        
-        // 通过MQTT发布
-        if (mqtt_client_is_connected()) {
-            mqtt_client_publish("sensor/data", (uint8_t*)json_buf, len, 1);
+    int color = 1, bg = 0, length = 5, period = 2000;
+    cJSON *item = cJSON_GetObjectItem(json, "effect");
+    led_effect_type_t type = (item && cJSON_IsString(item)) ? led_effect_from_name(item->valuestring) : LED_EFFECT_MAX;
+    
+    // 先按字段类型检查范围再赋值，超出范围的值不会被截断后接受
+    bool valid = json_get_int_in_range(json, "color", 0, UINT8_MAX, &color) &&
+                 json_get_int_in_range(json, "bg", 0, UINT8_MAX, &bg) &&
+                 json_get_int_in_range(json, "length", 1, UINT8_MAX, &length) &&
+                 json_get_int_in_range(json, "period", 1, UINT16_MAX, &period);
+    cJSON_Delete(json);
+    
+    if (type == LED_EFFECT_MAX) {
+        ESP_LOGW(TAG, "Unknown effect");
+        return;
+    }
+    if (!valid) {
+        return;
+    }
+    
+    led_effect_config_t effect_cfg = {
+        .type = type,
+        .color = color,
+        .bg_color = bg,
+        .length = length,
+        .period_ms = period,
+    };
+    esp_err_t ret = led_effect_start(&effect_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Start effect failed: %s", esp_err_to_name(ret));
+    }
+}
+
+/**
+ * @brief 处理运行模式切换
+ * 
+ * 例如：{"profile":"low_power","latency":500}
+ * 
+ * @param config_json 运行模式JSON字符串
+ */
+static void handle_power_config(const char *config_json)
+{
+    cJSON *json = cJSON_Parse(config_json);
+    if (!json) {
+        ESP_LOGE(TAG, "Invalid power JSON");
+        return;
+    }
+    
+    cJSON *item = cJSON_GetObjectItem(json, "profile");
+    power_profile_t profile = (item && cJSON_IsString(item)) ?
+                              power_manager_profile_from_name(item->valuestring) : POWER_PROFILE_MAX;
+    
+    uint16_t latency_ms = 0;
+    item = cJSON_GetObjectItem(json, "latency");
+    if (item && cJSON_IsNumber(item) && item->valueint > 0) {
+        latency_ms = item->valueint > UINT16_MAX ? UINT16_MAX : item->valueint;
+    }
+    
+    cJSON_Delete(json);
+    
+    if (profile == POWER_PROFILE_MAX) {
+        ESP_LOGW(TAG, "Unknown power profile");
+        return;
+    }
+    
+    esp_err_t ret = power_manager_set_profile(profile, latency_ms);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Set power profile failed: %s", esp_err_to_name(ret));
+    }
+}
+
+/**
+ * @brief 传感器样本批回调函数
+ * 
+ * 在 sensor_hub 分发任务中调用，每批只发一次BLE通知
+ * 
+ * @param samples 样本数组
+ * @param count 样本数量
+ */
+static void on_sensor_batch(const sensor_sample_t *samples, size_t count)
+{
+    const m701_sensor_data_t *latest = NULL;
+    
+    for (size_t i = 0; i < count; i++) {
+        if (samples[i].type == SENSOR_TYPE_M701) {
+            // MQTT按窗口聚合后批量发布，超阈值立即报警
+            sensor_telemetry_add_sample(&samples[i].data.m701);
+            latest = &samples[i].data.m701;
         }
     }
+    
+    if (latest) {
+        // 每个BLE连接单独选择格式（默认JSON，二进制免去浮点格式化），只编码有订阅者的格式
+        static const m701_payload_format_t formats[] = {M701_PAYLOAD_JSON, M701_PAYLOAD_BINARY};
+        static uint8_t payload_buf[128];    // 只在分发任务中使用
+        for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+            if (!ble_service_sensor_subscribed(formats[i])) {
+                continue;
+            }
+            int len = m701_codec_encode(latest, formats[i], payload_buf, sizeof(payload_buf));
+            if (len > 0) {
+                ble_service_notify_sensor_data(formats[i], payload_buf, len);
+            }
+        }
+    }
+}
+
+/**
+ * @brief 遥测发布回调
+ * 
+ * 批量数据发布到 sensor/data，报警发布到 sensor/alarm，断线期间进入离线队列
+ */
+static bool on_telemetry_publish(bool alarm, const uint8_t *payload, int len)
+{
+    return mqtt_client_publish_queued(alarm ? "sensor/alarm" : "sensor/data", payload, len, 1) == ESP_OK;
+}
+
+/**
+ * @brief 运行统计发布回调
+ * 
+ * 统计只反映当前状态，未连接时直接丢弃，不进入离线队列
+ */
+static void on_metrics_publish(const char *json, int len)
+{
+    if (mqtt_client_is_connected()) {
+        mqtt_client_publish_id(MQTT_TOPIC_STATS, (const uint8_t *)json, len, 0);
+    }
+}
+
+/**
+ * @brief 固件升级状态回调
+ * 
+ * 升级状态发布到 status 主题，未连接时丢弃
+ */
+static void on_ota_status(const char *json, int len)
+{
+    if (mqtt_client_is_connected()) {
+        mqtt_client_publish_id(MQTT_TOPIC_STATUS, (const uint8_t *)json, len, 1);
+    }
 }
 
 /**
@@ -92,8 +317,11 @@ static void on_wifi_status(bool connected, const char *ip_addr)
 {
     if (connected) {
         ESP_LOGI(TAG, "WiFi connected, IP: %s", ip_addr);
-        // WiFi连接成功后，如果MQTT已配置则自动连接
-        // MQTT连接在配置回调中处理
+        // WiFi连接成功后，如果MQTT已配置则自动连接（在分发任务中执行）
+        app_cmd_t *cmd = cmd_alloc(APP_CMD_MQTT_CONNECT);
+        if (cmd) {
+            cmd_post(cmd);
+        }
     } else {
         ESP_LOGI(TAG, "WiFi disconnected");
     }
@@ -106,59 +334,117 @@ static void on_mqtt_status(bool connected)
 {
     if (connected) {
         ESP_LOGI(TAG, "MQTT connected");
+        // 新固件能连上Broker即视为可用，取消回滚
+        ota_update_confirm();
     } else {
         ESP_LOGI(TAG, "MQTT disconnected");
     }
 }
 
 /**
- * @brief MQTT消息接收回调
+ * @brief 处理MQTT控制消息
+ * 
+ * @param topic 主题ID
+ * @param msg_buf 消息内容（已添加结束符）
+ * @param len 消息长度
  */
-static void on_mqtt_message(const char *topic, const uint8_t *data, int len)
+static void handle_mqtt_message(mqtt_topic_id_t topic, const char *msg_buf, int len)
 {
-    char msg_buf[256] = {0};
-    int copy_len = (len < sizeof(msg_buf) - 1) ? len : sizeof(msg_buf) - 1;
-    memcpy(msg_buf, data, copy_len);
-    msg_buf[copy_len] = '\0';
+    ESP_LOGI(TAG, "MQTT message: topic=%d, data=%.*s", topic, len, msg_buf);
     
-    ESP_LOGI(TAG, "MQTT message: topic=%s, data=%.*s", topic, len, msg_buf);
-    
-    // 解析主题，判断是LED控制还是舵机控制
-    if (strstr(topic, "/control/led") != NULL) {
+    // 按主题ID分发，主题匹配已在MQTT客户端中完成
+    switch (topic) {
+    case MQTT_TOPIC_CONTROL_LED: {
         // LED控制
-        uint8_t led_data[60] = {0};
+        static uint8_t led_data[WS2812_LED_COUNT];     // 只在分发任务中使用
+        memset(led_data, 0, sizeof(led_data));
         int count = 0;
-        for (int i = 0; i < len && count < 60; i++) {
+        for (int i = 0; i < len && count < WS2812_LED_COUNT; i++) {
             char c = msg_buf[i];
             if (c >= '0' && c <= '7') {
                 led_data[count++] = (uint8_t)(c - '0');
             }
         }
         if (count > 0) {
-            on_led_data_received(led_data);
+            handle_led_data(led_data);
         }
-    } else if (strstr(topic, "/control/servo") != NULL) {
+        break;
+    }
+    case MQTT_TOPIC_CONTROL_SERVO: {
         // 舵机控制
         float angle = 0.0f;
         if (sscanf(msg_buf, "%f", &angle) == 1 && angle >= 0.0f && angle <= 270.0f) {
-            on_servo_angle_received(angle);
+            handle_servo_angle(angle);
         }
+        break;
+    }
+    case MQTT_TOPIC_CONTROL_EFFECT:
+        // 灯效控制
+        handle_effect_config(msg_buf);
+        break;
+    case MQTT_TOPIC_CONTROL_POWER:
+        // 运行模式
+        handle_power_config(msg_buf);
+        break;
+    case MQTT_TOPIC_OTA_CONTROL:
+        // 固件升级控制（数据走流式回调，不进入命令队列）
+        ota_update_handle_control(msg_buf);
+        break;
+    default:
+        break;
     }
 }
 
 /**
- * @brief WiFi配置回调
+ * @brief 保存MQTT配置JSON，内容未变时不写Flash
  */
-static void on_wifi_config(const char *ssid, const char *password)
+static void save_mqtt_config(const char *config_json)
 {
-    ESP_LOGI(TAG, "WiFi config: SSID=%s", ssid);
-    wifi_manager_connect(ssid, password);
+    nvs_handle_t handle;
+    if (nvs_open(APP_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    
+    static char stored[APP_CMD_TEXT_MAX];
+    size_t len = sizeof(stored);
+    if (nvs_get_str(handle, APP_NVS_KEY_MQTT, stored, &len) != ESP_OK ||
+        strcmp(stored, config_json) != 0) {
+        if (nvs_set_str(handle, APP_NVS_KEY_MQTT, config_json) != ESP_OK ||
+            nvs_commit(handle) != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to save MQTT config");
+        }
+    }
+    nvs_close(handle);
 }
 
 /**
- * @brief MQTT配置回调
+ * @brief 读取保存的MQTT配置并投递到分发任务
  */
-static void on_mqtt_config(const char *config_json)
+static void load_mqtt_config(void)
+{
+    nvs_handle_t handle;
+    if (nvs_open(APP_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+    
+    app_cmd_t *cmd = cmd_alloc(APP_CMD_MQTT_CONFIG);
+    if (cmd) {
+        size_t len = sizeof(cmd->text);
+        if (nvs_get_str(handle, APP_NVS_KEY_MQTT, cmd->text, &len) == ESP_OK) {
+            ESP_LOGI(TAG, "Loaded stored MQTT config");
+            cmd->len = strlen(cmd->text);
+            cmd_post(cmd);
+        } else {
+            msg_pool_free(&s_cmd_pool, cmd);
+        }
+    }
+    nvs_close(handle);
+}
+
+/**
+ * @brief 处理MQTT配置
+ */
+static void handle_mqtt_config(const char *config_json)
 {
     ESP_LOGI(TAG, "MQTT config: %s", config_json);
     
@@ -200,11 +486,44 @@ static void on_mqtt_config(const char *config_json)
         strcpy(mqtt_cfg.prefix, "jasper-c3");
     }
     
+    // 会话与缓冲区（可选）
+    item = cJSON_GetObjectItem(json, "clean_session");
+    if (item && cJSON_IsBool(item)) {
+        mqtt_cfg.clean_session = cJSON_IsTrue(item);
+    }
+    
+    item = cJSON_GetObjectItem(json, "rx_buffer");
+    if (item && cJSON_IsNumber(item) && item->valueint > 0 && item->valueint <= UINT16_MAX) {
+        mqtt_cfg.rx_buffer_size = item->valueint;
+    }
+    
+    item = cJSON_GetObjectItem(json, "tx_buffer");
+    if (item && cJSON_IsNumber(item) && item->valueint > 0 && item->valueint <= UINT16_MAX) {
+        mqtt_cfg.tx_buffer_size = item->valueint;
+    }
+    
+    // 遥测聚合窗口（样本数，可选）
+    // 先在int上检查范围，避免截断为uint16_t后被接受（如65600变成64）
+    int window = 0;
+    if (json_get_int_in_range(json, "window", 1, SENSOR_TELEMETRY_WINDOW_MAX, &window) && window > 0) {
+        if (sensor_telemetry_set_window(window) != ESP_OK) {
+            ESP_LOGW(TAG, "Invalid telemetry window: %d", window);
+        }
+    }
+    
+    // 遥测负载格式（可选，"json" 或 "binary"）
+    item = cJSON_GetObjectItem(json, "format");
+    if (item && cJSON_IsString(item)) {
+        sensor_telemetry_set_format(strcmp(item->valuestring, "binary") == 0 ?
+                                    M701_PAYLOAD_BINARY : M701_PAYLOAD_JSON);
+    }
+    
     cJSON_Delete(json);
     
     // 配置并连接MQTT
-    if (strlen(mqtt_cfg.broker) > 0) {
-        mqtt_client_set_config(&mqtt_cfg);
+    if (strlen(mqtt_cfg.broker) > 0 && mqtt_client_set_config(&mqtt_cfg) == ESP_OK) {
+        s_mqtt_configured = true;
+        save_mqtt_config(config_json);
         if (wifi_manager_is_connected()) {
             mqtt_client_connect();
         } else {
@@ -213,6 +532,215 @@ static void on_mqtt_config(const char *config_json)
     }
 }
 
+/**
+ * @brief 从命令池取出一个空闲命令块
+ * 
+ * 不阻塞：命令池耗尽时丢弃命令，保证BLE/MQTT事件任务不被应用层拖慢
+ * 
+ * @param type 命令类型
+ * @return 命令块，失败返回 NULL
+ */
+static app_cmd_t *cmd_alloc(app_cmd_type_t type)
+{
+    app_cmd_t *cmd = msg_pool_alloc(&s_cmd_pool);
+    if (!cmd) {
+        s_cmd_dropped++;
+        metrics_count(METRICS_COUNTER_CMD_DROPPED);
+        ESP_LOGW(TAG, "Command pool exhausted, dropped %lu", s_cmd_dropped);
+        return NULL;
+    }
+    cmd->type = type;
+    cmd->len = 0;
+    cmd->topic = MQTT_TOPIC_COUNT;
+    cmd->received_us = esp_timer_get_time();
+    return cmd;
+}
+
+/**
+ * @brief 把命令块投递到分发任务
+ */
+static void cmd_post(app_cmd_t *cmd)
+{
+    // 空闲块与待处理队列容量相同，投递不会失败
+    xQueueSend(s_cmd_queue, &cmd, 0);
+}
+
+/**
+ * @brief 复制文本负载到命令块，超长截断
+ */
+static void cmd_set_text(app_cmd_t *cmd, const char *text, int len)
+{
+    if (len > APP_CMD_TEXT_MAX - 1) {
+        len = APP_CMD_TEXT_MAX - 1;
+    }
+    memcpy(cmd->text, text, len);
+    cmd->text[len] = '\0';
+    cmd->len = len;
+}
+
+/**
+ * @brief 命令分发任务
+ * 
+ * 在应用任务中执行解析和驱动调用，BLE/MQTT回调只负责入队
+ */
+static void app_cmd_task(void *arg)
+{
+    app_cmd_t *cmd;
+    
+    // 配置/控制JSON都在本任务解析，cJSON节点从静态区分配
+    json_arena_bind();
+    
+    while (1) {
+        if (xQueueReceive(s_cmd_queue, &cmd, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        
+        switch (cmd->type) {
+        case APP_CMD_LED_FRAME:
+            handle_led_data(cmd->led_data);
+            break;
+        case APP_CMD_SERVO_ANGLE:
+            handle_servo_angle(cmd->angle);
+            metrics_record_since(METRICS_LATENCY_SERVO_CMD, cmd->received_us);
+            break;
+        case APP_CMD_EFFECT_CONFIG:
+            handle_effect_config(cmd->text);
+            break;
+        case APP_CMD_WIFI_CONFIG:
+            wifi_prov_handle_request(cmd->text);
+            break;
+        case APP_CMD_MQTT_CONFIG:
+            handle_mqtt_config(cmd->text);
+            break;
+        case APP_CMD_MQTT_MESSAGE:
+            handle_mqtt_message(cmd->topic, cmd->text, cmd->len);
+            if (cmd->topic == MQTT_TOPIC_CONTROL_SERVO) {
+                metrics_record_since(METRICS_LATENCY_SERVO_CMD, cmd->received_us);
+            }
+            break;
+        case APP_CMD_MQTT_CONNECT:
+            if (s_mqtt_configured) {
+                mqtt_client_connect();
+            }
+            break;
+        default:
+            break;
+        }
+        
+        json_arena_reset();
+        msg_pool_free(&s_cmd_pool, cmd);
+    }
+}
+
+/**
+ * @brief 初始化命令队列和分发任务
+ */
+static esp_err_t app_cmd_init(void)
+{
+    esp_err_t ret = msg_pool_init(&s_cmd_pool, s_cmd_blocks, sizeof(app_cmd_t), APP_CMD_POOL_SIZE);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create command pool");
+        return ret;
+    }
+    s_cmd_queue = xQueueCreateStatic(APP_CMD_POOL_SIZE, sizeof(app_cmd_t *), s_cmd_queue_storage,
+                                     &s_cmd_queue_buf);
+    
+    if (xTaskCreate(app_cmd_task, "app_cmd", APP_CMD_TASK_STACK, NULL,
+                    APP_CMD_TASK_PRIO, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create command task");
+        return ESP_FAIL;
+    }
+    
+    ESP_LOGI(TAG, "Command dispatcher started (pool=%d)", APP_CMD_POOL_SIZE);
+    return ESP_OK;
+}
+
+/**
+ * @brief LED数据接收回调函数
+ * 
+ * 当通过蓝牙接收到LED控制数据时调用（BTU任务），只复制入队
+ * 
+ * @param led_data 60字节LED控制数组
+ */
+static void on_led_data_received(uint8_t *led_data)
+{
+    app_cmd_t *cmd = cmd_alloc(APP_CMD_LED_FRAME);
+    if (cmd) {
+        memcpy(cmd->led_data, led_data, WS2812_LED_COUNT);
+        cmd_post(cmd);
+    }
+}
+
+/**
+ * @brief 舵机角度接收回调函数
+ * 
+ * 当通过蓝牙接收到舵机角度数据时调用（BTU任务），只复制入队
+ * 
+ * @param angle 目标角度 (0.0 ~ 270.0度)
+ */
+static void on_servo_angle_received(float angle)
+{
+    app_cmd_t *cmd = cmd_alloc(APP_CMD_SERVO_ANGLE);
+    if (cmd) {
+        cmd->angle = angle;
+        cmd_post(cmd);
+    }
+}
+
+/**
+ * @brief 灯效控制回调
+ */
+static void on_effect_config(const char *config_json)
+{
+    app_cmd_t *cmd = cmd_alloc(APP_CMD_EFFECT_CONFIG);
+    if (cmd) {
+        cmd_set_text(cmd, config_json, strlen(config_json));
+        cmd_post(cmd);
+    }
+}
+
+/**
+ * @brief WiFi配网请求回调
+ * 
+ * JSON解析和连接交给分发任务执行，结果通过配网状态特征值异步通知
+ */
+static void on_wifi_config(const char *request_json)
+{
+    app_cmd_t *cmd = cmd_alloc(APP_CMD_WIFI_CONFIG);
+    if (cmd) {
+        cmd_set_text(cmd, request_json, strlen(request_json));
+        cmd_post(cmd);
+    }
+}
+
+/**
+ * @brief MQTT配置回调
+ */
+static void on_mqtt_config(const char *config_json)
+{
+    app_cmd_t *cmd = cmd_alloc(APP_CMD_MQTT_CONFIG);
+    if (cmd) {
+        cmd_set_text(cmd, config_json, strlen(config_json));
+        cmd_post(cmd);
+    }
+}
+
+/**
+ * @brief MQTT消息接收回调
+ * 
+ * 在MQTT任务中调用，主题已查表为ID，负载直接复制进命令块（唯一的一次复制），
+ * 解析留给分发任务，保证keepalive不被拖慢
+ */
+static void on_mqtt_message(mqtt_topic_id_t topic, const uint8_t *data, int len)
+{
+    app_cmd_t *cmd = cmd_alloc(APP_CMD_MQTT_MESSAGE);
+    if (cmd) {
+        cmd->topic = topic;
+        cmd_set_text(cmd, (const char *)data, len);
+        cmd_post(cmd);
+    }
+}
+
 /**
  * @brief 初始化NVS闪存
  */
@@ -250,6 +778,25 @@ void app_main(void)
         return;
     }
 
+    // 初始化运行统计，周期发布到 MQTT stats
+    ret = metrics_init(on_metrics_publish);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Metrics init failed");
+    }
+
+    // 热点路径周期计数和 `trace` 控制台命令（CYCLE_TRACE_ENABLED 为0时为空操作）
+    ret = cycle_trace_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Cycle trace init failed");
+    }
+
+    // 初始化命令分发（BLE/MQTT回调依赖）
+    ret = app_cmd_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Command dispatcher init failed");
+        return;
+    }
+
     // 2. 初始化WS2812 LED驱动
     // ret = ws2812_init();
     // if (ret != ESP_OK) {
@@ -257,6 +804,13 @@ void app_main(void)
     //     return;
     // }
 
+    // 初始化灯效引擎（依赖WS2812驱动）
+    // ret = led_effect_init();
+    // if (ret != ESP_OK) {
+    //     ESP_LOGE(TAG, "LED effect init failed");
+    //     return;
+    // }
+
     // 3. 初始化舵机驱动
     // ret = servo_init();
     // if (ret != ESP_OK) {
@@ -271,6 +825,12 @@ void app_main(void)
         return;
     }
 
+    ret = wifi_prov_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "WiFi provisioning init failed");
+        return;
+    }
+
     // 5. 初始化MQTT客户端
     ret = mqtt_client_init(on_mqtt_message, on_mqtt_status);
     if (ret != ESP_OK) {
@@ -278,8 +838,31 @@ void app_main(void)
         return;
     }
 
-    // 6. 初始化M701传感器
-    ret = m701_sensor_init(on_sensor_data_received);
+    // 初始化固件升级：ota/data 分片直接流式写入，不经过命令队列
+    ret = ota_update_init(on_ota_status);
+    if (ret == ESP_OK) {
+        mqtt_client_set_stream_callback(MQTT_TOPIC_OTA_DATA, ota_update_feed);
+    } else {
+        ESP_LOGW(TAG, "OTA init failed");
+    }
+
+    // 恢复上次的MQTT配置，WiFi就绪后自动连接
+    load_mqtt_config();
+
+    // 6. 初始化遥测聚合、传感器框架和M701传感器
+    ret = sensor_telemetry_init(NULL, on_telemetry_publish);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Sensor telemetry init failed");
+        return;
+    }
+
+    ret = sensor_hub_init(on_sensor_batch);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Sensor hub init failed");
+        return;
+    }
+
+    ret = m701_sensor_init();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "M701 sensor init failed");
         return;
@@ -295,6 +878,13 @@ void app_main(void)
     // 8. 注册WiFi和MQTT配置回调
     ble_service_set_wifi_config_callback(on_wifi_config);
     ble_service_set_mqtt_config_callback(on_mqtt_config);
+    ble_service_set_effect_callback(on_effect_config);
+
+    // 9. 应用运行模式
+    ret = power_manager_set_profile(APP_POWER_PROFILE, 0);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Power profile init failed");
+    }
 
     ESP_LOGI(TAG, "System ready! Servo:GPIO2, M701:GPIO3");
     ESP_LOGI(TAG, "Use BLE to configure WiFi and MQTT");
@@ -0,0 +1,100 @@
+/*
+ * cJSON静态解析区 - 实现文件
+ * 
+ * 分配按8字节对齐（cJSON 节点含 double），只有绑定任务访问 s_used，不需要加锁
+ */
+
+#include "json_arena.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "cJSON.h"
+#include <stdlib.h>
+
+/* 日志标签 */
+static const char* TAG = "JSON_ARENA";
+
+#define ARENA_ALIGN(n)  (((n) + 7) & ~(size_t)7)
+
+/* 全局变量 */
+static uint8_t s_arena[JSON_ARENA_SIZE] __attribute__((aligned(8)));
+static size_t s_used = 0;
+static TaskHandle_t s_owner = NULL;
+static json_arena_stats_t s_stats;
+
+/**
+ * @brief 是否为静态区内的指针
+ */
+static bool in_arena(const void *ptr)
+{
+    const uint8_t *p = ptr;
+    return p >= s_arena && p < s_arena + sizeof(s_arena);
+}
+
+/**
+ * @brief cJSON分配钩子
+ */
+static void *arena_malloc(size_t size)
+{
+    if (s_owner && xTaskGetCurrentTaskHandle() == s_owner) {
+        size_t need = ARENA_ALIGN(size);
+        if (need <= sizeof(s_arena) - s_used) {
+            void *ptr = &s_arena[s_used];
+            s_used += need;
+            return ptr;
+        }
+        s_stats.heap_fallbacks++;
+    }
+    return malloc(size);
+}
+
+/**
+ * @brief cJSON释放钩子，静态区内的指针在 json_arena_reset 时统一回收
+ */
+static void arena_free(void *ptr)
+{
+    if (!in_arena(ptr)) {
+        free(ptr);
+    }
+}
+
+/**
+ * @brief 安装cJSON内存钩子并绑定调用任务
+ */
+esp_err_t json_arena_bind(void)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (s_owner && s_owner != self) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    cJSON_Hooks hooks = {
+        .malloc_fn = arena_malloc,
+        .free_fn = arena_free,
+    };
+    cJSON_InitHooks(&hooks);
+    s_used = 0;
+    s_owner = self;
+    
+    ESP_LOGI(TAG, "cJSON arena bound (%d bytes)", JSON_ARENA_SIZE);
+    return ESP_OK;
+}
+
+/**
+ * @brief 回收静态区
+ */
+void json_arena_reset(void)
+{
+    if (s_used > s_stats.high_water) {
+        s_stats.high_water = s_used;
+    }
+    s_used = 0;
+}
+
+/**
+ * @brief 获取静态区统计
+ */
+void json_arena_get_stats(json_arena_stats_t *stats)
+{
+    *stats = s_stats;
+}
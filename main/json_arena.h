@@ -0,0 +1,53 @@
+/*
+ * cJSON静态解析区 - 头文件
+ * 
+ * 功能：让配置/控制JSON的解析不再使用堆
+ * - 安装 cJSON 内存钩子：绑定任务中的分配从静态区顺序切分，释放为空操作，
+ *   每条消息处理完调用 json_arena_reset 整体回收
+ * - 其他任务的分配、以及静态区不足时退回堆分配（计数，便于调大 JSON_ARENA_SIZE）
+ * 
+ * 约束：在绑定任务中解析得到的 cJSON 对象和字符串不能保留到 json_arena_reset 之后
+ */
+
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+/* 配置参数 */
+#define JSON_ARENA_SIZE         3072        // 静态区大小(字节)，容纳一条最长512字节的配置JSON
+
+/**
+ * @brief 静态区统计
+ */
+typedef struct {
+    uint32_t high_water;        // 单条消息最多使用的字节数
+    uint32_t heap_fallbacks;    // 静态区不足退回堆分配的次数
+} json_arena_stats_t;
+
+/**
+ * @brief 安装cJSON内存钩子并把静态区绑定到调用任务
+ * 
+ * 只能绑定一个任务（所有JSON解析都在命令分发任务中执行）
+ * 
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_STATE: 已绑定其他任务
+ */
+esp_err_t json_arena_bind(void);
+
+/**
+ * @brief 回收静态区（绑定任务中每条消息处理完调用）
+ */
+void json_arena_reset(void);
+
+/**
+ * @brief 获取静态区统计
+ * 
+ * @param stats 输出统计
+ */
+void json_arena_get_stats(json_arena_stats_t *stats);
+
+#endif // JSON_ARENA_H
@@ -0,0 +1,259 @@
+/*
+ * LED灯效引擎 - 实现文件
+ * 
+ * 灯效任务以固定帧周期（vTaskDelayUntil）生成帧并异步提交给WS2812驱动，
+ * 未运行灯效时任务阻塞在任务通知上，不占用CPU。
+ * 帧内容只由启动后经过的时间决定，丢帧不会导致动画变慢或漂移。
+ */
+
+#include "led_effect.h"
+#include "ws2812_driver.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+/* 日志标签 */
+static const char* TAG = "LED_EFFECT";
+
+/* 调色板中可用于彩色效果的颜色（1~7，0为灭） */
+#define FIRST_COLOR     1
+#define COLOR_COUNT     7
+
+/* 全局变量 */
+static TaskHandle_t s_effect_task = NULL;
+static SemaphoreHandle_t s_config_mutex = NULL;  // 保护灯效参数，同时串行化灯效帧提交
+static led_effect_config_t s_config = {0};      // 当前灯效参数
+static bool s_restart = false;                   // 参数已更新，需从头播放
+
+static const char *s_effect_names[LED_EFFECT_MAX] = {
+    [LED_EFFECT_NONE]      = "none",
+    [LED_EFFECT_CHASE]     = "chase",
+    [LED_EFFECT_FADE]      = "fade",
+    [LED_EFFECT_RAINBOW]   = "rainbow",
+    [LED_EFFECT_BREATHING] = "breathing",
+};
+
+/**
+ * @brief 三角波亮度，相位 [0, period) 映射到 0→255→0，并做平方校正使亮度变化更均匀
+ */
+static uint8_t triangle_brightness(uint32_t phase, uint32_t period)
+{
+    uint32_t half = period / 2;
+    uint32_t level = (phase < half) ? phase * 255 / half : (period - phase) * 255 / half;
+    if (level > 255) {
+        level = 255;
+    }
+    return (uint8_t)(level * level / 255);
+}
+
+/**
+ * @brief 生成一帧
+ * 
+ * @param config 灯效参数
+ * @param elapsed_ms 灯效启动后经过的时间
+ * @param frame 输出帧（颜色索引）
+ * @return 本帧的全局亮度
+ */
+static uint8_t render_frame(const led_effect_config_t *config, uint32_t elapsed_ms, uint8_t *frame)
+{
+    uint32_t period = config->period_ms;
+    uint32_t phase = elapsed_ms % period;
+    
+    switch (config->type) {
+    case LED_EFFECT_CHASE: {
+        // 光带头部在一个周期内走完整条灯带
+        uint32_t head = phase * WS2812_LED_COUNT / period;
+        memset(frame, config->bg_color, WS2812_LED_COUNT);
+        for (uint32_t i = 0; i < config->length; i++) {
+            frame[(head + WS2812_LED_COUNT - i) % WS2812_LED_COUNT] = config->color;
+        }
+        return 255;
+    }
+    
+    case LED_EFFECT_RAINBOW: {
+        // 7种颜色均分灯带，一个周期滚动一整圈
+        uint32_t shift = phase * WS2812_LED_COUNT / period;
+        for (uint32_t led = 0; led < WS2812_LED_COUNT; led++) {
+            uint32_t pos = (led + shift) % WS2812_LED_COUNT;
+            frame[led] = FIRST_COLOR + pos * COLOR_COUNT / WS2812_LED_COUNT;
+        }
+        return 255;
+    }
+    
+    case LED_EFFECT_FADE: {
+        // 每个周期一种颜色，亮度最低时切换到下一种颜色
+        uint32_t cycle = elapsed_ms / period;
+        memset(frame, FIRST_COLOR + (config->color - FIRST_COLOR + cycle) % COLOR_COUNT, WS2812_LED_COUNT);
+        return triangle_brightness(phase, period);
+    }
+    
+    case LED_EFFECT_BREATHING:
+        memset(frame, config->color, WS2812_LED_COUNT);
+        return triangle_brightness(phase, period);
+    
+    default:
+        memset(frame, 0, WS2812_LED_COUNT);
+        return 255;
+    }
+}
+
+/**
+ * @brief 灯效任务
+ */
+static void led_effect_task(void *arg)
+{
+    uint8_t frame[WS2812_LED_COUNT];
+    led_effect_config_t config = {0};
+    TickType_t start_tick = 0;
+    TickType_t last_wake = 0;
+    const TickType_t frame_ticks = pdMS_TO_TICKS(LED_EFFECT_FRAME_MS) > 0 ? pdMS_TO_TICKS(LED_EFFECT_FRAME_MS) : 1;
+    
+    ESP_LOGI(TAG, "Effect task started (%d ms/frame)", LED_EFFECT_FRAME_MS);
+    
+    while (1) {
+        if (config.type == LED_EFFECT_NONE) {
+            // 空闲：等待新的灯效
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+    
+        // 持锁生成并提交帧：led_effect_stop()返回后不会再有旧灯效的帧覆盖手动帧
+        xSemaphoreTake(s_config_mutex, portMAX_DELAY);
+        if (s_restart) {
+            config = s_config;
+            s_restart = false;
+            start_tick = xTaskGetTickCount();
+            last_wake = start_tick;
+        }
+    
+        if (config.type == LED_EFFECT_NONE) {
+            ws2812_set_brightness(255);
+            xSemaphoreGive(s_config_mutex);
+            continue;
+        }
+    
+        uint32_t elapsed_ms = pdTICKS_TO_MS(xTaskGetTickCount() - start_tick);
+        uint8_t brightness = render_frame(&config, elapsed_ms, frame);
+        ws2812_set_brightness(brightness);
+        ws2812_submit_frame(frame);
+        xSemaphoreGive(s_config_mutex);
+    
+        // 固定帧率：按绝对时间推进，处理耗时不累积
+        vTaskDelayUntil(&last_wake, frame_ticks);
+    }
+}
+
+/**
+ * @brief 初始化灯效引擎
+ */
+esp_err_t led_effect_init(void)
+{
+    if (s_effect_task) {
+        ESP_LOGW(TAG, "Already initialized");
+        return ESP_OK;
+    }
+    
+    s_config_mutex = xSemaphoreCreateMutex();
+    if (!s_config_mutex) {
+        ESP_LOGE(TAG, "Failed to create config mutex");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    BaseType_t xReturned = xTaskCreate(led_effect_task, "led_effect", LED_EFFECT_TASK_STACK, NULL,
+                                       LED_EFFECT_TASK_PRIO, &s_effect_task);
+    if (xReturned != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create effect task");
+        vSemaphoreDelete(s_config_mutex);
+        s_config_mutex = NULL;
+        s_effect_task = NULL;
+        return ESP_FAIL;
+    }
+    
+    ESP_LOGI(TAG, "LED effect engine initialized");
+    return ESP_OK;
+}
+
+/**
+ * @brief 启动灯效
+ */
+esp_err_t led_effect_start(const led_effect_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(s_effect_task, ESP_ERR_INVALID_STATE, TAG, "effect engine not initialized");
+    ESP_RETURN_ON_FALSE(config && config->type < LED_EFFECT_MAX, ESP_ERR_INVALID_ARG, TAG, "invalid effect");
+    
+    led_effect_config_t cfg = *config;
+    if (cfg.type != LED_EFFECT_NONE) {
+        ESP_RETURN_ON_FALSE(cfg.color >= FIRST_COLOR && cfg.color < FIRST_COLOR + COLOR_COUNT,
+                            ESP_ERR_INVALID_ARG, TAG, "invalid color %d", cfg.color);
+        ESP_RETURN_ON_FALSE(cfg.bg_color < FIRST_COLOR + COLOR_COUNT, ESP_ERR_INVALID_ARG, TAG,
+                            "invalid background color %d", cfg.bg_color);
+        // 周期至少两帧，保证三角波有上升和下降
+        if (cfg.period_ms < LED_EFFECT_FRAME_MS * 2) {
+            cfg.period_ms = LED_EFFECT_FRAME_MS * 2;
+        }
+        if (cfg.length == 0) {
+            cfg.length = 1;
+        } else if (cfg.length > WS2812_LED_COUNT) {
+            cfg.length = WS2812_LED_COUNT;
+        }
+    }
+    
+    xSemaphoreTake(s_config_mutex, portMAX_DELAY);
+    s_config = cfg;
+    s_restart = true;
+    if (cfg.type == LED_EFFECT_NONE) {
+        // 停止时同步恢复亮度：返回后立即提交的手动帧不会沿用渐变/呼吸的低亮度
+        ws2812_set_brightness(255);
+    }
+    xSemaphoreGive(s_config_mutex);
+    xTaskNotifyGive(s_effect_task);
+    
+    ESP_LOGI(TAG, "Effect %s started (color=%d, bg=%d, len=%d, period=%d ms)",
+             s_effect_names[cfg.type], cfg.color, cfg.bg_color, cfg.length, cfg.period_ms);
+    return ESP_OK;
+}
+
+/**
+ * @brief 停止灯效
+ */
+esp_err_t led_effect_stop(void)
+{
+    if (!s_effect_task || led_effect_get_current() == LED_EFFECT_NONE) {
+        return ESP_OK;
+    }
+    
+    led_effect_config_t none = { .type = LED_EFFECT_NONE };
+    return led_effect_start(&none);
+}
+
+/**
+ * @brief 获取当前灯效类型
+ */
+led_effect_type_t led_effect_get_current(void)
+{
+    if (!s_config_mutex) {
+        return LED_EFFECT_NONE;
+    }
+    xSemaphoreTake(s_config_mutex, portMAX_DELAY);
+    led_effect_type_t type = s_config.type;
+    xSemaphoreGive(s_config_mutex);
+    return type;
+}
+
+/**
+ * @brief 根据名称查找灯效类型
+ */
+led_effect_type_t led_effect_from_name(const char *name)
+{
+    if (!name) {
+        return LED_EFFECT_MAX;
+    }
+    for (int i = 0; i < LED_EFFECT_MAX; i++) {
+        if (strcmp(name, s_effect_names[i]) == 0) {
+            return (led_effect_type_t)i;
+        }
+    }
+    return LED_EFFECT_MAX;
+}
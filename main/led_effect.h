@@ -0,0 +1,91 @@
+/*
+ * LED灯效引擎 - 头文件
+ * 
+ * 功能：在设备端以固定帧率生成灯效，控制消息只需选择效果和参数
+ * 支持：追逐、渐变、彩虹、呼吸，颜色均取自WS2812调色板 (0~7)
+ */
+
+#ifndef LED_EFFECT_H
+#define LED_EFFECT_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/* 配置参数 */
+#define LED_EFFECT_FRAME_MS     20          // 帧周期(ms)，50fps
+#define LED_EFFECT_TASK_STACK   3072        // 灯效任务栈大小
+#define LED_EFFECT_TASK_PRIO    4           // 灯效任务优先级
+
+/**
+ * @brief 灯效类型
+ */
+typedef enum {
+    LED_EFFECT_NONE = 0,    // 无灯效（手动帧控制）
+    LED_EFFECT_CHASE,       // 追逐：一段主颜色光带在背景色上循环移动
+    LED_EFFECT_FADE,        // 渐变：依次在各颜色间渐亮渐灭
+    LED_EFFECT_RAINBOW,     // 彩虹：1~7号颜色色带沿灯带滚动
+    LED_EFFECT_BREATHING,   // 呼吸：主颜色整条灯带亮度周期起伏
+    LED_EFFECT_MAX,
+} led_effect_type_t;
+
+/**
+ * @brief 灯效参数
+ */
+typedef struct {
+    led_effect_type_t type;     // 灯效类型
+    uint8_t color;              // 主颜色索引 (1~7)
+    uint8_t bg_color;           // 背景颜色索引 (0~7，仅追逐)
+    uint8_t length;             // 光带长度（仅追逐）
+    uint16_t period_ms;         // 一次完整循环的时长(ms)
+} led_effect_config_t;
+
+/**
+ * @brief 初始化灯效引擎
+ * 
+ * 创建灯效任务，需在 ws2812_init() 之后调用
+ * 
+ * @return
+ *     - ESP_OK: 成功
+ *     - ESP_FAIL: 任务创建失败
+ */
+esp_err_t led_effect_init(void);
+
+/**
+ * @brief 启动灯效
+ * 
+ * 替换当前正在运行的灯效，从头开始播放
+ * 
+ * @param config 灯效参数
+ * @return
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效
+ *     - ESP_ERR_INVALID_STATE: 未初始化
+ */
+esp_err_t led_effect_start(const led_effect_config_t *config);
+
+/**
+ * @brief 停止灯效
+ * 
+ * 停止后灯带保持最后一帧；返回前亮度已恢复为调色板原值，随后提交的手动帧按原亮度显示
+ * 
+ * @return
+ *     - ESP_OK: 成功
+ */
+esp_err_t led_effect_stop(void);
+
+/**
+ * @brief 获取当前灯效类型
+ * 
+ * @return 当前灯效，未运行时为 LED_EFFECT_NONE
+ */
+led_effect_type_t led_effect_get_current(void);
+
+/**
+ * @brief 根据名称查找灯效类型
+ * 
+ * @param name 灯效名称（"none"/"chase"/"fade"/"rainbow"/"breathing"）
+ * @return 灯效类型，未知名称返回 LED_EFFECT_MAX
+ */
+led_effect_type_t led_effect_from_name(const char *name);
+
+#endif // LED_EFFECT_H
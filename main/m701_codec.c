@@ -0,0 +1,117 @@
+/*
+ * M701SC 帧与负载编解码 - 实现文件
+ * 
+ * 数据帧格式 (17字节):
+ * B1:     0x3C (帧头)
+ * B2:     0x02
+ * B3-B4:  CO2 高/低字节
+ * B5-B6:  HCHO 高/低字节
+ * B7-B8:  TVOC 高/低字节
+ * B9-B10: PM2.5 高/低字节
+ * B11-B12: PM10 高/低字节
+ * B13:    温度整数 (bit7=1表示负数)
+ * B14:    温度小数
+ * B15:    湿度整数
+ * B16:    湿度小数
+ * B17:    校验和 (B1~B16之和的低8位)
+ */
+
+#include "m701_codec.h"
+#include <stdio.h>
+
+/**
+ * @brief 解析数据帧
+ */
+void m701_codec_parse_frame(const uint8_t *frame, m701_sensor_data_t *data)
+{
+    // 解析CO2 (B3-B4)
+    data->co2 = (frame[2] << 8) | frame[3];
+    
+    // 解析HCHO (B5-B6)
+    data->hcho = (frame[4] << 8) | frame[5];
+    
+    // 解析TVOC (B7-B8)
+    data->tvoc = (frame[6] << 8) | frame[7];
+    
+    // 解析PM2.5 (B9-B10)
+    data->pm25 = (frame[8] << 8) | frame[9];
+    
+    // 解析PM10 (B11-B12)
+    data->pm10 = (frame[10] << 8) | frame[11];
+    
+    // 解析温度 (B13-B14)
+    // B13 bit7=1表示负数
+    int8_t temp_int = frame[12];
+    uint8_t temp_dec = frame[13];
+    if (temp_int & 0x80) {
+        // 负数
+        data->temperature = -((temp_int & 0x7F) + temp_dec / 100.0f);
+    } else {
+        data->temperature = temp_int + temp_dec / 100.0f;
+    }
+    
+    // 解析湿度 (B15-B16)
+    data->humidity = frame[14] + frame[15] / 100.0f;
+    
+    data->valid = true;
+}
+
+/**
+ * @brief 将传感器数据格式化为JSON字符串
+ */
+int m701_codec_to_json(const m701_sensor_data_t *data, char *buf, size_t buf_size)
+{
+    if (!data || !buf || buf_size == 0) {
+        return 0;
+    }
+    
+    return snprintf(buf, buf_size,
+        "{\"co2\":%d,\"hcho\":%d,\"tvoc\":%d,\"pm25\":%d,\"pm10\":%d,\"temp\":%.1f,\"humi\":%.1f}",
+        data->co2, data->hcho, data->tvoc, data->pm25, data->pm10,
+        data->temperature, data->humidity);
+}
+
+/**
+ * @brief 小端写入16位值
+ */
+static void put_le16(uint8_t *buf, uint16_t value)
+{
+    buf[0] = value & 0xFF;
+    buf[1] = value >> 8;
+}
+
+/**
+ * @brief 将传感器数据编码为紧凑二进制
+ */
+int m701_codec_to_binary(const m701_sensor_data_t *data, uint8_t *buf, size_t buf_size)
+{
+    if (!data || !buf || buf_size < M701_BIN_SAMPLE_LEN) {
+        return 0;
+    }
+    
+    buf[0] = M701_BIN_VERSION;
+    buf[1] = M701_BIN_TYPE_SAMPLE;
+    put_le16(&buf[2], data->co2);
+    put_le16(&buf[4], data->hcho);
+    put_le16(&buf[6], data->tvoc);
+    put_le16(&buf[8], data->pm25);
+    put_le16(&buf[10], data->pm10);
+    put_le16(&buf[12], (uint16_t)(int16_t)M701_TO_CENTI(data->temperature));
+    put_le16(&buf[14], (uint16_t)M701_TO_CENTI(data->humidity));
+    
+    return M701_BIN_SAMPLE_LEN;
+}
+
+/**
+ * @brief 按指定格式编码传感器数据
+ */
+int m701_codec_encode(const m701_sensor_data_t *data, m701_payload_format_t format,
+                      uint8_t *buf, size_t buf_size)
+{
+    if (format == M701_PAYLOAD_BINARY) {
+        return m701_codec_to_binary(data, buf, buf_size);
+    }
+    
+    int len = m701_codec_to_json(data, (char*)buf, buf_size);
+    return (len > 0 && (size_t)len < buf_size) ? len : 0;
+}
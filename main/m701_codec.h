@@ -0,0 +1,111 @@
+/*
+ * M701SC 帧与负载编解码 - 头文件
+ * 
+ * 功能：M701数据帧解析、JSON/二进制负载编码，与ESP-IDF无关
+ * （m701_sensor 和遥测模块使用，也可在主机上编译）
+ * 
+ * 数据帧：17字节，帧头 0x3C 0x02，B1~B16之和校验
+ */
+
+#ifndef M701_CODEC_H
+#define M701_CODEC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sensor_frame.h"
+
+/* 帧格式 */
+#define M701_FRAME_SIZE         17              // 数据帧长度
+#define M701_FRAME_HEADER       0x3C            // 帧头
+
+/* 二进制负载格式 */
+#define M701_BIN_VERSION        0x01            // 格式版本
+#define M701_BIN_TYPE_SAMPLE    0x01            // 单个样本
+#define M701_BIN_TYPE_BATCH     0x02            // 聚合批次（见 sensor_telemetry.h）
+#define M701_BIN_HEADER_LEN     2               // 版本(1) + 类型(1)
+#define M701_BIN_SAMPLE_LEN     (M701_BIN_HEADER_LEN + 14)
+
+/* 温湿度定点化：0.01单位，四舍五入 */
+#define M701_TO_CENTI(v)        ((int32_t)((v) * 100.0f + ((v) >= 0 ? 0.5f : -0.5f)))
+
+/* M701帧格式初始化（sensor_frame_format_t） */
+#define M701_FRAME_FORMAT() {                       \
+    .header = { M701_FRAME_HEADER, 0x02 },          \
+    .header_len = 2,                                \
+    .frame_len = M701_FRAME_SIZE,                   \
+    .checksum = sensor_frame_checksum_sum8,         \
+}
+
+/**
+ * @brief 传感器数据负载格式
+ */
+typedef enum {
+    M701_PAYLOAD_JSON = 0,      // JSON文本（兼容模式）
+    M701_PAYLOAD_BINARY,        // 紧凑二进制
+} m701_payload_format_t;
+
+/**
+ * @brief M701传感器数据结构
+ */
+typedef struct {
+    uint16_t co2;           // CO2浓度 (ppm)
+    uint16_t hcho;          // 甲醛浓度 (µg/m³)
+    uint16_t tvoc;          // TVOC浓度 (µg/m³)
+    uint16_t pm25;          // PM2.5浓度 (µg/m³)
+    uint16_t pm10;          // PM10浓度 (µg/m³)
+    float temperature;      // 温度 (°C)
+    float humidity;         // 湿度 (%RH)
+    bool valid;             // 数据是否有效
+} m701_sensor_data_t;
+
+/**
+ * @brief 解析数据帧
+ * 
+ * 调用前帧头和校验和应已校验（见 M701_FRAME_FORMAT）
+ * 
+ * @param frame 数据帧（M701_FRAME_SIZE 字节）
+ * @param data 输出数据
+ */
+void m701_codec_parse_frame(const uint8_t *frame, m701_sensor_data_t *data);
+
+/**
+ * @brief 将传感器数据格式化为JSON字符串
+ * 
+ * @param data 传感器数据指针
+ * @param buf 输出缓冲区
+ * @param buf_size 缓冲区大小
+ * @return 写入的字符数
+ */
+int m701_codec_to_json(const m701_sensor_data_t *data, char *buf, size_t buf_size);
+
+/**
+ * @brief 将传感器数据编码为紧凑二进制
+ * 
+ * 格式（多字节字段均为小端）：
+ * B0: 版本 M701_BIN_VERSION
+ * B1: 类型 M701_BIN_TYPE_SAMPLE
+ * B2-B11: CO2, HCHO, TVOC, PM2.5, PM10 (uint16)
+ * B12-B13: 温度 (int16, 0.01°C)
+ * B14-B15: 湿度 (uint16, 0.01%RH)
+ * 
+ * @param data 传感器数据指针
+ * @param buf 输出缓冲区
+ * @param buf_size 缓冲区大小（至少 M701_BIN_SAMPLE_LEN）
+ * @return 写入的字节数，缓冲区不足返回0
+ */
+int m701_codec_to_binary(const m701_sensor_data_t *data, uint8_t *buf, size_t buf_size);
+
+/**
+ * @brief 按指定格式编码传感器数据
+ * 
+ * @param data 传感器数据指针
+ * @param format 负载格式
+ * @param buf 输出缓冲区
+ * @param buf_size 缓冲区大小
+ * @return 写入的字节数（JSON不含结束符）
+ */
+int m701_codec_encode(const m701_sensor_data_t *data, m701_payload_format_t format,
+                      uint8_t *buf, size_t buf_size);
+
+#endif // M701_CODEC_H
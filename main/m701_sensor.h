@@ -1,11 +1,11 @@
 /*
  * M701SC 7合一空气质量传感器驱动 - 头文件
  * 
- * 功能：通过UART读取M701SC传感器数据
+ * 功能：M701SC传感器的帧格式驱动，挂在 sensor_hub 的UART总线上
  * 
  * 测量项：CO2, HCHO, TVOC, PM2.5, PM10, 温度, 湿度
  * 通信协议：UART 9600 bps, 8N1
- * 数据帧：17字节，帧头0x3C
+ * 数据帧：17字节，帧头0x3C（解析和负载编码见 m701_codec.h）
  */
 
 #ifndef M701_SENSOR_H
@@ -15,46 +15,35 @@
 #include <stdbool.h>
 #include "esp_err.h"
 #include "driver/gpio.h"
+#include "m701_codec.h"
 
 /* 配置参数 */
 #define M701_UART_NUM           UART_NUM_1      // 使用UART1
 #define M701_UART_RX_PIN        GPIO_NUM_3      // RX引脚
 #define M701_UART_BAUD_RATE     9600            // 波特率
-#define M701_FRAME_SIZE         17              // 数据帧长度
-#define M701_FRAME_HEADER       0x3C            // 帧头
+#define M701_RX_TIMEOUT_CHARS   3               // 线路空闲多少个字符时间视为一帧结束
+#define M701_FRAME_PERIOD_MS    1000            // 传感器发帧周期(ms)，用于低功耗接收调度
 
 /**
- * @brief M701传感器数据结构
+ * @brief 带版本号的传感器数据快照
  */
 typedef struct {
-    uint16_t co2;           // CO2浓度 (ppm)
-    uint16_t hcho;          // 甲醛浓度 (µg/m³)
-    uint16_t tvoc;          // TVOC浓度 (µg/m³)
-    uint16_t pm25;          // PM2.5浓度 (µg/m³)
-    uint16_t pm10;          // PM10浓度 (µg/m³)
-    float temperature;      // 温度 (°C)
-    float humidity;         // 湿度 (%RH)
-    bool valid;             // 数据是否有效
-} m701_sensor_data_t;
-
-/**
- * @brief 传感器数据回调函数类型
- * 
- * @param data 传感器数据指针
- */
-typedef void (*m701_data_callback_t)(const m701_sensor_data_t *data);
+    m701_sensor_data_t data;    // 传感器数据
+    uint32_t generation;        // 代数，每收到一帧有效数据加1，0表示尚无数据
+    int64_t timestamp_us;       // 收到该帧的时间 (esp_timer_get_time)
+} m701_sensor_snapshot_t;
 
 /**
  * @brief 初始化M701传感器
  * 
- * 配置UART并启动数据读取任务
+ * 添加UART总线（UART1/GPIO3）并注册M701帧格式，需在 sensor_hub_init 之后调用。
+ * 样本通过 sensor_hub 的批回调送达应用层
  * 
- * @param callback 数据回调函数（收到有效数据时调用）
  * @return 
  *     - ESP_OK: 成功
- *     - ESP_FAIL: 失败
+ *     - 其他: sensor_hub 错误
  */
-esp_err_t m701_sensor_init(m701_data_callback_t callback);
+esp_err_t m701_sensor_init(void);
 
 /**
  * @brief 获取最新的传感器数据
@@ -67,14 +56,25 @@ esp_err_t m701_sensor_init(m701_data_callback_t callback);
 esp_err_t m701_sensor_get_data(m701_sensor_data_t *data);
 
 /**
- * @brief 将传感器数据格式化为JSON字符串
+ * @brief 获取最新数据快照
+ * 
+ * 无锁读取，可在任意任务中调用，不会阻塞UART任务，也不会读到写了一半的数据
+ * 
+ * @param snapshot 输出快照
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_STATE: 尚无有效数据或未初始化
+ */
+esp_err_t m701_sensor_get_snapshot(m701_sensor_snapshot_t *snapshot);
+
+/**
+ * @brief 获取当前数据代数
+ * 
+ * 与上次读到的 generation 比较即可判断是否有新样本，开销只有一次原子读
  * 
- * @param data 传感器数据指针
- * @param buf 输出缓冲区
- * @param buf_size 缓冲区大小
- * @return 写入的字符数
+ * @return 代数，0表示尚无数据
  */
-int m701_sensor_to_json(const m701_sensor_data_t *data, char *buf, size_t buf_size);
+uint32_t m701_sensor_get_generation(void);
 
 #endif // M701_SENSOR_H
 
@@ -0,0 +1,353 @@
+/*
+ * 运行统计 - 实现文件
+ * 
+ * 计数器用原子加；延迟在RMT ISR中也会记录，用临界区保护；
+ * 任务栈、传感器和离线队列统计在采集快照时才读取，平时没有额外开销
+ */
+
+#include "metrics.h"
+#include "sensor_hub.h"
+#include "mqtt_outbox.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <stdio.h>
+
+/* 日志标签 */
+static const char* TAG = "METRICS";
+
+/**
+ * @brief 延迟累计值
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+} latency_acc_t;
+
+/* JSON中的名称，与枚举顺序一致 */
+static const char *s_counter_names[METRICS_COUNTER_MAX] = {
+    [METRICS_COUNTER_MQTT_PUBLISH_FAIL] = "mqtt_pub_fail",
+    [METRICS_COUNTER_BLE_NOTIFY_FAIL] = "ble_notify_fail",
+    [METRICS_COUNTER_CMD_DROPPED] = "cmd_dropped",
+};
+
+static const char *s_latency_names[METRICS_LATENCY_MAX] = {
+    [METRICS_LATENCY_LED_FRAME] = "led",
+    [METRICS_LATENCY_SERVO_CMD] = "servo",
+};
+
+/* 全局变量 */
+static uint32_t s_counters[METRICS_COUNTER_MAX];
+static latency_acc_t s_latency[METRICS_LATENCY_MAX];
+static portMUX_TYPE s_latency_lock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t s_lock = NULL;         // 保护以下采集缓冲（统计任务和BLE任务都会采集）
+static metrics_publish_t s_publish = NULL;
+static metrics_snapshot_t s_snapshot;
+static uint8_t s_bin[METRICS_BIN_MAX_LEN];
+static uint16_t s_bin_len = 0;
+static int64_t s_bin_time_us = 0;
+static char s_json[METRICS_JSON_MAX];
+#if configUSE_TRACE_FACILITY
+static TaskStatus_t s_task_status[METRICS_MAX_TASKS];
+#endif
+
+/**
+ * @brief 计数器加一
+ */
+void metrics_count(metrics_counter_t counter)
+{
+    if (counter < METRICS_COUNTER_MAX) {
+        __atomic_fetch_add(&s_counters[counter], 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief 记录一次延迟
+ */
+IRAM_ATTR void metrics_record_latency(metrics_latency_t id, uint32_t latency_us)
+{
+    if (id >= METRICS_LATENCY_MAX) {
+        return;
+    }
+    
+    portENTER_CRITICAL_SAFE(&s_latency_lock);
+    latency_acc_t *acc = &s_latency[id];
+    if (acc->count == 0 || latency_us < acc->min_us) {
+        acc->min_us = latency_us;
+    }
+    if (latency_us > acc->max_us) {
+        acc->max_us = latency_us;
+    }
+    acc->sum_us += latency_us;
+    acc->count++;
+    portEXIT_CRITICAL_SAFE(&s_latency_lock);
+}
+
+/**
+ * @brief 记录从 start_us 到现在的延迟
+ */
+IRAM_ATTR void metrics_record_since(metrics_latency_t id, int64_t start_us)
+{
+    int64_t elapsed = esp_timer_get_time() - start_us;
+    metrics_record_latency(id, elapsed < 0 ? 0 : (elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed));
+}
+
+/**
+ * @brief 采集各任务栈低水位（调用者需持有s_lock）
+ */
+static void collect_tasks(metrics_snapshot_t *snapshot)
+{
+    snapshot->task_count = 0;
+#if configUSE_TRACE_FACILITY
+    // 数组小于任务数时返回0，不报告部分结果
+    UBaseType_t count = uxTaskGetSystemState(s_task_status, METRICS_MAX_TASKS, NULL);
+    if (count == 0) {
+        ESP_LOGW(TAG, "More than %d tasks, stack stats skipped", METRICS_MAX_TASKS);
+        return;
+    }
+    for (UBaseType_t i = 0; i < count; i++) {
+        metrics_task_stats_t *task = &snapshot->tasks[i];
+        strlcpy(task->name, s_task_status[i].pcTaskName, sizeof(task->name));
+        task->stack_free = s_task_status[i].usStackHighWaterMark;   // ESP-IDF中单位为字节
+    }
+    snapshot->task_count = count;
+#endif
+}
+
+/**
+ * @brief 采集快照（调用者需持有s_lock）
+ */
+static void collect_snapshot(metrics_snapshot_t *snapshot)
+{
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->uptime_s = esp_timer_get_time() / 1000000;
+    snapshot->heap_free = esp_get_free_heap_size();
+    snapshot->heap_min = esp_get_minimum_free_heap_size();
+    
+    for (int i = 0; i < METRICS_COUNTER_MAX; i++) {
+        snapshot->counters[i] = __atomic_load_n(&s_counters[i], __ATOMIC_RELAXED);
+    }
+    
+    latency_acc_t latency[METRICS_LATENCY_MAX];
+    portENTER_CRITICAL(&s_latency_lock);
+    memcpy(latency, s_latency, sizeof(latency));
+    portEXIT_CRITICAL(&s_latency_lock);
+    for (int i = 0; i < METRICS_LATENCY_MAX; i++) {
+        snapshot->latency[i].count = latency[i].count;
+        snapshot->latency[i].min_us = latency[i].min_us;
+        snapshot->latency[i].max_us = latency[i].max_us;
+        snapshot->latency[i].avg_us = latency[i].count ? latency[i].sum_us / latency[i].count : 0;
+    }
+    
+    int bus_count = sensor_hub_get_bus_count();
+    for (int i = 0; i < bus_count; i++) {
+        sensor_bus_stats_t bus;
+        if (sensor_hub_get_bus_stats(i, &bus) == ESP_OK) {
+            snapshot->sensor_frames += bus.frames;
+            snapshot->sensor_checksum_errors += bus.checksum_errors;
+            snapshot->sensor_overflows += bus.overflows;
+        }
+    }
+    
+    mqtt_outbox_stats_t outbox;
+    mqtt_outbox_get_stats(&outbox);
+    snapshot->mqtt_queue_pending = outbox.ram_pending + outbox.flash_pending;
+    snapshot->mqtt_queue_dropped = outbox.dropped;
+    
+    collect_tasks(snapshot);
+}
+
+/**
+ * @brief 采集统计快照
+ */
+void metrics_get_snapshot(metrics_snapshot_t *snapshot)
+{
+    if (!snapshot) {
+        return;
+    }
+    if (s_lock) {
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+    }
+    collect_snapshot(snapshot);
+    if (s_lock) {
+        xSemaphoreGive(s_lock);
+    }
+}
+
+/**
+ * @brief 把快照编码为JSON
+ */
+int metrics_format_json(const metrics_snapshot_t *snapshot, char *buf, size_t size)
+{
+    if (!snapshot || !buf || size == 0) {
+        return -1;
+    }
+    
+    int len = snprintf(buf, size, "{\"uptime\":%lu,\"heap\":{\"free\":%lu,\"min\":%lu}",
+                       (unsigned long)snapshot->uptime_s, (unsigned long)snapshot->heap_free,
+                       (unsigned long)snapshot->heap_min);
+    for (int i = 0; i < METRICS_COUNTER_MAX && len < size; i++) {
+        len += snprintf(buf + len, size - len, ",\"%s\":%lu", s_counter_names[i],
+                        (unsigned long)snapshot->counters[i]);
+    }
+    for (int i = 0; i < METRICS_LATENCY_MAX && len < size; i++) {
+        const metrics_latency_stats_t *lat = &snapshot->latency[i];
+        len += snprintf(buf + len, size - len, ",\"%s\":{\"n\":%lu,\"min\":%lu,\"max\":%lu,\"avg\":%lu}",
+                        s_latency_names[i], (unsigned long)lat->count, (unsigned long)lat->min_us,
+                        (unsigned long)lat->max_us, (unsigned long)lat->avg_us);
+    }
+    if (len < size) {
+        len += snprintf(buf + len, size - len,
+                        ",\"sensor\":{\"ok\":%lu,\"checksum\":%lu,\"overflow\":%lu}"
+                        ",\"mqtt_queue\":{\"pending\":%lu,\"dropped\":%lu},\"stack\":{",
+                        (unsigned long)snapshot->sensor_frames, (unsigned long)snapshot->sensor_checksum_errors,
+                        (unsigned long)snapshot->sensor_overflows, (unsigned long)snapshot->mqtt_queue_pending,
+                        (unsigned long)snapshot->mqtt_queue_dropped);
+    }
+    for (int i = 0; i < snapshot->task_count && len < size; i++) {
+        len += snprintf(buf + len, size - len, "%s\"%s\":%lu", i > 0 ? "," : "",
+                        snapshot->tasks[i].name, (unsigned long)snapshot->tasks[i].stack_free);
+    }
+    if (len < size) {
+        len += snprintf(buf + len, size - len, "}}");
+    }
+    
+    return len < size ? len : -1;
+}
+
+/**
+ * @brief 小端写入16位值
+ */
+static uint8_t *put_le16(uint8_t *buf, uint16_t value)
+{
+    buf[0] = value & 0xFF;
+    buf[1] = value >> 8;
+    return buf + 2;
+}
+
+/**
+ * @brief 小端写入32位值
+ */
+static uint8_t *put_le32(uint8_t *buf, uint32_t value)
+{
+    buf = put_le16(buf, value & 0xFFFF);
+    return put_le16(buf, value >> 16);
+}
+
+/**
+ * @brief 快照编码为二进制，格式见 metrics.h
+ */
+static uint16_t snapshot_to_binary(const metrics_snapshot_t *snapshot, uint8_t *buf)
+{
+    uint8_t *p = buf;
+    *p++ = METRICS_BIN_VERSION;
+    p = put_le32(p, snapshot->uptime_s);
+    p = put_le32(p, snapshot->heap_free);
+    p = put_le32(p, snapshot->heap_min);
+    for (int i = 0; i < METRICS_COUNTER_MAX; i++) {
+        p = put_le32(p, snapshot->counters[i]);
+    }
+    for (int i = 0; i < METRICS_LATENCY_MAX; i++) {
+        p = put_le32(p, snapshot->latency[i].count);
+        p = put_le32(p, snapshot->latency[i].min_us);
+        p = put_le32(p, snapshot->latency[i].max_us);
+        p = put_le32(p, snapshot->latency[i].avg_us);
+    }
+    p = put_le32(p, snapshot->sensor_frames);
+    p = put_le32(p, snapshot->sensor_checksum_errors);
+    p = put_le32(p, snapshot->sensor_overflows);
+    p = put_le32(p, snapshot->mqtt_queue_pending);
+    p = put_le32(p, snapshot->mqtt_queue_dropped);
+    
+    *p++ = snapshot->task_count;
+    for (int i = 0; i < snapshot->task_count; i++) {
+        strncpy((char *)p, snapshot->tasks[i].name, METRICS_TASK_NAME_LEN);   // 不足补0，超长截断
+        p += METRICS_TASK_NAME_LEN;
+        uint32_t stack_free = snapshot->tasks[i].stack_free;
+        p = put_le16(p, stack_free > UINT16_MAX ? UINT16_MAX : stack_free);
+    }
+    return p - buf;
+}
+
+/**
+ * @brief 读取二进制快照的一段
+ */
+uint16_t metrics_read_binary(uint16_t offset, uint8_t *out, uint16_t max_len)
+{
+    if (!out || !s_lock) {
+        return 0;
+    }
+    
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    
+    // 长读取的后续分段沿用同一份快照
+    int64_t now = esp_timer_get_time();
+    if (s_bin_len == 0 || (offset == 0 && now - s_bin_time_us > METRICS_BIN_CACHE_MS * 1000LL)) {
+        collect_snapshot(&s_snapshot);
+        s_bin_len = snapshot_to_binary(&s_snapshot, s_bin);
+        s_bin_time_us = now;
+    }
+    
+    uint16_t len = 0;
+    if (offset < s_bin_len) {
+        len = s_bin_len - offset < max_len ? s_bin_len - offset : max_len;
+        memcpy(out, s_bin + offset, len);
+    }
+    
+    xSemaphoreGive(s_lock);
+    return len;
+}
+
+/**
+ * @brief 统计发布任务
+ */
+static void metrics_task(void *arg)
+{
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(METRICS_PUBLISH_INTERVAL_MS));
+        
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        collect_snapshot(&s_snapshot);
+        int len = metrics_format_json(&s_snapshot, s_json, sizeof(s_json));
+        xSemaphoreGive(s_lock);
+        
+        // s_json 只在本任务中使用，发布可能阻塞在网络上，不持锁
+        if (len > 0) {
+            s_publish(s_json, len);
+        } else {
+            ESP_LOGW(TAG, "Stats JSON exceeds %d bytes", METRICS_JSON_MAX);
+        }
+    }
+}
+
+/**
+ * @brief 初始化运行统计
+ */
+esp_err_t metrics_init(metrics_publish_t publish)
+{
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock) {
+        ESP_LOGE(TAG, "Failed to create mutex");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    s_publish = publish;
+    if (publish) {
+        BaseType_t xReturned = xTaskCreate(metrics_task, "metrics", METRICS_TASK_STACK, NULL,
+                                           METRICS_TASK_PRIO, NULL);
+        if (xReturned != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create metrics task");
+            return ESP_FAIL;
+        }
+    }
+    
+    ESP_LOGI(TAG, "Metrics initialized (publish every %d s)", METRICS_PUBLISH_INTERVAL_MS / 1000);
+    return ESP_OK;
+}
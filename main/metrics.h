@@ -0,0 +1,171 @@
+/*
+ * 运行统计 - 头文件
+ * 
+ * 功能：轻量级性能计数，用于现场设备发现性能退化
+ * - 计数器：MQTT发布失败、BLE通知失败、命令池丢弃
+ * - 延迟：LED帧提交→发送完成、舵机命令接收→执行，记录次数/最小/最大/平均
+ * - 采集时汇总：传感器帧（有效/校验失败/FIFO溢出）、离线队列深度、堆内存低水位、各任务栈低水位
+ * 
+ * 读取：BLE运行统计特征值（0xFF0A，二进制，见下）和周期发布的 MQTT <prefix>/stats（JSON）
+ * 
+ * 二进制快照（小端）：
+ * [版本 0x01][运行时间 u32, s][空闲堆 u32][最低空闲堆 u32]
+ * [计数器 u32 x METRICS_COUNTER_MAX，按 metrics_counter_t 顺序]
+ * [延迟 x METRICS_LATENCY_MAX，按 metrics_latency_t 顺序，每项 次数/最小/最大/平均 u32, us]
+ * [传感器 有效帧/校验失败/溢出 u32][离线队列 待发/丢弃 u32]
+ * [任务数 u8][每个任务 名称 METRICS_TASK_NAME_LEN 字节（不足补0）+ 栈低水位 u16, 字节]
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+/* 配置参数 */
+#define METRICS_PUBLISH_INTERVAL_MS     60000       // MQTT统计发布周期(ms)
+#define METRICS_TASK_STACK              3072        // 发布任务栈大小
+#define METRICS_TASK_PRIO               2           // 发布任务优先级（低于业务任务）
+#define METRICS_MAX_TASKS               24          // 栈低水位最多统计的任务数
+#define METRICS_TASK_NAME_LEN           12          // 二进制快照中的任务名长度
+#define METRICS_JSON_MAX                1024        // JSON快照最大长度
+#define METRICS_BIN_VERSION             0x01        // 二进制快照版本
+#define METRICS_BIN_CACHE_MS            1000        // 二进制快照缓存时间(ms)，保证一次长读取内容一致
+
+/**
+ * @brief 计数器
+ */
+typedef enum {
+    METRICS_COUNTER_MQTT_PUBLISH_FAIL = 0,  // MQTT发布失败
+    METRICS_COUNTER_BLE_NOTIFY_FAIL,        // BLE通知发送失败
+    METRICS_COUNTER_CMD_DROPPED,            // 命令池耗尽丢弃的命令
+    METRICS_COUNTER_MAX,
+} metrics_counter_t;
+
+/**
+ * @brief 延迟统计项
+ */
+typedef enum {
+    METRICS_LATENCY_LED_FRAME = 0,          // LED帧：提交（含暂存等待）→ RMT发送完成
+    METRICS_LATENCY_SERVO_CMD,              // 舵机命令：BLE/MQTT接收 → 驱动执行
+    METRICS_LATENCY_MAX,
+} metrics_latency_t;
+
+/* 二进制快照最大长度 */
+#define METRICS_BIN_MAX_LEN     (1 + 12 + METRICS_COUNTER_MAX * 4 + METRICS_LATENCY_MAX * 16 + 20 + \
+                                 1 + METRICS_MAX_TASKS * (METRICS_TASK_NAME_LEN + 2))
+
+/**
+ * @brief 延迟统计（自启动以来）
+ */
+typedef struct {
+    uint32_t count;             // 次数
+    uint32_t min_us;            // 最小延迟(us)，count为0时为0
+    uint32_t max_us;            // 最大延迟(us)
+    uint32_t avg_us;            // 平均延迟(us)
+} metrics_latency_stats_t;
+
+/**
+ * @brief 任务栈低水位
+ */
+typedef struct {
+    char name[16];              // 任务名
+    uint32_t stack_free;        // 运行以来栈最少剩余(字节)
+} metrics_task_stats_t;
+
+/**
+ * @brief 统计快照
+ */
+typedef struct {
+    uint32_t uptime_s;                                  // 运行时间(s)
+    uint32_t heap_free;                                 // 当前空闲堆(字节)
+    uint32_t heap_min;                                  // 运行以来最低空闲堆(字节)
+    uint32_t counters[METRICS_COUNTER_MAX];
+    metrics_latency_stats_t latency[METRICS_LATENCY_MAX];
+    uint32_t sensor_frames;                             // 传感器有效帧（所有总线）
+    uint32_t sensor_checksum_errors;                    // 帧头匹配但校验失败
+    uint32_t sensor_overflows;                          // UART FIFO溢出/缓冲区满
+    uint32_t mqtt_queue_pending;                        // 离线队列待发条数（RAM+Flash）
+    uint32_t mqtt_queue_dropped;                        // 离线队列丢弃条数
+    uint8_t task_count;                                 // tasks 有效个数，未启用 CONFIG_FREERTOS_USE_TRACE_FACILITY 时为0
+    metrics_task_stats_t tasks[METRICS_MAX_TASKS];
+} metrics_snapshot_t;
+
+/**
+ * @brief 统计发布回调函数类型
+ * 
+ * 在统计任务中每 METRICS_PUBLISH_INTERVAL_MS 调用一次
+ * 
+ * @param json JSON快照
+ * @param len 长度
+ */
+typedef void (*metrics_publish_t)(const char *json, int len);
+
+/**
+ * @brief 初始化运行统计
+ * 
+ * 计数和延迟记录在初始化前即可调用；publish 不为NULL时创建周期发布任务
+ * 
+ * @param publish 发布回调，可为NULL
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_NO_MEM: 内存不足
+ *     - ESP_FAIL: 任务创建失败
+ */
+esp_err_t metrics_init(metrics_publish_t publish);
+
+/**
+ * @brief 计数器加一（任务上下文）
+ * 
+ * @param counter 计数器
+ */
+void metrics_count(metrics_counter_t counter);
+
+/**
+ * @brief 记录一次延迟（任务或ISR上下文，IRAM安全）
+ * 
+ * @param id 统计项
+ * @param latency_us 延迟(us)
+ */
+void metrics_record_latency(metrics_latency_t id, uint32_t latency_us);
+
+/**
+ * @brief 记录从 start_us 到现在的延迟（任务或ISR上下文，IRAM安全）
+ * 
+ * @param id 统计项
+ * @param start_us 起始时间 (esp_timer_get_time)
+ */
+void metrics_record_since(metrics_latency_t id, int64_t start_us);
+
+/**
+ * @brief 采集统计快照
+ * 
+ * @param snapshot 输出快照
+ */
+void metrics_get_snapshot(metrics_snapshot_t *snapshot);
+
+/**
+ * @brief 把快照编码为JSON
+ * 
+ * @param snapshot 快照
+ * @param buf 输出缓冲区
+ * @param size 缓冲区大小
+ * @return 写入长度（不含结束符），缓冲区不足返回-1
+ */
+int metrics_format_json(const metrics_snapshot_t *snapshot, char *buf, size_t size);
+
+/**
+ * @brief 读取二进制快照的一段（BLE读取用）
+ * 
+ * offset 为0且缓存超过 METRICS_BIN_CACHE_MS 时重新采集，否则返回缓存内容
+ * 
+ * @param offset 起始偏移
+ * @param out 输出缓冲区
+ * @param max_len 最多读取字节数
+ * @return 实际读取字节数，offset 超出快照长度时为0
+ */
+uint16_t metrics_read_binary(uint16_t offset, uint8_t *out, uint16_t max_len);
+
+#endif // METRICS_H
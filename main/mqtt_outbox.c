@@ -0,0 +1,486 @@
+/*
+ * MQTT离线发送队列 - 实现文件
+ * 
+ * 顺序：RAM环保存最早的消息，Flash保存之后的消息。Flash中有记录时新消息一律写Flash，
+ * 补发先取RAM再取Flash，整体保持入队顺序。
+ * 
+ * Flash记录（mqtt_spill 分区按 MQTT_OUTBOX_FLASH_SLOT_SIZE 切成固定槽位，循环使用）：
+ * [magic u32][seq u32][crc u32][len u16][qos u8][topic_len u8][state u8][保留 3][主题][负载]
+ * - 先写整条记录（magic 保持 0xFFFFFFFF），最后单独写 magic，掉电写一半的记录不会被当成有效
+ * - 发送后把 state 从 0xFF 改写为 0x00（Flash位只能1→0，无需擦除）
+ * - 写指针进入新扇区前擦除该扇区；若最早的待发记录在该扇区内则整扇区丢弃（覆盖最旧）
+ * - 上电扫描全部槽位：最大 seq 之后为写指针，最小的待发 seq 为读指针
+ * - s_flash_count 只计待发记录；掉电后跳过的空白/半写槽位不计数，读指针经过时直接跳过
+ */
+
+#include "mqtt_outbox.h"
+#include "mqtt_wrapper.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <stddef.h>
+#include <assert.h>
+
+/* 日志标签 */
+static const char* TAG = "MQTT_OUTBOX";
+
+/* Flash记录 */
+#define SPILL_MAGIC             0x4D514F42      // "MQOB"
+#define SPILL_STATE_PENDING     0xFF
+#define SPILL_STATE_SENT        0x00
+#define SPILL_SECTOR_SIZE       4096
+#define SPILL_SLOTS_PER_SECTOR  (SPILL_SECTOR_SIZE / MQTT_OUTBOX_FLASH_SLOT_SIZE)
+
+/**
+ * @brief Flash记录头
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t crc;               // 主题+负载的CRC32
+    uint16_t len;
+    uint8_t qos;
+    uint8_t topic_len;
+    uint8_t state;
+    uint8_t reserved[3];
+} spill_header_t;
+
+#define SPILL_STATE_OFFSET      offsetof(spill_header_t, state)
+
+static_assert(sizeof(spill_header_t) + MQTT_OUTBOX_TOPIC_MAX + MQTT_OUTBOX_PAYLOAD_MAX <= MQTT_OUTBOX_FLASH_SLOT_SIZE,
+              "flash slot too small");
+static_assert(SPILL_SECTOR_SIZE % MQTT_OUTBOX_FLASH_SLOT_SIZE == 0, "slot must divide sector");
+
+/**
+ * @brief RAM消息
+ */
+typedef struct {
+    char topic[MQTT_OUTBOX_TOPIC_MAX];
+    uint8_t payload[MQTT_OUTBOX_PAYLOAD_MAX];
+    uint16_t len;
+    uint8_t qos;
+} outbox_msg_t;
+
+/* RAM环 */
+static outbox_msg_t s_ram[MQTT_OUTBOX_RAM_SLOTS];
+static uint32_t s_ram_head = 0;                 // 下一个写入位置
+static uint32_t s_ram_tail = 0;                 // 最早的消息
+static uint32_t s_ram_count = 0;
+
+/* Flash环 */
+static const esp_partition_t *s_part = NULL;
+static uint32_t s_flash_slots = 0;
+static uint32_t s_flash_head = 0;
+static uint32_t s_flash_tail = 0;
+static uint32_t s_flash_count = 0;
+static uint32_t s_next_seq = 1;
+
+/* 全局变量 */
+static SemaphoreHandle_t s_lock = NULL;
+static TaskHandle_t s_task = NULL;
+static volatile bool s_connected = false;
+static uint32_t s_sent = 0;
+static uint32_t s_dropped = 0;
+static outbox_msg_t s_tx;                       // 补发任务的发送缓冲，避免占用任务栈
+static uint8_t s_slot_buf[MQTT_OUTBOX_FLASH_SLOT_SIZE];     // Flash读写缓冲（持锁访问）
+
+/**
+ * @brief 槽位在分区内的偏移
+ */
+static size_t slot_offset(uint32_t slot)
+{
+    return (size_t)slot * MQTT_OUTBOX_FLASH_SLOT_SIZE;
+}
+
+/**
+ * @brief 槽位是否已擦除（全0xFF）
+ */
+static bool slot_is_blank(uint32_t slot)
+{
+    if (esp_partition_read(s_part, slot_offset(slot), s_slot_buf, MQTT_OUTBOX_FLASH_SLOT_SIZE) != ESP_OK) {
+        return false;
+    }
+    for (int i = 0; i < MQTT_OUTBOX_FLASH_SLOT_SIZE; i++) {
+        if (s_slot_buf[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 槽位是否为待发记录（计入 s_flash_count 的槽位）
+ */
+static bool slot_is_pending(uint32_t slot)
+{
+    spill_header_t hdr;
+    return esp_partition_read(s_part, slot_offset(slot), &hdr, sizeof(hdr)) == ESP_OK &&
+           hdr.magic == SPILL_MAGIC && hdr.state == SPILL_STATE_PENDING;
+}
+
+/**
+ * @brief 挂载溢出分区并恢复写/读指针
+ */
+static void spill_mount(void)
+{
+    s_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, MQTT_OUTBOX_PARTITION_SUBTYPE,
+                                      MQTT_OUTBOX_PARTITION);
+    if (!s_part) {
+        ESP_LOGW(TAG, "No %s partition, RAM queue only", MQTT_OUTBOX_PARTITION);
+        return;
+    }
+    s_flash_slots = (s_part->size / SPILL_SECTOR_SIZE) * SPILL_SLOTS_PER_SECTOR;
+    
+    bool any = false;
+    uint32_t max_seq = 0, max_slot = 0;
+    uint32_t min_pending = UINT32_MAX, min_slot = 0;
+    for (uint32_t slot = 0; slot < s_flash_slots; slot++) {
+        spill_header_t hdr;
+        if (esp_partition_read(s_part, slot_offset(slot), &hdr, sizeof(hdr)) != ESP_OK ||
+            hdr.magic != SPILL_MAGIC) {
+            continue;
+        }
+        if (!any || hdr.seq > max_seq) {
+            max_seq = hdr.seq;
+            max_slot = slot;
+        }
+        any = true;
+        if (hdr.state == SPILL_STATE_PENDING) {
+            s_flash_count++;
+            if (hdr.seq < min_pending) {
+                min_pending = hdr.seq;
+                min_slot = slot;
+            }
+        }
+    }
+    
+    s_flash_head = any ? (max_slot + 1) % s_flash_slots : 0;
+    s_flash_tail = s_flash_count > 0 ? min_slot : s_flash_head;
+    s_next_seq = max_seq + 1;
+    
+    // 掉电时写了一半的记录：跳到下一扇区重新开始写（中间的槽位不计数，spill_peek 跳过）
+    if (s_flash_head % SPILL_SLOTS_PER_SECTOR != 0 && !slot_is_blank(s_flash_head)) {
+        s_flash_head = (s_flash_head / SPILL_SLOTS_PER_SECTOR + 1) * SPILL_SLOTS_PER_SECTOR % s_flash_slots;
+        if (s_flash_count == 0) {
+            s_flash_tail = s_flash_head;
+        }
+    }
+    
+    ESP_LOGI(TAG, "Spill partition: %lu slots, %lu pending", s_flash_slots, s_flash_count);
+}
+
+/**
+ * @brief 写入一条Flash记录（持锁调用）
+ */
+static esp_err_t spill_push(const char *topic, const uint8_t *data, uint16_t len, uint8_t qos)
+{
+    uint32_t slot = s_flash_head;
+    
+    // 进入新扇区：最早的记录在该扇区内则整扇区丢弃，再擦除
+    if (slot % SPILL_SLOTS_PER_SECTOR == 0) {
+        uint32_t sector = slot / SPILL_SLOTS_PER_SECTOR;
+        if (s_flash_count > 0 && s_flash_tail / SPILL_SLOTS_PER_SECTOR == sector) {
+            // 只扣除实际的待发记录，掉电后跳过的槽位不在计数内
+            uint32_t lost = 0;
+            for (uint32_t i = s_flash_tail; i < (sector + 1) * SPILL_SLOTS_PER_SECTOR; i++) {
+                if (slot_is_pending(i)) {
+                    lost++;
+                }
+            }
+            if (lost > s_flash_count) {
+                lost = s_flash_count;
+            }
+            s_flash_count -= lost;
+            s_dropped += lost;
+            s_flash_tail = (sector + 1) * SPILL_SLOTS_PER_SECTOR % s_flash_slots;
+            ESP_LOGW(TAG, "Spill full, dropped %lu oldest messages", lost);
+        }
+        esp_err_t ret = esp_partition_erase_range(s_part, sector * SPILL_SECTOR_SIZE, SPILL_SECTOR_SIZE);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Spill erase failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+    
+    uint8_t topic_len = strlen(topic);
+    spill_header_t *hdr = (spill_header_t *)s_slot_buf;
+    memset(hdr, 0xFF, sizeof(*hdr));
+    hdr->seq = s_next_seq;
+    hdr->len = len;
+    hdr->qos = qos;
+    hdr->topic_len = topic_len;
+    memcpy(s_slot_buf + sizeof(*hdr), topic, topic_len);
+    memcpy(s_slot_buf + sizeof(*hdr) + topic_len, data, len);
+    hdr->crc = esp_rom_crc32_le(0, s_slot_buf + sizeof(*hdr), topic_len + len);
+    
+    // 先写记录体（magic 仍为全1），最后写 magic
+    size_t size = sizeof(*hdr) + topic_len + len;
+    esp_err_t ret = esp_partition_write(s_part, slot_offset(slot), s_slot_buf, size);
+    if (ret == ESP_OK) {
+        uint32_t magic = SPILL_MAGIC;
+        ret = esp_partition_write(s_part, slot_offset(slot), &magic, sizeof(magic));
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Spill write failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    if (s_flash_count == 0) {
+        s_flash_tail = slot;
+    }
+    s_flash_head = (slot + 1) % s_flash_slots;
+    s_flash_count++;
+    s_next_seq++;
+    return ESP_OK;
+}
+
+/**
+ * @brief 读取最早的Flash记录到 s_tx（持锁调用），损坏的记录跳过
+ * 
+ * 未计数的槽位（掉电后跳过的空白/半写槽位、已发送的记录）跳过但不减少计数
+ * 
+ * @param seq 输出记录序号，出队时校验
+ * @return true=读到有效记录
+ */
+static bool spill_peek(uint32_t *seq)
+{
+    while (s_flash_count > 0) {
+        uint32_t slot = s_flash_tail;
+        spill_header_t *hdr = (spill_header_t *)s_slot_buf;
+        esp_err_t ret = esp_partition_read(s_part, slot_offset(slot), s_slot_buf, MQTT_OUTBOX_FLASH_SLOT_SIZE);
+    
+        if (ret == ESP_OK && hdr->magic == SPILL_MAGIC && hdr->state == SPILL_STATE_PENDING &&
+            hdr->topic_len < MQTT_OUTBOX_TOPIC_MAX && hdr->len <= MQTT_OUTBOX_PAYLOAD_MAX &&
+            esp_rom_crc32_le(0, s_slot_buf + sizeof(*hdr), hdr->topic_len + hdr->len) == hdr->crc) {
+            memcpy(s_tx.topic, s_slot_buf + sizeof(*hdr), hdr->topic_len);
+            s_tx.topic[hdr->topic_len] = '\0';
+            memcpy(s_tx.payload, s_slot_buf + sizeof(*hdr) + hdr->topic_len, hdr->len);
+            s_tx.len = hdr->len;
+            s_tx.qos = hdr->qos;
+            *seq = hdr->seq;
+            return true;
+        }
+        
+        if (ret == ESP_OK && (hdr->magic != SPILL_MAGIC || hdr->state != SPILL_STATE_PENDING)) {
+            s_flash_tail = (slot + 1) % s_flash_slots;
+            if (s_flash_tail == s_flash_head) {
+                // 走到写指针仍未找齐：计数与Flash内容不符，以Flash为准
+                ESP_LOGW(TAG, "Spill count mismatch, %lu records missing", s_flash_count);
+                s_dropped += s_flash_count;
+                s_flash_count = 0;
+            }
+            continue;
+        }
+        
+        ESP_LOGW(TAG, "Corrupt spill record at slot %lu, skipped", slot);
+        s_dropped++;
+        s_flash_tail = (slot + 1) % s_flash_slots;
+        s_flash_count--;
+    }
+    return false;
+}
+
+/**
+ * @brief 标记最早的Flash记录已发送（持锁调用）
+ * 
+ * 发送期间写指针可能已覆盖该扇区，序号不符则说明记录已被丢弃
+ */
+static void spill_pop(uint32_t seq)
+{
+    if (s_flash_count == 0) {
+        return;
+    }
+    spill_header_t hdr;
+    uint32_t slot = s_flash_tail;
+    if (esp_partition_read(s_part, slot_offset(slot), &hdr, sizeof(hdr)) != ESP_OK ||
+        hdr.magic != SPILL_MAGIC || hdr.seq != seq) {
+        return;
+    }
+    
+    uint8_t state = SPILL_STATE_SENT;
+    esp_partition_write(s_part, slot_offset(slot) + SPILL_STATE_OFFSET, &state, sizeof(state));
+    s_flash_tail = (slot + 1) % s_flash_slots;
+    s_flash_count--;
+}
+
+/**
+ * @brief 取出最早的一条消息到 s_tx
+ * 
+ * @param from_flash 输出是否来自Flash
+ * @param seq 输出Flash记录序号
+ * @return true=有待发送消息
+ */
+static bool outbox_peek(bool *from_flash, uint32_t *seq)
+{
+    bool found = false;
+    
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (s_ram_count > 0) {
+        memcpy(&s_tx, &s_ram[s_ram_tail], sizeof(s_tx));
+        *from_flash = false;
+        found = true;
+    } else if (s_part && spill_peek(seq)) {
+        *from_flash = true;
+        found = true;
+    }
+    xSemaphoreGive(s_lock);
+    
+    return found;
+}
+
+/**
+ * @brief 出队已发送的消息
+ */
+static void outbox_pop(bool from_flash, uint32_t seq)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (from_flash) {
+        spill_pop(seq);
+    } else if (s_ram_count > 0) {
+        s_ram_tail = (s_ram_tail + 1) % MQTT_OUTBOX_RAM_SLOTS;
+        s_ram_count--;
+    }
+    s_sent++;
+    xSemaphoreGive(s_lock);
+}
+
+/**
+ * @brief 补发任务：连接后限速逐条发布
+ */
+static void outbox_task(void *arg)
+{
+    bool was_connected = false;
+    
+    while (1) {
+        if (!s_connected || mqtt_outbox_is_empty()) {
+            was_connected = s_connected;
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+    
+        // 刚连上：先让订阅和在线状态发布完成，补发不挤占控制主题
+        if (!was_connected) {
+            was_connected = true;
+            vTaskDelay(pdMS_TO_TICKS(MQTT_OUTBOX_RECONNECT_DELAY_MS));
+            continue;
+        }
+    
+        bool from_flash = false;
+        uint32_t seq = 0;
+        if (outbox_peek(&from_flash, &seq)) {
+            if (mqtt_client_publish(s_tx.topic, s_tx.payload, s_tx.len, s_tx.qos) == ESP_OK) {
+                outbox_pop(from_flash, seq);
+            } else {
+                // 发布失败多半是连接已断开，等待下一次连接通知
+                was_connected = false;
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MQTT_OUTBOX_RECONNECT_DELAY_MS));
+                continue;
+            }
+        }
+    
+        vTaskDelay(pdMS_TO_TICKS(MQTT_OUTBOX_DRAIN_INTERVAL_MS));
+    }
+}
+
+/**
+ * @brief 初始化离线发送队列
+ */
+esp_err_t mqtt_outbox_init(void)
+{
+    if (s_lock) {
+        return ESP_OK;
+    }
+    
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock) {
+        ESP_LOGE(TAG, "Failed to create mutex");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    spill_mount();
+    
+    BaseType_t xReturned = xTaskCreate(outbox_task, "mqtt_outbox", MQTT_OUTBOX_TASK_STACK, NULL,
+                                       MQTT_OUTBOX_TASK_PRIO, &s_task);
+    if (xReturned != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create outbox task");
+        vSemaphoreDelete(s_lock);
+        s_lock = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief 消息入队
+ */
+esp_err_t mqtt_outbox_enqueue(const char *topic, const uint8_t *data, int len, int qos)
+{
+    if (!s_lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!topic || !data || len < 0 || len > MQTT_OUTBOX_PAYLOAD_MAX ||
+        strlen(topic) >= MQTT_OUTBOX_TOPIC_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (s_flash_count == 0 && s_ram_count < MQTT_OUTBOX_RAM_SLOTS) {
+        outbox_msg_t *msg = &s_ram[s_ram_head];
+        strcpy(msg->topic, topic);
+        memcpy(msg->payload, data, len);
+        msg->len = len;
+        msg->qos = qos;
+        s_ram_head = (s_ram_head + 1) % MQTT_OUTBOX_RAM_SLOTS;
+        s_ram_count++;
+    } else if (s_part) {
+        ret = spill_push(topic, data, len, qos);
+    } else {
+        ret = ESP_ERR_NO_MEM;
+    }
+    xSemaphoreGive(s_lock);
+    
+    if (ret == ESP_OK && s_connected) {
+        xTaskNotifyGive(s_task);
+    }
+    return ret;
+}
+
+/**
+ * @brief 队列是否为空
+ */
+bool mqtt_outbox_is_empty(void)
+{
+    return s_ram_count == 0 && s_flash_count == 0;
+}
+
+/**
+ * @brief 通知连接状态变化
+ */
+void mqtt_outbox_notify_connected(bool connected)
+{
+    s_connected = connected;
+    if (s_task) {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+/**
+ * @brief 获取队列统计
+ */
+void mqtt_outbox_get_stats(mqtt_outbox_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    stats->ram_pending = s_ram_count;
+    stats->flash_pending = s_flash_count;
+    stats->flash_capacity = s_flash_slots;
+    stats->sent = s_sent;
+    stats->dropped = s_dropped;
+}
@@ -0,0 +1,90 @@
+/*
+ * MQTT离线发送队列 - 头文件
+ * 
+ * 功能：断网/断开Broker期间缓存待发布消息，重连后限速补发
+ * - RAM：固定大小的预分配消息环（最早的消息）
+ * - Flash：RAM满后溢出到 mqtt_spill 分区，断电不丢失
+ * - 补发：重连后等待订阅完成，再按固定间隔逐条发布，不冲击Broker、不挤占控制主题
+ */
+
+#ifndef MQTT_OUTBOX_H
+#define MQTT_OUTBOX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/* 配置参数 */
+#define MQTT_OUTBOX_RAM_SLOTS           8           // RAM消息环容量
+#define MQTT_OUTBOX_TOPIC_MAX           64          // 相对主题最大长度（含结束符）
+#define MQTT_OUTBOX_PAYLOAD_MAX         512         // 单条消息最大长度
+#define MQTT_OUTBOX_PARTITION           "mqtt_spill"    // 溢出分区名
+#define MQTT_OUTBOX_PARTITION_SUBTYPE   0x40        // 溢出分区子类型（自定义数据分区）
+#define MQTT_OUTBOX_FLASH_SLOT_SIZE     1024        // Flash每条记录占用(字节)，整除扇区
+#define MQTT_OUTBOX_DRAIN_INTERVAL_MS   200         // 补发间隔(ms)，即最多5条/秒
+#define MQTT_OUTBOX_RECONNECT_DELAY_MS  1000        // 重连后开始补发前的等待(ms)
+#define MQTT_OUTBOX_TASK_STACK          3072        // 补发任务栈大小
+#define MQTT_OUTBOX_TASK_PRIO           3           // 补发任务优先级（低于命令处理）
+
+/**
+ * @brief 队列统计
+ */
+typedef struct {
+    uint32_t ram_pending;       // RAM中待发送条数
+    uint32_t flash_pending;     // Flash中待发送条数
+    uint32_t flash_capacity;    // Flash可容纳条数，0表示无溢出分区
+    uint32_t sent;              // 已补发条数
+    uint32_t dropped;           // Flash满覆盖或记录损坏丢弃的条数
+} mqtt_outbox_stats_t;
+
+/**
+ * @brief 初始化离线发送队列
+ * 
+ * 挂载溢出分区并恢复掉电前未发送的记录，创建补发任务。
+ * 未找到溢出分区时只使用RAM队列。
+ * 
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_NO_MEM: 内存不足
+ */
+esp_err_t mqtt_outbox_init(void);
+
+/**
+ * @brief 消息入队
+ * 
+ * 按先后顺序排队：Flash中没有记录且RAM未满时写RAM，否则写Flash，补发顺序与入队顺序一致
+ * 
+ * @param topic 相对主题
+ * @param data 消息数据
+ * @param len 数据长度
+ * @param qos QoS等级
+ * @return 
+ *     - ESP_OK: 已入队
+ *     - ESP_ERR_INVALID_ARG: 主题或数据过长
+ *     - ESP_ERR_NO_MEM: RAM已满且无溢出分区
+ *     - ESP_ERR_INVALID_STATE: 未初始化
+ */
+esp_err_t mqtt_outbox_enqueue(const char *topic, const uint8_t *data, int len, int qos);
+
+/**
+ * @brief 队列是否为空
+ * 
+ * @return true=没有待发送消息
+ */
+bool mqtt_outbox_is_empty(void);
+
+/**
+ * @brief 通知连接状态变化（MQTT连接成功后开始补发）
+ * 
+ * @param connected true=已连接
+ */
+void mqtt_outbox_notify_connected(bool connected);
+
+/**
+ * @brief 获取队列统计
+ * 
+ * @param stats 输出统计
+ */
+void mqtt_outbox_get_stats(mqtt_outbox_stats_t *stats);
+
+#endif // MQTT_OUTBOX_H
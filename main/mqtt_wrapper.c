@@ -5,6 +5,9 @@
  */
 
 #include "mqtt_wrapper.h"
+#include "mqtt_outbox.h"
+#include "metrics.h"
+#include "cycle_trace.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "mqtt_client.h"  // ESP-IDF的MQTT客户端头文件（通过mqtt组件提供）
@@ -21,6 +24,126 @@ static esp_mqtt_client_handle_t s_mqtt_client = NULL;
 static mqtt_config_t s_config = {0};
 static bool s_connected = false;
 static bool s_configured = false;
+static bool s_started = false;              // 客户端任务是否在运行
+static bool s_resubscribe = true;           // 前缀变化后即使会话保留也需要重新订阅
+static mqtt_config_t s_active_config = {0}; // 当前句柄使用的连接参数
+static uint16_t s_active_rx_size = 0;       // 句柄创建时的缓冲区大小
+static uint16_t s_active_tx_size = 0;
+
+/* 相对主题表，与 mqtt_topic_id_t 一一对应 */
+static const char *const s_topic_names[MQTT_TOPIC_COUNT] = {
+    [MQTT_TOPIC_CONTROL_LED]    = "control/led",
+    [MQTT_TOPIC_CONTROL_SERVO]  = "control/servo",
+    [MQTT_TOPIC_CONTROL_EFFECT] = "control/effect",
+    [MQTT_TOPIC_CONTROL_POWER]  = "control/power",
+    [MQTT_TOPIC_CONFIG]         = "config",
+    [MQTT_TOPIC_STATUS]         = "status",
+    [MQTT_TOPIC_SENSOR_DATA]    = "sensor/data",
+    [MQTT_TOPIC_SENSOR_ALARM]   = "sensor/alarm",
+    [MQTT_TOPIC_STATS]          = "stats",
+    [MQTT_TOPIC_OTA_CONTROL]    = "ota/control",
+    [MQTT_TOPIC_OTA_DATA]       = "ota/data",
+};
+
+/* 预先生成的完整主题（前缀/相对主题），配置时生成一次 */
+static char s_topics[MQTT_TOPIC_COUNT][MQTT_TOPIC_FULL_MAX];
+static uint8_t s_topic_lens[MQTT_TOPIC_COUNT];
+static char s_sub_control[MQTT_TOPIC_FULL_MAX];     // <prefix>/control/+
+static char s_sub_ota[MQTT_TOPIC_FULL_MAX];         // <prefix>/ota/+
+
+/* 流式回调（按主题ID，连接前注册） */
+static mqtt_stream_callback_t s_stream_callbacks[MQTT_TOPIC_COUNT];
+
+/* 分片消息重组（只在MQTT任务中访问） */
+static uint8_t s_rx_buf[MQTT_RX_MAX_PAYLOAD];
+static int s_rx_len = 0;
+static mqtt_topic_id_t s_rx_topic = MQTT_TOPIC_COUNT;   // 当前消息的主题，COUNT表示丢弃
+
+/**
+ * @brief 按前缀生成完整主题表
+ */
+static esp_err_t build_topic_table(void)
+{
+    for (int i = 0; i < MQTT_TOPIC_COUNT; i++) {
+        int n = snprintf(s_topics[i], sizeof(s_topics[i]), "%s/%s", s_config.prefix, s_topic_names[i]);
+        if (n < 0 || n >= sizeof(s_topics[i])) {
+            ESP_LOGE(TAG, "Topic prefix too long");
+            return ESP_ERR_INVALID_ARG;
+        }
+        s_topic_lens[i] = n;
+    }
+    snprintf(s_sub_control, sizeof(s_sub_control), "%s/control/+", s_config.prefix);
+    snprintf(s_sub_ota, sizeof(s_sub_ota), "%s/ota/+", s_config.prefix);
+    return ESP_OK;
+}
+
+/**
+ * @brief 入站主题查表（长度+内容精确匹配）
+ * 
+ * @return 主题ID，未知主题返回 MQTT_TOPIC_COUNT
+ */
+static mqtt_topic_id_t match_topic(const char *topic, int len)
+{
+    for (int i = 0; i < MQTT_TOPIC_COUNT; i++) {
+        if (s_topic_lens[i] == len && memcmp(s_topics[i], topic, len) == 0) {
+            return (mqtt_topic_id_t)i;
+        }
+    }
+    return MQTT_TOPIC_COUNT;
+}
+
+/**
+ * @brief 处理 MQTT_EVENT_DATA
+ * 
+ * 超过MQTT接收缓冲区的消息会拆成多个事件：首个分片带主题，后续分片 topic_len 为0，
+ * current_data_offset 递增。未分片的消息直接交付事件缓冲区，不复制。
+ * 注册了流式回调的主题逐个分片交付，不重组。
+ */
+static void handle_data_event(esp_mqtt_event_handle_t event)
+{
+    if (event->current_data_offset == 0) {
+        s_rx_topic = match_topic(event->topic, event->topic_len);
+        s_rx_len = 0;
+        if (s_rx_topic == MQTT_TOPIC_COUNT) {
+            ESP_LOGW(TAG, "Unknown topic %.*s", event->topic_len, event->topic);
+        }
+    }
+    if (s_rx_topic == MQTT_TOPIC_COUNT) {
+        return;
+    }
+    
+    mqtt_stream_callback_t stream = s_stream_callbacks[s_rx_topic];
+    if (stream) {
+        stream((const uint8_t *)event->data, event->data_len, event->current_data_offset, event->total_data_len);
+        if (event->current_data_offset + event->data_len >= event->total_data_len) {
+            s_rx_topic = MQTT_TOPIC_COUNT;
+        }
+        return;
+    }
+    
+    if (!s_msg_callback) {
+        return;
+    }
+    
+    if (event->data_len == event->total_data_len) {
+        s_msg_callback(s_rx_topic, (const uint8_t *)event->data, event->data_len);
+        s_rx_topic = MQTT_TOPIC_COUNT;
+        return;
+    }
+    
+    if (event->total_data_len > sizeof(s_rx_buf) || event->current_data_offset != s_rx_len) {
+        ESP_LOGW(TAG, "Dropped fragmented message (%d bytes)", event->total_data_len);
+        s_rx_topic = MQTT_TOPIC_COUNT;
+        return;
+    }
+    
+    memcpy(s_rx_buf + s_rx_len, event->data, event->data_len);
+    s_rx_len += event->data_len;
+    if (s_rx_len == event->total_data_len) {
+        s_msg_callback(s_rx_topic, s_rx_buf, s_rx_len);
+        s_rx_topic = MQTT_TOPIC_COUNT;
+    }
+}
 
 /**
  * @brief 获取设备MAC地址作为客户端ID
@@ -57,23 +180,32 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
             s_status_callback(true);
         }
         
-        // 自动订阅控制主题
-        char topic_buf[128];
-        snprintf(topic_buf, sizeof(topic_buf), "%s/control/+", s_config.prefix);
-        esp_mqtt_client_subscribe(client, topic_buf, 1);
-        
-        // 订阅配置主题
-        snprintf(topic_buf, sizeof(topic_buf), "%s/config", s_config.prefix);
-        esp_mqtt_client_subscribe(client, topic_buf, 1);
+        // 持久会话由Broker保留订阅，会话不存在（首次连接或Broker已清除）时才重新订阅
+        if (!event->session_present || s_resubscribe) {
+            // 自动订阅控制主题
+            esp_mqtt_client_subscribe(client, s_sub_control, 1);
+            
+            // 订阅配置主题
+            esp_mqtt_client_subscribe(client, s_topics[MQTT_TOPIC_CONFIG], 1);
+            
+            // 订阅固件升级主题
+            esp_mqtt_client_subscribe(client, s_sub_ota, 1);
+            s_resubscribe = false;
+        } else {
+            ESP_LOGI(TAG, "Session resumed, subscriptions kept");
+        }
         
         // 发布在线状态
-        snprintf(topic_buf, sizeof(topic_buf), "%s/status", s_config.prefix);
-        esp_mqtt_client_publish(client, topic_buf, "online", 0, 1, 0);
+        esp_mqtt_client_publish(client, s_topics[MQTT_TOPIC_STATUS], "online", 0, 1, 0);
+        
+        // 订阅完成后开始补发离线期间缓存的消息
+        mqtt_outbox_notify_connected(true);
         break;
         
     case MQTT_EVENT_DISCONNECTED:
         ESP_LOGI(TAG, "MQTT disconnected");
         s_connected = false;
+        mqtt_outbox_notify_connected(false);
         if (s_status_callback) {
             s_status_callback(false);
         }
@@ -91,19 +223,12 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
         ESP_LOGI(TAG, "MQTT published, msg_id=%d", event->msg_id);
         break;
         
-    case MQTT_EVENT_DATA:
-        ESP_LOGI(TAG, "MQTT data received");
-        
-        if (s_msg_callback) {
-            // 创建临时字符串
-            char topic[128] = {0};
-            if (event->topic_len < sizeof(topic)) {
-                memcpy(topic, event->topic, event->topic_len);
-                topic[event->topic_len] = '\0';
-            }
-            s_msg_callback(topic, (uint8_t*)event->data, event->data_len);
-        }
+    case MQTT_EVENT_DATA: {
+        CYCLE_TRACE_SCOPE(CYCLE_TRACE_MQTT_DATA);
+        ESP_LOGD(TAG, "MQTT data received, offset=%d/%d", event->current_data_offset, event->total_data_len);
+        handle_data_event(event);
         break;
+    }
         
     case MQTT_EVENT_ERROR:
         ESP_LOGE(TAG, "MQTT error: %s", esp_err_to_name(event->error_handle->error_type));
@@ -126,6 +251,24 @@ esp_err_t mqtt_client_init(mqtt_message_callback_t callback, mqtt_status_callbac
     s_connected = false;
     s_configured = false;
     
+    esp_err_t ret = mqtt_outbox_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to init outbox: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief 为入站主题注册流式回调
+ */
+esp_err_t mqtt_client_set_stream_callback(mqtt_topic_id_t topic, mqtt_stream_callback_t callback)
+{
+    if (topic >= MQTT_TOPIC_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_stream_callbacks[topic] = callback;
     return ESP_OK;
 }
 
@@ -139,6 +282,7 @@ esp_err_t mqtt_client_set_config(const mqtt_config_t *config)
         return ESP_ERR_INVALID_ARG;
     }
     
+    bool prefix_changed = strcmp(s_config.prefix, config->prefix) != 0;
     memcpy(&s_config, config, sizeof(mqtt_config_t));
     
     // 设置默认值
@@ -148,6 +292,20 @@ esp_err_t mqtt_client_set_config(const mqtt_config_t *config)
     if (strlen(s_config.prefix) == 0) {
         strcpy(s_config.prefix, "jasper-c3");
     }
+    if (s_config.rx_buffer_size == 0) {
+        s_config.rx_buffer_size = MQTT_DEFAULT_RX_BUFFER_SIZE;
+    }
+    if (s_config.tx_buffer_size == 0) {
+        s_config.tx_buffer_size = MQTT_DEFAULT_TX_BUFFER_SIZE;
+    }
+    if (prefix_changed) {
+        s_resubscribe = true;
+    }
+    
+    esp_err_t ret = build_topic_table();
+    if (ret != ESP_OK) {
+        return ret;
+    }
     
     s_configured = true;
     ESP_LOGI(TAG, "MQTT config set");
@@ -165,9 +323,17 @@ esp_err_t mqtt_client_connect(void)
         return ESP_ERR_INVALID_STATE;
     }
     
-    if (s_mqtt_client) {
-        ESP_LOGI(TAG, "MQTT client already exists, disconnecting first");
-        esp_mqtt_client_stop(s_mqtt_client);
+    // 参数未变且已在运行：保持现有连接
+    if (s_mqtt_client && s_started && memcmp(&s_active_config, &s_config, sizeof(s_config)) == 0) {
+        ESP_LOGI(TAG, "MQTT config unchanged, keeping connection");
+        return ESP_OK;
+    }
+    
+    // 收发缓冲区在创建句柄时分配，大小变化时只能重建句柄
+    if (s_mqtt_client && (s_active_rx_size != s_config.rx_buffer_size ||
+                          s_active_tx_size != s_config.tx_buffer_size)) {
+        ESP_LOGI(TAG, "MQTT buffer size changed, recreating client");
+        mqtt_client_disconnect();
         esp_mqtt_client_destroy(s_mqtt_client);
         s_mqtt_client = NULL;
     }
@@ -195,25 +361,41 @@ esp_err_t mqtt_client_connect(void)
     
     ESP_LOGI(TAG, "Connecting to MQTT broker (client_id=%s)", client_id);
     
-    // 配置MQTT客户端
+    // 配置MQTT客户端（客户端ID固定为MAC，持久会话重连后由Broker恢复订阅和QoS1消息）
     esp_mqtt_client_config_t mqtt_cfg = {
         .broker.address.uri = uri,
         .credentials.client_id = client_id,
         .session.keepalive = 60,
-        .session.disable_clean_session = false,
+        .session.disable_clean_session = !s_config.clean_session,
+        .buffer.size = s_config.rx_buffer_size,
+        .buffer.out_size = s_config.tx_buffer_size,
     };
     
-    s_mqtt_client = esp_mqtt_client_init(&mqtt_cfg);
-    if (!s_mqtt_client) {
-        ESP_LOGE(TAG, "Failed to create MQTT client");
-        return ESP_FAIL;
+    esp_err_t ret;
+    if (s_mqtt_client) {
+        // 复用句柄：停止任务后更新参数再启动，不重新分配缓冲区
+        ESP_LOGI(TAG, "Reusing MQTT client with new config");
+        mqtt_client_disconnect();
+        ret = esp_mqtt_set_config(s_mqtt_client, &mqtt_cfg);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to update MQTT config: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    } else {
+        s_mqtt_client = esp_mqtt_client_init(&mqtt_cfg);
+        if (!s_mqtt_client) {
+            ESP_LOGE(TAG, "Failed to create MQTT client");
+            return ESP_FAIL;
+        }
+        
+        // 注册事件处理器
+        esp_mqtt_client_register_event(s_mqtt_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
+        s_active_rx_size = s_config.rx_buffer_size;
+        s_active_tx_size = s_config.tx_buffer_size;
     }
     
-    // 注册事件处理器
-    esp_mqtt_client_register_event(s_mqtt_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
-    
     // 启动连接
-    esp_err_t ret = esp_mqtt_client_start(s_mqtt_client);
+    ret = esp_mqtt_client_start(s_mqtt_client);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to start MQTT client: %s", esp_err_to_name(ret));
         esp_mqtt_client_destroy(s_mqtt_client);
@@ -221,6 +403,8 @@ esp_err_t mqtt_client_connect(void)
         return ret;
     }
     
+    s_started = true;
+    memcpy(&s_active_config, &s_config, sizeof(s_config));
     return ESP_OK;
 }
 
@@ -229,18 +413,20 @@ esp_err_t mqtt_client_connect(void)
  */
 esp_err_t mqtt_client_disconnect(void)
 {
-    if (s_mqtt_client) {
+    if (s_mqtt_client && s_started) {
         // 发布离线状态
         if (s_connected) {
-            char topic[128];
-            snprintf(topic, sizeof(topic), "%s/status", s_config.prefix);
-            esp_mqtt_client_publish(s_mqtt_client, topic, "offline", 0, 1, 0);
+            esp_mqtt_client_publish(s_mqtt_client, s_topics[MQTT_TOPIC_STATUS], "offline", 0, 1, 0);
         }
         
+        // 只停止任务，保留句柄和缓冲区供下次连接复用
         esp_mqtt_client_stop(s_mqtt_client);
-        esp_mqtt_client_destroy(s_mqtt_client);
-        s_mqtt_client = NULL;
+        s_started = false;
         s_connected = false;
+        mqtt_outbox_notify_connected(false);
+        if (s_status_callback) {
+            s_status_callback(false);
+        }
     }
     
     return ESP_OK;
@@ -255,11 +441,40 @@ esp_err_t mqtt_client_publish(const char *topic, const uint8_t *data, int len, i
         return ESP_ERR_INVALID_STATE;
     }
     
+    for (int i = 0; i < MQTT_TOPIC_COUNT; i++) {
+        if (strcmp(topic, s_topic_names[i]) == 0) {
+            return mqtt_client_publish_id((mqtt_topic_id_t)i, data, len, qos);
+        }
+    }
+    
     char full_topic[128];
     snprintf(full_topic, sizeof(full_topic), "%s/%s", s_config.prefix, topic);
     
     int msg_id = esp_mqtt_client_publish(s_mqtt_client, full_topic, (const char*)data, len, qos, 0);
     if (msg_id < 0) {
+        metrics_count(METRICS_COUNTER_MQTT_PUBLISH_FAIL);
+        ESP_LOGE(TAG, "Failed to publish");
+        return ESP_FAIL;
+    }
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief 按主题ID发布消息
+ */
+esp_err_t mqtt_client_publish_id(mqtt_topic_id_t topic, const uint8_t *data, int len, int qos)
+{
+    if (topic >= MQTT_TOPIC_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_mqtt_client || !s_connected) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    int msg_id = esp_mqtt_client_publish(s_mqtt_client, s_topics[topic], (const char*)data, len, qos, 0);
+    if (msg_id < 0) {
+        metrics_count(METRICS_COUNTER_MQTT_PUBLISH_FAIL);
         ESP_LOGE(TAG, "Failed to publish");
         return ESP_FAIL;
     }
@@ -267,6 +482,20 @@ esp_err_t mqtt_client_publish(const char *topic, const uint8_t *data, int len, i
     return ESP_OK;
 }
 
+/**
+ * @brief 发布消息，未连接时进入离线队列
+ */
+esp_err_t mqtt_client_publish_queued(const char *topic, const uint8_t *data, int len, int qos)
+{
+    // 队列中还有旧消息时新消息排在后面，保证Broker收到的顺序
+    if (s_connected && mqtt_outbox_is_empty() &&
+        mqtt_client_publish(topic, data, len, qos) == ESP_OK) {
+        return ESP_OK;
+    }
+    
+    return mqtt_outbox_enqueue(topic, data, len, qos);
+}
+
 /**
  * @brief 订阅主题
  */
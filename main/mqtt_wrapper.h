@@ -9,15 +9,59 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* 配置参数 */
+#define MQTT_TOPIC_FULL_MAX     96          // 完整主题最大长度（前缀+相对路径，含结束符）
+#define MQTT_RX_MAX_PAYLOAD     2048        // 分片消息重组缓冲区大小，超过的消息丢弃
+#define MQTT_DEFAULT_RX_BUFFER_SIZE 1024    // 默认接收缓冲区(字节)，更大的消息分片送达
+#define MQTT_DEFAULT_TX_BUFFER_SIZE 1024    // 默认发送缓冲区(字节)
+
+/**
+ * @brief 主题ID
+ * 
+ * 完整主题在 mqtt_client_set_config 时按前缀预先生成，收发都按ID查表，不再逐条拼接
+ */
+typedef enum {
+    MQTT_TOPIC_CONTROL_LED = 0,     // control/led
+    MQTT_TOPIC_CONTROL_SERVO,       // control/servo
+    MQTT_TOPIC_CONTROL_EFFECT,      // control/effect
+    MQTT_TOPIC_CONTROL_POWER,       // control/power
+    MQTT_TOPIC_CONFIG,              // config
+    MQTT_TOPIC_STATUS,              // status
+    MQTT_TOPIC_SENSOR_DATA,         // sensor/data
+    MQTT_TOPIC_SENSOR_ALARM,        // sensor/alarm
+    MQTT_TOPIC_STATS,               // stats
+    MQTT_TOPIC_OTA_CONTROL,         // ota/control
+    MQTT_TOPIC_OTA_DATA,            // ota/data
+    MQTT_TOPIC_COUNT,
+} mqtt_topic_id_t;
 
 /**
  * @brief MQTT消息接收回调函数类型
  * 
- * @param topic 主题
+ * 只对主题表中的主题回调。data 直接指向MQTT事件缓冲区（分片消息为重组缓冲区），
+ * 不以'\0'结尾，仅在回调期间有效。
+ * 
+ * @param topic 主题ID
  * @param data 消息数据
  * @param len 数据长度
  */
-typedef void (*mqtt_message_callback_t)(const char *topic, const uint8_t *data, int len);
+typedef void (*mqtt_message_callback_t)(mqtt_topic_id_t topic, const uint8_t *data, int len);
+
+/**
+ * @brief 流式消息回调函数类型
+ * 
+ * 注册了流式回调的主题不经过重组缓冲区，也不调用 mqtt_message_callback_t：
+ * 每个分片到达时在MQTT任务中直接回调，消息长度不受 MQTT_RX_MAX_PAYLOAD 限制
+ * 
+ * @param data 分片数据，仅在回调期间有效
+ * @param len 分片长度
+ * @param offset 分片在消息中的偏移，0表示新消息
+ * @param total_len 消息总长度
+ */
+typedef void (*mqtt_stream_callback_t)(const uint8_t *data, int len, int offset, int total_len);
 
 /**
  * @brief MQTT连接状态回调函数类型
@@ -36,6 +80,9 @@ typedef struct {
     char password[64];     // 密码（可选）
     char client_id[64];    // 客户端ID（可选，默认使用MAC地址）
     char prefix[64];       // 主题前缀（如 "jasper-c3"）
+    bool clean_session;    // true=每次连接清除会话；默认false，持久会话，重连后订阅保留
+    uint16_t rx_buffer_size;    // 接收缓冲区(字节)，0使用默认值
+    uint16_t tx_buffer_size;    // 发送缓冲区(字节)，0使用默认值
 } mqtt_config_t;
 
 /**
@@ -49,6 +96,19 @@ typedef struct {
  */
 esp_err_t mqtt_client_init(mqtt_message_callback_t callback, mqtt_status_callback_t status_callback);
 
+/**
+ * @brief 为入站主题注册流式回调
+ * 
+ * 需在连接前调用
+ * 
+ * @param topic 主题ID
+ * @param callback 流式回调，NULL恢复普通回调
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 主题ID无效
+ */
+esp_err_t mqtt_client_set_stream_callback(mqtt_topic_id_t topic, mqtt_stream_callback_t callback);
+
 /**
  * @brief 配置MQTT连接参数
  * 
@@ -62,6 +122,9 @@ esp_err_t mqtt_client_set_config(const mqtt_config_t *config);
 /**
  * @brief 连接到MQTT服务器
  * 
+ * 复用已有客户端句柄：参数未变时保持当前连接；参数变化时停止后用新参数重新启动；
+ * 只有缓冲区大小变化时才重建句柄
+ * 
  * @return 
  *     - ESP_OK: 开始连接
  *     - ESP_ERR_INVALID_STATE: 未配置或WiFi未连接
@@ -71,6 +134,8 @@ esp_err_t mqtt_client_connect(void);
 /**
  * @brief 断开MQTT连接
  * 
+ * 停止客户端任务，保留句柄供下次连接复用
+ * 
  * @return 
  *     - ESP_OK: 成功
  */
@@ -79,6 +144,8 @@ esp_err_t mqtt_client_disconnect(void);
 /**
  * @brief 发布消息
  * 
+ * 主题表中的主题直接使用预先生成的完整主题，其他主题拼接前缀
+ * 
  * @param topic 主题（相对路径，会自动添加前缀）
  * @param data 消息数据
  * @param len 数据长度
@@ -89,6 +156,38 @@ esp_err_t mqtt_client_disconnect(void);
  */
 esp_err_t mqtt_client_publish(const char *topic, const uint8_t *data, int len, int qos);
 
+/**
+ * @brief 按主题ID发布消息
+ * 
+ * 使用预先生成的完整主题，不做字符串拼接
+ * 
+ * @param topic 主题ID
+ * @param data 消息数据
+ * @param len 数据长度
+ * @param qos QoS等级（0或1）
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 主题ID无效
+ *     - ESP_ERR_INVALID_STATE: 未连接
+ *     - ESP_FAIL: 失败
+ */
+esp_err_t mqtt_client_publish_id(mqtt_topic_id_t topic, const uint8_t *data, int len, int qos);
+
+/**
+ * @brief 发布消息，未连接时进入离线队列
+ * 
+ * 已连接且离线队列为空时直接发布；否则入队（RAM满后写入Flash），重连后按入队顺序限速补发
+ * 
+ * @param topic 主题（相对路径，会自动添加前缀）
+ * @param data 消息数据
+ * @param len 数据长度（不超过 MQTT_OUTBOX_PAYLOAD_MAX）
+ * @param qos QoS等级（0或1）
+ * @return 
+ *     - ESP_OK: 已发布或已入队
+ *     - 其他: 入队失败，见 mqtt_outbox_enqueue
+ */
+esp_err_t mqtt_client_publish_queued(const char *topic, const uint8_t *data, int len, int qos);
+
 /**
  * @brief 订阅主题
  * 
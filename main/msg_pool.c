@@ -0,0 +1,82 @@
+/*
+ * 静态消息块池 - 实现文件
+ * 
+ * 空闲块指针放在静态创建的FreeRTOS队列中，取块/还块即出队/入队，
+ * 多个生产者和消费者可并发使用同一个池
+ */
+
+#include "msg_pool.h"
+#include "esp_log.h"
+
+/* 日志标签 */
+static const char* TAG = "MSG_POOL";
+
+/**
+ * @brief 初始化消息块池
+ */
+esp_err_t msg_pool_init(msg_pool_t *pool, void *blocks, size_t block_size, size_t count)
+{
+    if (!pool || !blocks || block_size == 0 || count == 0 || count > MSG_POOL_MAX_BLOCKS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    pool->blocks = blocks;
+    pool->block_size = block_size;
+    pool->count = count;
+    pool->exhausted = 0;
+    pool->free_queue = xQueueCreateStatic(count, sizeof(void *), pool->free_queue_storage,
+                                          &pool->free_queue_buf);
+    
+    for (size_t i = 0; i < count; i++) {
+        void *block = pool->blocks + i * block_size;
+        xQueueSend(pool->free_queue, &block, 0);
+    }
+    
+    ESP_LOGD(TAG, "Pool %p: %u x %u bytes", pool, (unsigned)count, (unsigned)block_size);
+    return ESP_OK;
+}
+
+/**
+ * @brief 取一个空闲块
+ */
+void *msg_pool_alloc(msg_pool_t *pool)
+{
+    return msg_pool_alloc_wait(pool, 0);
+}
+
+/**
+ * @brief 取一个空闲块，池耗尽时等待
+ */
+void *msg_pool_alloc_wait(msg_pool_t *pool, TickType_t wait)
+{
+    void *block = NULL;
+    if (!pool->free_queue || xQueueReceive(pool->free_queue, &block, wait) != pdTRUE) {
+        __atomic_fetch_add(&pool->exhausted, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    return block;
+}
+
+/**
+ * @brief 归还块
+ */
+void msg_pool_free(msg_pool_t *pool, void *block)
+{
+    uint8_t *p = block;
+    if (!block || p < pool->blocks || p >= pool->blocks + pool->count * pool->block_size ||
+        (size_t)(p - pool->blocks) % pool->block_size != 0) {
+        ESP_LOGE(TAG, "Pool %p: invalid block %p", pool, block);
+        return;
+    }
+    
+    // 空闲队列容量等于块数，归还不会失败
+    xQueueSend(pool->free_queue, &block, 0);
+}
+
+/**
+ * @brief 获取当前空闲块数
+ */
+size_t msg_pool_available(const msg_pool_t *pool)
+{
+    return pool->free_queue ? uxQueueMessagesWaiting(pool->free_queue) : 0;
+}
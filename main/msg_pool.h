@@ -0,0 +1,84 @@
+/*
+ * 静态消息块池 - 头文件
+ * 
+ * 功能：固定大小消息块的预分配池，用于任务间传递所有权
+ * - 生产者（BLE/MQTT回调等）msg_pool_alloc 取块、填充后把指针投递给消费者队列，之后不再访问
+ * - 消费者处理完 msg_pool_free 归还，运行期不分配内存
+ * - 取块默认不阻塞，池耗尽时返回NULL并计数，生产者任务不会被消费者拖慢；
+ *   需要反压的数据流（如OTA）用 msg_pool_alloc_wait 等待消费者归还
+ * 
+ * 块存储和空闲队列存储都由调用者/池结构静态提供，初始化也不使用堆
+ */
+
+#ifndef MSG_POOL_H
+#define MSG_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+/* 配置参数 */
+#define MSG_POOL_MAX_BLOCKS     16          // 单个池最多块数
+
+/**
+ * @brief 消息块池（静态定义，由 msg_pool_init 初始化）
+ */
+typedef struct {
+    QueueHandle_t free_queue;                           // 空闲块指针队列
+    StaticQueue_t free_queue_buf;
+    uint8_t free_queue_storage[MSG_POOL_MAX_BLOCKS * sizeof(void *)];
+    uint8_t *blocks;                                    // 块存储
+    size_t block_size;                                  // 块大小(字节)
+    size_t count;                                       // 块数
+    uint32_t exhausted;                                 // 池耗尽导致取块失败的次数
+} msg_pool_t;
+
+/**
+ * @brief 初始化消息块池
+ * 
+ * @param pool 池
+ * @param blocks 块存储（至少 block_size * count 字节，按块类型对齐）
+ * @param block_size 块大小
+ * @param count 块数（不超过 MSG_POOL_MAX_BLOCKS）
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效
+ */
+esp_err_t msg_pool_init(msg_pool_t *pool, void *blocks, size_t block_size, size_t count);
+
+/**
+ * @brief 取一个空闲块（不阻塞，任务上下文）
+ * 
+ * @param pool 池
+ * @return 块，池耗尽或未初始化返回NULL
+ */
+void *msg_pool_alloc(msg_pool_t *pool);
+
+/**
+ * @brief 取一个空闲块，池耗尽时最多等待 wait 个tick（任务上下文）
+ * 
+ * @param pool 池
+ * @param wait 最长等待时间(tick)
+ * @return 块，超时或未初始化返回NULL
+ */
+void *msg_pool_alloc_wait(msg_pool_t *pool, TickType_t wait);
+
+/**
+ * @brief 归还块（任务上下文）
+ * 
+ * @param pool 池
+ * @param block msg_pool_alloc 取得的块
+ */
+void msg_pool_free(msg_pool_t *pool, void *block);
+
+/**
+ * @brief 获取当前空闲块数
+ * 
+ * @param pool 池
+ * @return 空闲块数
+ */
+size_t msg_pool_available(const msg_pool_t *pool);
+
+#endif // MSG_POOL_H
@@ -0,0 +1,554 @@
+/*
+ * MQTT固件升级 - 实现文件
+ * 
+ * MQTT任务把数据分片复制进静态写入块（msg_pool）投递给OTA任务，块耗尽时等待，
+ * 对Broker形成TCP反压；OTA任务顺序写入分区（OTA_WITH_SEQUENTIAL_WRITES，按扇区擦除，
+ * 不在开始时整片擦除）并累计SHA-256。升级会话状态只在OTA任务中修改。
+ */
+
+#include "ota_update.h"
+#include "msg_pool.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_app_desc.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_pm.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "mbedtls/sha256.h"
+#include "cJSON.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+/* 日志标签 */
+static const char* TAG = "OTA";
+
+#define SHA256_LEN      32
+#define RUNNING_READ_SIZE   512         // 计算运行分区SHA-256时每次读取的字节数
+
+/**
+ * @brief OTA任务消息类型
+ */
+typedef enum {
+    OTA_MSG_BEGIN = 0,          // 开始/续传
+    OTA_MSG_DATA,               // 固件数据
+    OTA_MSG_ABORT,              // 放弃
+} ota_msg_type_t;
+
+/**
+ * @brief OTA任务消息（写入块）
+ */
+typedef struct {
+    ota_msg_type_t type;
+    uint32_t offset;                    // DATA: 镜像偏移
+    uint32_t len;                       // DATA: 数据长度；BEGIN: 镜像大小
+    union {
+        uint8_t data[OTA_BLOCK_SIZE];
+        uint8_t sha256[SHA256_LEN];     // BEGIN: 期望的SHA-256
+    };
+} ota_msg_t;
+
+/**
+ * @brief 升级会话（只在OTA任务中访问）
+ */
+typedef struct {
+    const esp_partition_t *partition;
+    esp_ota_handle_t handle;
+    uint32_t size;                      // 镜像大小
+    uint32_t written;                   // 已写入长度
+    uint8_t expected[SHA256_LEN];
+    mbedtls_sha256_context sha;
+    uint8_t next_percent;               // 下一次报告进度的百分比
+    bool gap_reported;                  // 已报告缺口，收到连续数据前不再重复报告
+} ota_session_t;
+
+/* 全局变量 */
+static ota_status_callback_t s_status_cb = NULL;
+static ota_msg_t s_blocks[OTA_BLOCK_COUNT];
+static msg_pool_t s_pool;
+static QueueHandle_t s_queue = NULL;
+static StaticQueue_t s_queue_buf;
+static uint8_t s_queue_storage[OTA_BLOCK_COUNT * sizeof(ota_msg_t *)];
+static ota_session_t s_session;
+static bool s_active = false;               // 会话进行中（OTA任务写，其他任务原子读）
+static bool s_pending_verify = false;       // 当前固件待确认
+static esp_timer_handle_t s_confirm_timer = NULL;
+static esp_pm_lock_handle_t s_pm_lock = NULL;
+
+/* 数据流状态（只在MQTT任务中访问） */
+static uint32_t s_feed_offset = 0;          // 当前分片对应的镜像偏移
+static bool s_feed_ok = false;              // 当前消息是否继续写入
+
+/**
+ * @brief 发布状态JSON
+ */
+static void report(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static void report(const char *fmt, ...)
+{
+    if (!s_status_cb) {
+        return;
+    }
+    
+    char json[OTA_STATUS_MAX];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(json, sizeof(json), fmt, args);
+    va_end(args);
+    if (len > 0 && len < sizeof(json)) {
+        s_status_cb(json, len);
+    }
+}
+
+/**
+ * @brief 解析64位十六进制SHA-256
+ */
+static bool parse_sha256(const char *hex, uint8_t *out)
+{
+    if (strlen(hex) != SHA256_LEN * 2) {
+        return false;
+    }
+    for (int i = 0; i < SHA256_LEN; i++) {
+        unsigned int byte;
+        if (sscanf(&hex[i * 2], "%2x", &byte) != 1) {
+            return false;
+        }
+        out[i] = (uint8_t)byte;
+    }
+    return true;
+}
+
+/**
+ * @brief 结束会话，释放句柄和电源锁（OTA任务）
+ * 
+ * @param abort_handle true=OTA句柄仍有效，需要 esp_ota_abort
+ */
+static void session_close(bool abort_handle)
+{
+    if (abort_handle) {
+        esp_ota_abort(s_session.handle);
+    }
+    mbedtls_sha256_free(&s_session.sha);
+    __atomic_store_n(&s_active, false, __ATOMIC_RELEASE);
+    if (s_pm_lock) {
+        esp_pm_lock_release(s_pm_lock);
+    }
+}
+
+/**
+ * @brief 会话失败：报告原因并放弃（OTA任务）
+ */
+static void session_fail(const char *reason, bool abort_handle)
+{
+    ESP_LOGE(TAG, "Update failed at %lu/%lu: %s", s_session.written, s_session.size, reason);
+    report("{\"ota\":\"error\",\"reason\":\"%s\",\"offset\":%lu}", reason, s_session.written);
+    session_close(abort_handle);
+}
+
+/**
+ * @brief 运行中的固件是否与待升级镜像相同
+ * 
+ * 发送端的SHA-256覆盖整个 .bin 文件（含末尾追加的32字节镜像摘要），而
+ * esp_partition_get_sha256 返回的是不含这32字节的镜像摘要，两者不能直接比较。
+ * 先用镜像摘要快速判断：相同镜像在 size-32 处存放的正是运行分区的镜像摘要；
+ * 吻合时再按 size 计算运行分区的整体SHA-256，与发送端的值比较。
+ * 
+ * @param size 镜像大小
+ * @param sha256 发送端的整体SHA-256
+ * @return true=相同
+ */
+static bool running_image_matches(uint32_t size, const uint8_t *sha256)
+{
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    uint8_t digest[SHA256_LEN];
+    uint8_t stored[SHA256_LEN];
+    if (!running || size <= SHA256_LEN || size > running->size ||
+        esp_partition_get_sha256(running, digest) != ESP_OK ||
+        esp_partition_read(running, size - SHA256_LEN, stored, SHA256_LEN) != ESP_OK ||
+        memcmp(digest, stored, SHA256_LEN) != 0) {
+        return false;
+    }
+    
+    uint8_t buf[RUNNING_READ_SIZE];
+    mbedtls_sha256_context sha;
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+    bool ok = true;
+    for (uint32_t offset = 0; offset < size && ok; offset += sizeof(buf)) {
+        uint32_t len = (size - offset < sizeof(buf)) ? size - offset : sizeof(buf);
+        ok = (esp_partition_read(running, offset, buf, len) == ESP_OK);
+        if (ok) {
+            mbedtls_sha256_update(&sha, buf, len);
+        }
+    }
+    mbedtls_sha256_finish(&sha, digest);
+    mbedtls_sha256_free(&sha);
+    return ok && memcmp(digest, sha256, SHA256_LEN) == 0;
+}
+
+/**
+ * @brief 开始或续传（OTA任务）
+ */
+static void handle_begin(uint32_t size, const uint8_t *sha256)
+{
+    const char *version = esp_app_get_description()->version;
+    
+    // 同一镜像续传：从已写入的位置继续
+    if (s_active && size == s_session.size && memcmp(sha256, s_session.expected, SHA256_LEN) == 0) {
+        ESP_LOGI(TAG, "Resuming update at %lu/%lu", s_session.written, size);
+        report("{\"ota\":\"ready\",\"offset\":%lu,\"version\":\"%s\"}", s_session.written, version);
+        return;
+    }
+    if (s_active) {
+        ESP_LOGW(TAG, "New image requested, aborting current update");
+        session_close(true);
+    }
+    
+    // 与当前运行的固件相同，不传输
+    if (running_image_matches(size, sha256)) {
+        ESP_LOGI(TAG, "Image already running (%s)", version);
+        report("{\"ota\":\"up_to_date\",\"version\":\"%s\"}", version);
+        return;
+    }
+    
+    const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+    if (!partition || size > partition->size) {
+        ESP_LOGE(TAG, "Image size %lu does not fit OTA partition", size);
+        report("{\"ota\":\"error\",\"reason\":\"begin\",\"offset\":0}");
+        return;
+    }
+    
+    esp_err_t ret = esp_ota_begin(partition, OTA_WITH_SEQUENTIAL_WRITES, &s_session.handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_begin failed: %s", esp_err_to_name(ret));
+        report("{\"ota\":\"error\",\"reason\":\"begin\",\"offset\":0}");
+        return;
+    }
+    
+    s_session.partition = partition;
+    s_session.size = size;
+    s_session.written = 0;
+    s_session.next_percent = 10;
+    s_session.gap_reported = false;
+    memcpy(s_session.expected, sha256, SHA256_LEN);
+    mbedtls_sha256_init(&s_session.sha);
+    mbedtls_sha256_starts(&s_session.sha, 0);
+    if (s_pm_lock) {
+        esp_pm_lock_acquire(s_pm_lock);     // 升级期间保持最高频率，不进入Light-sleep
+    }
+    __atomic_store_n(&s_active, true, __ATOMIC_RELEASE);
+    
+    ESP_LOGI(TAG, "Update started: %lu bytes -> %s", size, partition->label);
+    report("{\"ota\":\"ready\",\"offset\":0,\"version\":\"%s\"}", version);
+}
+
+/**
+ * @brief 写完后校验并切换启动分区（OTA任务）
+ */
+static void finish_update(void)
+{
+    uint8_t digest[SHA256_LEN];
+    mbedtls_sha256_finish(&s_session.sha, digest);
+    if (memcmp(digest, s_session.expected, SHA256_LEN) != 0) {
+        session_fail("sha256", true);
+        return;
+    }
+    
+    // esp_ota_end 校验镜像格式，无论成功与否都释放句柄
+    esp_err_t ret = esp_ota_end(s_session.handle);
+    if (ret == ESP_OK) {
+        ret = esp_ota_set_boot_partition(s_session.partition);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Image verification failed: %s", esp_err_to_name(ret));
+        session_fail("verify", false);
+        return;
+    }
+    
+    ESP_LOGI(TAG, "Update complete, rebooting into %s", s_session.partition->label);
+    report("{\"ota\":\"done\"}");
+    session_close(false);
+    
+    vTaskDelay(pdMS_TO_TICKS(OTA_REBOOT_DELAY_MS));
+    esp_restart();
+}
+
+/**
+ * @brief 写入一块数据（OTA任务）
+ */
+static void handle_data(uint32_t offset, const uint8_t *data, uint32_t len)
+{
+    if (!s_active) {
+        return;
+    }
+    
+    uint32_t end = offset + len;
+    if (end <= s_session.written) {
+        return;     // QoS1重发或续传重叠的数据
+    }
+    if (offset > s_session.written) {
+        if (!s_session.gap_reported) {
+            ESP_LOGW(TAG, "Gap: got offset %lu, expected %lu", offset, s_session.written);
+            report("{\"ota\":\"error\",\"reason\":\"gap\",\"offset\":%lu}", s_session.written);
+            s_session.gap_reported = true;
+        }
+        return;
+    }
+    if (end > s_session.size) {
+        session_fail("write", true);
+        return;
+    }
+    
+    uint32_t skip = s_session.written - offset;
+    esp_err_t ret = esp_ota_write(s_session.handle, data + skip, len - skip);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_write failed: %s", esp_err_to_name(ret));
+        session_fail("write", true);
+        return;
+    }
+    mbedtls_sha256_update(&s_session.sha, data + skip, len - skip);
+    s_session.written = end;
+    s_session.gap_reported = false;
+    
+    uint8_t percent = (uint64_t)s_session.written * 100 / s_session.size;
+    if (percent >= s_session.next_percent && s_session.written < s_session.size) {
+        report("{\"ota\":\"progress\",\"offset\":%lu,\"percent\":%u}", s_session.written, percent);
+        s_session.next_percent = (percent / 10 + 1) * 10;
+    }
+    
+    if (s_session.written == s_session.size) {
+        finish_update();
+    }
+}
+
+/**
+ * @brief OTA任务
+ */
+static void ota_task(void *arg)
+{
+    ota_msg_t *msg;
+    
+    while (1) {
+        TickType_t wait = __atomic_load_n(&s_active, __ATOMIC_ACQUIRE) ?
+                          pdMS_TO_TICKS(OTA_SESSION_TIMEOUT_MS) : portMAX_DELAY;
+        if (xQueueReceive(s_queue, &msg, wait) != pdTRUE) {
+            session_fail("timeout", true);
+            continue;
+        }
+        
+        switch (msg->type) {
+        case OTA_MSG_BEGIN:
+            handle_begin(msg->len, msg->sha256);
+            break;
+        case OTA_MSG_DATA:
+            handle_data(msg->offset, msg->data, msg->len);
+            break;
+        case OTA_MSG_ABORT:
+            if (s_active) {
+                ESP_LOGW(TAG, "Update aborted by request");
+                session_fail("aborted", true);
+            }
+            break;
+        default:
+            break;
+        }
+        
+        msg_pool_free(&s_pool, msg);
+    }
+}
+
+/**
+ * @brief 投递消息到OTA任务
+ */
+static void post_msg(ota_msg_t *msg)
+{
+    // 写入块与队列容量相同，投递不会失败
+    xQueueSend(s_queue, &msg, 0);
+}
+
+/**
+ * @brief 处理控制JSON
+ */
+void ota_update_handle_control(const char *json_str)
+{
+    if (!s_queue) {
+        return;
+    }
+    
+    cJSON *json = cJSON_Parse(json_str);
+    if (!json) {
+        report("{\"ota\":\"error\",\"reason\":\"invalid\",\"offset\":0}");
+        return;
+    }
+    
+    cJSON *cmd = cJSON_GetObjectItem(json, "cmd");
+    cJSON *size = cJSON_GetObjectItem(json, "size");
+    cJSON *sha = cJSON_GetObjectItem(json, "sha256");
+    ota_msg_t *msg = NULL;
+    uint8_t digest[SHA256_LEN];
+    
+    if (cmd && cJSON_IsString(cmd) && strcmp(cmd->valuestring, "begin") == 0 &&
+        size && cJSON_IsNumber(size) && size->valuedouble > 0 && size->valuedouble <= UINT32_MAX &&
+        sha && cJSON_IsString(sha) && parse_sha256(sha->valuestring, digest)) {
+        msg = msg_pool_alloc_wait(&s_pool, pdMS_TO_TICKS(OTA_BLOCK_WAIT_MS));
+        if (msg) {
+            msg->type = OTA_MSG_BEGIN;
+            msg->len = (uint32_t)size->valuedouble;
+            memcpy(msg->sha256, digest, SHA256_LEN);
+        }
+    } else if (cmd && cJSON_IsString(cmd) && strcmp(cmd->valuestring, "abort") == 0) {
+        msg = msg_pool_alloc_wait(&s_pool, pdMS_TO_TICKS(OTA_BLOCK_WAIT_MS));
+        if (msg) {
+            msg->type = OTA_MSG_ABORT;
+        }
+    } else {
+        ESP_LOGW(TAG, "Invalid OTA control message");
+        report("{\"ota\":\"error\",\"reason\":\"invalid\",\"offset\":0}");
+    }
+    
+    cJSON_Delete(json);
+    if (msg) {
+        post_msg(msg);
+    }
+}
+
+/**
+ * @brief 写入数据消息分片
+ */
+void ota_update_feed(const uint8_t *data, int len, int offset, int total_len)
+{
+    if (!s_queue) {
+        return;
+    }
+    
+    if (offset == 0) {
+        s_feed_ok = false;
+        if (len < OTA_DATA_HEADER_LEN) {
+            ESP_LOGW(TAG, "OTA data message too short (%d bytes)", total_len);
+            return;
+        }
+        if (!__atomic_load_n(&s_active, __ATOMIC_ACQUIRE)) {
+            ESP_LOGW(TAG, "OTA data without session, dropped");
+            report("{\"ota\":\"error\",\"reason\":\"no_session\",\"offset\":0}");
+            return;
+        }
+        s_feed_offset = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+        s_feed_ok = true;
+        data += OTA_DATA_HEADER_LEN;
+        len -= OTA_DATA_HEADER_LEN;
+    }
+    
+    while (s_feed_ok && len > 0) {
+        ota_msg_t *msg = msg_pool_alloc_wait(&s_pool, pdMS_TO_TICKS(OTA_BLOCK_WAIT_MS));
+        if (!msg) {
+            // OTA任务长时间未归还写入块，丢弃本条消息的剩余部分，由缺口检测要求重发
+            ESP_LOGW(TAG, "OTA writer stalled, dropping rest of message");
+            s_feed_ok = false;
+            return;
+        }
+        
+        uint32_t n = len > OTA_BLOCK_SIZE ? OTA_BLOCK_SIZE : len;
+        msg->type = OTA_MSG_DATA;
+        msg->offset = s_feed_offset;
+        msg->len = n;
+        memcpy(msg->data, data, n);
+        post_msg(msg);
+        
+        s_feed_offset += n;
+        data += n;
+        len -= n;
+    }
+}
+
+/**
+ * @brief 确认超时：回滚到上一个固件（esp_timer任务）
+ */
+static void confirm_timeout_cb(void *arg)
+{
+    if (__atomic_exchange_n(&s_pending_verify, false, __ATOMIC_ACQ_REL)) {
+        ESP_LOGE(TAG, "New firmware not confirmed in %d ms, rolling back", OTA_CONFIRM_TIMEOUT_MS);
+        esp_ota_mark_app_invalid_rollback_and_reboot();
+    }
+}
+
+/**
+ * @brief 确认当前固件可用
+ */
+void ota_update_confirm(void)
+{
+    if (!__atomic_exchange_n(&s_pending_verify, false, __ATOMIC_ACQ_REL)) {
+        return;
+    }
+    
+    if (s_confirm_timer) {
+        esp_timer_stop(s_confirm_timer);
+    }
+    esp_err_t ret = esp_ota_mark_app_valid_cancel_rollback();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to confirm firmware: %s", esp_err_to_name(ret));
+        return;
+    }
+    
+    const char *version = esp_app_get_description()->version;
+    ESP_LOGI(TAG, "Firmware %s confirmed", version);
+    report("{\"ota\":\"confirmed\",\"version\":\"%s\"}", version);
+}
+
+/**
+ * @brief 是否正在升级
+ */
+bool ota_update_in_progress(void)
+{
+    return __atomic_load_n(&s_active, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief 初始化固件升级
+ */
+esp_err_t ota_update_init(ota_status_callback_t status_cb)
+{
+    s_status_cb = status_cb;
+    
+    // 新固件首次启动：等待MQTT连接确认，超时回滚
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    esp_ota_img_states_t state;
+    if (esp_ota_get_state_partition(running, &state) == ESP_OK && state == ESP_OTA_IMG_PENDING_VERIFY) {
+        ESP_LOGW(TAG, "Running unconfirmed firmware from %s, rollback in %d ms unless confirmed",
+                 running->label, OTA_CONFIRM_TIMEOUT_MS);
+        s_pending_verify = true;
+        const esp_timer_create_args_t timer_args = {
+            .callback = confirm_timeout_cb,
+            .name = "ota_confirm",
+        };
+        if (esp_timer_create(&timer_args, &s_confirm_timer) == ESP_OK) {
+            esp_timer_start_once(s_confirm_timer, (uint64_t)OTA_CONFIRM_TIMEOUT_MS * 1000);
+        }
+    }
+    
+    if (!esp_ota_get_next_update_partition(NULL)) {
+        ESP_LOGE(TAG, "No OTA partition found");
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    esp_err_t ret = msg_pool_init(&s_pool, s_blocks, sizeof(ota_msg_t), OTA_BLOCK_COUNT);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    s_queue = xQueueCreateStatic(OTA_BLOCK_COUNT, sizeof(ota_msg_t *), s_queue_storage, &s_queue_buf);
+    
+    if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "ota", &s_pm_lock) != ESP_OK) {
+        s_pm_lock = NULL;   // 未启用电源管理
+    }
+    
+    if (xTaskCreate(ota_task, "ota", OTA_TASK_STACK, NULL, OTA_TASK_PRIO, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create OTA task");
+        s_queue = NULL;
+        return ESP_FAIL;
+    }
+    
+    ESP_LOGI(TAG, "OTA ready, running %s from %s", esp_app_get_description()->version, running->label);
+    return ESP_OK;
+}
@@ -0,0 +1,102 @@
+/*
+ * MQTT固件升级 - 头文件
+ * 
+ * 功能：通过MQTT分块接收固件，边收边写入空闲OTA分区，不缓存整个镜像
+ * - 控制：<prefix>/ota/control 写入JSON
+ *   {"cmd":"begin","size":1234567,"sha256":"<64位十六进制>"}  开始（或续传）一次升级
+ *   size/sha256 为整个 .bin 文件（idf.py build 生成的应用镜像，含末尾追加的镜像摘要）的长度和SHA-256
+ *   {"cmd":"abort"}                                           放弃当前升级
+ * - 数据：<prefix>/ota/data 二进制，[镜像偏移 uint32, 小端][固件数据...]
+ *   单条消息长度不限，超过MQTT接收缓冲区时按分片直接流式写入；
+ *   QoS1 重发的重复数据按偏移跳过，出现缺口则报错，发送端按 offset 重发
+ * - 状态：<prefix>/status 发布JSON
+ *   {"ota":"ready","offset":0,"version":".."}    可以从 offset 开始发送数据（续传时为已写入长度）
+ *   {"ota":"up_to_date","version":".."}          镜像与当前运行的固件相同（按运行分区前 size 字节的SHA-256判断），不需要传输
+ *   {"ota":"progress","offset":..,"percent":40}  每10%报告一次
+ *   {"ota":"done"}                               SHA-256 校验通过，即将重启到新固件
+ *   {"ota":"error","reason":"..","offset":..}    失败原因：no_session/gap/write/sha256/verify/timeout/begin/invalid/aborted
+ *   {"ota":"confirmed","version":".."}           新固件启动后已连接MQTT，取消回滚
+ * 
+ * 回滚：新固件启动后处于待验证状态，MQTT连接成功后确认；确认前重启或超时未确认，
+ * 引导程序回滚到上一个固件（需 CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE）
+ * 
+ * 写入在独立的低优先级任务中进行（按扇区顺序擦除），传感器、BLE和MQTT任务照常运行
+ */
+
+#ifndef OTA_UPDATE_H
+#define OTA_UPDATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/* 配置参数 */
+#define OTA_BLOCK_SIZE              1024        // 写入块大小(字节)
+#define OTA_BLOCK_COUNT             4           // 写入块数量（MQTT任务与OTA任务之间的缓冲）
+#define OTA_BLOCK_WAIT_MS           5000        // 写入块耗尽时MQTT任务最长等待(ms)，超时放弃本次升级
+#define OTA_TASK_STACK              4096        // OTA任务栈大小
+#define OTA_TASK_PRIO               2           // OTA任务优先级（低于传感器和命令处理）
+#define OTA_SESSION_TIMEOUT_MS      120000      // 升级过程中无数据超时(ms)
+#define OTA_CONFIRM_TIMEOUT_MS      300000      // 新固件启动后等待确认的时间(ms)，超时回滚
+#define OTA_REBOOT_DELAY_MS         1000        // 升级完成后等待状态发出再重启(ms)
+#define OTA_DATA_HEADER_LEN         4           // 数据消息头：镜像偏移 uint32
+#define OTA_STATUS_MAX              128         // 状态JSON最大长度
+
+/**
+ * @brief 升级状态回调函数类型
+ * 
+ * 在OTA任务或命令任务中调用，应用层发布到MQTT状态主题
+ * 
+ * @param json 状态JSON
+ * @param len 长度
+ */
+typedef void (*ota_status_callback_t)(const char *json, int len);
+
+/**
+ * @brief 初始化固件升级
+ * 
+ * 创建OTA任务；当前固件为待验证状态时启动确认超时
+ * 
+ * @param status_cb 状态回调，可为NULL
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_NOT_FOUND: 分区表中没有OTA分区
+ *     - ESP_FAIL: 任务创建失败
+ */
+esp_err_t ota_update_init(ota_status_callback_t status_cb);
+
+/**
+ * @brief 处理控制JSON（命令任务中调用）
+ * 
+ * @param json 控制JSON（以'\0'结尾）
+ */
+void ota_update_handle_control(const char *json);
+
+/**
+ * @brief 写入数据消息分片（MQTT任务中调用）
+ * 
+ * 签名与 mqtt_stream_callback_t 一致，可直接注册为 ota/data 的流式回调。
+ * 写入块耗尽时阻塞等待OTA任务，对发送端形成反压
+ * 
+ * @param data 分片数据
+ * @param len 分片长度
+ * @param offset 分片在消息中的偏移
+ * @param total_len 消息总长度
+ */
+void ota_update_feed(const uint8_t *data, int len, int offset, int total_len);
+
+/**
+ * @brief 确认当前固件可用，取消回滚（MQTT连接成功后调用）
+ * 
+ * 当前固件不是待验证状态时为空操作
+ */
+void ota_update_confirm(void);
+
+/**
+ * @brief 是否正在升级
+ * 
+ * @return true=升级会话进行中
+ */
+bool ota_update_in_progress(void);
+
+#endif // OTA_UPDATE_H
@@ -0,0 +1,119 @@
+/*
+ * 电源管理 - 实现文件
+ * 
+ * 低功耗模式下由 esp_pm 在空闲时自动进入Light-sleep：
+ * - 传感器：M701约每秒一帧，sensor_hub 只在预计帧到达前持有禁止睡眠锁，UART唤醒作为兜底
+ * - BLE：请求连接间隔 [预算/2, 预算]，控制器在连接事件之间进入Modem-sleep
+ * - WiFi：WIFI_PS_MAX_MODEM，监听间隔按预算换算为信标周期数
+ */
+
+#include "power_manager.h"
+#include "sensor_hub.h"
+#include "ble_service.h"
+#include "wifi_manager.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_wifi.h"
+#include <string.h>
+
+/* 日志标签 */
+static const char* TAG = "POWER";
+
+/* WiFi信标周期(ms)，监听间隔以此为单位 */
+#define WIFI_BEACON_INTERVAL_MS     102
+#define WIFI_LISTEN_INTERVAL_MAX    10
+
+/* 全局变量 */
+static power_profile_t s_profile = POWER_PROFILE_LOW_LATENCY;
+
+static const char *s_profile_names[POWER_PROFILE_MAX] = {
+    [POWER_PROFILE_LOW_LATENCY] = "low_latency",
+    [POWER_PROFILE_LOW_POWER]   = "low_power",
+};
+
+/**
+ * @brief 切换运行模式
+ */
+esp_err_t power_manager_set_profile(power_profile_t profile, uint16_t latency_ms)
+{
+    if (profile >= POWER_PROFILE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    bool low_power = (profile == POWER_PROFILE_LOW_POWER);
+    if (latency_ms == 0) {
+        latency_ms = POWER_LATENCY_DEFAULT_MS;
+    }
+    if (latency_ms < POWER_LATENCY_MIN_MS) {
+        latency_ms = POWER_LATENCY_MIN_MS;
+    } else if (latency_ms > POWER_LATENCY_MAX_MS) {
+        latency_ms = POWER_LATENCY_MAX_MS;
+    }
+    
+    // 1. 自动Light-sleep和动态调频
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = POWER_CPU_FREQ_MAX_MHZ,
+        .min_freq_mhz = low_power ? POWER_CPU_FREQ_MIN_MHZ : POWER_CPU_FREQ_MAX_MHZ,
+        .light_sleep_enable = low_power,
+    };
+    esp_err_t ret = esp_pm_configure(&pm_config);
+    if (ret == ESP_ERR_NOT_SUPPORTED) {
+        // 未启用 CONFIG_PM_ENABLE：不能自动睡眠和调频，其余设置照常生效
+        ESP_LOGW(TAG, "PM not enabled in sdkconfig, light sleep unavailable");
+    } else if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "PM configure failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    // 2. 传感器接收：帧间允许睡眠，UART唤醒
+    ret = sensor_hub_set_low_power(low_power);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Sensor low power mode failed: %s", esp_err_to_name(ret));
+    }
+    
+    // 3. BLE连接间隔
+    if (low_power) {
+        ble_service_set_conn_params(latency_ms / 2, latency_ms);
+    } else {
+        ble_service_set_conn_params(POWER_BLE_FAST_MIN_INTERVAL_MS, POWER_BLE_FAST_MAX_INTERVAL_MS);
+    }
+    
+    // 4. WiFi省电：与BLE共存时必须保留Modem-sleep，低延迟模式使用默认的DTIM1
+    uint8_t listen_interval = latency_ms / WIFI_BEACON_INTERVAL_MS;
+    if (listen_interval > WIFI_LISTEN_INTERVAL_MAX) {
+        listen_interval = WIFI_LISTEN_INTERVAL_MAX;
+    }
+    if (low_power && listen_interval > 1) {
+        wifi_manager_set_power_save(WIFI_PS_MAX_MODEM, listen_interval);
+    } else {
+        wifi_manager_set_power_save(WIFI_PS_MIN_MODEM, 0);
+    }
+    
+    s_profile = profile;
+    ESP_LOGI(TAG, "Power profile: %s (latency=%d ms)", s_profile_names[profile], low_power ? latency_ms : 0);
+    return ESP_OK;
+}
+
+/**
+ * @brief 获取当前运行模式
+ */
+power_profile_t power_manager_get_profile(void)
+{
+    return s_profile;
+}
+
+/**
+ * @brief 根据名称查找运行模式
+ */
+power_profile_t power_manager_profile_from_name(const char *name)
+{
+    if (!name) {
+        return POWER_PROFILE_MAX;
+    }
+    for (int i = 0; i < POWER_PROFILE_MAX; i++) {
+        if (strcmp(name, s_profile_names[i]) == 0) {
+            return (power_profile_t)i;
+        }
+    }
+    return POWER_PROFILE_MAX;
+}
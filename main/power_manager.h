@@ -0,0 +1,62 @@
+/*
+ * 电源管理 - 头文件
+ * 
+ * 功能：在低延迟（常亮）和低功耗两种运行模式之间切换
+ * 低功耗模式：自动Light-sleep（UART唤醒GPIO3）、BLE长连接间隔、WiFi DTIM省电
+ * 延迟预算决定BLE连接间隔和WiFi监听间隔
+ */
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/* 配置参数 */
+#define POWER_CPU_FREQ_MAX_MHZ      160         // CPU最高频率
+#define POWER_CPU_FREQ_MIN_MHZ      40          // 低功耗模式下空闲最低频率（XTAL）
+#define POWER_LATENCY_DEFAULT_MS    500         // 低功耗模式默认延迟预算(ms)
+#define POWER_LATENCY_MIN_MS        30          // 延迟预算下限(ms)
+#define POWER_LATENCY_MAX_MS        4000        // 延迟预算上限(ms)，受BLE最大连接间隔限制
+
+/* 低延迟模式下的BLE连接参数 */
+#define POWER_BLE_FAST_MIN_INTERVAL_MS  8       // 最小连接间隔(ms)
+#define POWER_BLE_FAST_MAX_INTERVAL_MS  30      // 最大连接间隔(ms)
+
+/**
+ * @brief 运行模式
+ */
+typedef enum {
+    POWER_PROFILE_LOW_LATENCY = 0,  // 低延迟：不进入Light-sleep，BLE短连接间隔，WiFi默认省电（原有行为）
+    POWER_PROFILE_LOW_POWER,        // 低功耗：帧间自动Light-sleep，按延迟预算放宽BLE/WiFi
+    POWER_PROFILE_MAX,
+} power_profile_t;
+
+/**
+ * @brief 切换运行模式
+ * 
+ * @param profile 运行模式
+ * @param latency_ms 低功耗模式的延迟预算(ms)，0使用默认值，低延迟模式忽略
+ * @return
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效
+ *     - ESP_ERR_NOT_SUPPORTED: 未启用 CONFIG_PM_ENABLE
+ */
+esp_err_t power_manager_set_profile(power_profile_t profile, uint16_t latency_ms);
+
+/**
+ * @brief 获取当前运行模式
+ * 
+ * @return 当前运行模式
+ */
+power_profile_t power_manager_get_profile(void);
+
+/**
+ * @brief 根据名称查找运行模式
+ * 
+ * @param name 模式名称（"low_latency"/"low_power"）
+ * @return 运行模式，未知名称返回 POWER_PROFILE_MAX
+ */
+power_profile_t power_manager_profile_from_name(const char *name);
+
+#endif // POWER_MANAGER_H
@@ -0,0 +1,74 @@
+/*
+ * 传感器帧扫描 - 实现文件
+ * 
+ * 功能：滑动窗口帧匹配和常用校验，不依赖ESP-IDF
+ */
+
+#include "sensor_frame.h"
+#include <string.h>
+
+/**
+ * @brief 滑动窗口扫描
+ */
+size_t sensor_frame_scan(const sensor_frame_format_t *const *formats, uint8_t count,
+                         uint8_t *window, size_t len,
+                         sensor_frame_callback_t on_frame, void *ctx, sensor_frame_stats_t *stats)
+{
+    size_t pos = 0;
+    
+    while (pos < len) {
+        size_t avail = len - pos;
+        bool matched = false;
+        bool need_more = false;
+        
+        for (uint8_t i = 0; i < count && !matched; i++) {
+            const sensor_frame_format_t *format = formats[i];
+            size_t cmp = avail < format->header_len ? avail : format->header_len;
+            if (memcmp(window + pos, format->header, cmp) != 0) {
+                continue;
+            }
+            if (avail < format->frame_len) {
+                need_more = true;   // 帧头吻合但尚未收完
+                continue;
+            }
+            if (!format->checksum(window + pos, format->frame_len)) {
+                if (stats) {
+                    stats->checksum_errors++;
+                }
+                continue;
+            }
+            
+            on_frame(ctx, i, window + pos);
+            pos += format->frame_len;
+            matched = true;
+        }
+        
+        if (matched) {
+            continue;
+        }
+        if (need_more) {
+            break;
+        }
+        pos++;
+        if (stats) {
+            stats->noise_bytes++;
+        }
+    }
+    
+    if (pos > 0) {
+        memmove(window, window + pos, len - pos);
+    }
+    return len - pos;
+}
+
+/**
+ * @brief 常用校验：前 len-1 字节之和的低8位等于最后一个字节
+ */
+bool sensor_frame_checksum_sum8(const uint8_t *frame, size_t len)
+{
+    uint8_t sum = 0;
+    for (size_t i = 0; i < len - 1; i++) {
+        sum += frame[i];
+    }
+    return (sum == frame[len - 1]);
+}
@@ -0,0 +1,69 @@
+/*
+ * 传感器帧扫描 - 头文件
+ * 
+ * 功能：在字节流中按帧头、长度、校验匹配帧格式的滑动窗口扫描，与ESP-IDF无关
+ * （sensor_hub 的UART总线使用，也可在主机上编译）
+ */
+
+#ifndef SENSOR_FRAME_H
+#define SENSOR_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* 配置参数 */
+#define SENSOR_FRAME_HEADER_MAX     4           // 帧头最大长度
+
+/**
+ * @brief 帧格式
+ */
+typedef struct {
+    uint8_t header[SENSOR_FRAME_HEADER_MAX];    // 帧头
+    uint8_t header_len;                         // 帧头长度
+    uint8_t frame_len;                          // 帧总长度（含帧头和校验）
+    bool (*checksum)(const uint8_t *frame, size_t len);     // 校验，帧头已匹配且帧已收完后调用
+} sensor_frame_format_t;
+
+/**
+ * @brief 扫描统计（累加）
+ */
+typedef struct {
+    uint32_t checksum_errors;   // 帧头吻合、长度足够但校验失败的次数
+    uint32_t noise_bytes;       // 滑动窗口跳过的字节数
+} sensor_frame_stats_t;
+
+/**
+ * @brief 匹配到完整帧的回调函数类型
+ * 
+ * @param ctx 调用者上下文
+ * @param index 匹配的帧格式在 formats 中的下标
+ * @param frame 帧起始地址（长度为该格式的 frame_len），仅在回调期间有效
+ */
+typedef void (*sensor_frame_callback_t)(void *ctx, uint8_t index, const uint8_t *frame);
+
+/**
+ * @brief 滑动窗口扫描
+ * 
+ * 窗口起点同时与所有帧格式比较，匹配不到任何格式时只滑动一个字节，
+ * 数据中出现伪帧头不会导致丢掉后面的真帧
+ * 
+ * @param formats 帧格式数组
+ * @param count 帧格式个数
+ * @param window 接收窗口，扫描后剩余字节（可能是未收完的帧）移动到窗口起点
+ * @param len 窗口内字节数
+ * @param on_frame 完整帧回调
+ * @param ctx 回调上下文
+ * @param stats 扫描统计，可为NULL
+ * @return 扫描后窗口内剩余的字节数
+ */
+size_t sensor_frame_scan(const sensor_frame_format_t *const *formats, uint8_t count,
+                         uint8_t *window, size_t len,
+                         sensor_frame_callback_t on_frame, void *ctx, sensor_frame_stats_t *stats);
+
+/**
+ * @brief 常用校验：前 len-1 字节之和的低8位等于最后一个字节
+ */
+bool sensor_frame_checksum_sum8(const uint8_t *frame, size_t len);
+
+#endif // SENSOR_FRAME_H
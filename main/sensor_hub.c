@@ -0,0 +1,674 @@
+/*
+ * 传感器总线框架 - 实现文件
+ * 
+ * UART总线：UART RX超时中断在线路空闲时上报一次 UART_DATA（timeout_flag 置位），
+ * 主动发帧的传感器通常每帧只唤醒一次；空闲即帧边界，剩余的不完整字节直接丢弃。
+ * 接收窗口逐字节滑动，按帧头、长度、校验整体匹配总线上所有已注册的帧格式，
+ * 数据中出现伪帧头不会导致丢掉后面的真帧，线路噪声只计数并限频汇总日志。
+ * 
+ * 轮询总线：按各驱动周期调度读取，总线任务在两次读取之间阻塞。
+ * 
+ * 所有样本进入同一条样本队列，分发任务收到首个样本后再等待 SENSOR_HUB_BATCH_WINDOW_MS
+ * 合并同批样本，一次回调给应用层。
+ */
+
+#include "sensor_hub.h"
+#include "cycle_trace.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <string.h>
+#include <stdio.h>
+
+/* 日志标签 */
+static const char* TAG = "SENSOR_HUB";
+
+/**
+ * @brief 总线类型
+ */
+typedef enum {
+    BUS_KIND_UART = 0,
+    BUS_KIND_POLL,
+} bus_kind_t;
+
+/**
+ * @brief UART总线状态
+ */
+typedef struct {
+    sensor_uart_bus_config_t config;
+    const sensor_frame_desc_t *descs[SENSOR_HUB_MAX_BUS_DRIVERS];
+    const sensor_frame_format_t *formats[SENSOR_HUB_MAX_BUS_DRIVERS];  // 与 descs 对应，供帧扫描使用
+    QueueHandle_t queue;                // UART事件队列
+    esp_pm_lock_handle_t pm_lock;       // 低功耗：持有期间禁止Light-sleep
+    bool lock_held;                     // 仅总线任务访问
+    TickType_t last_frame_tick;
+    bool synced;                        // 低功耗：已按帧周期同步（收到完整帧后置位，超时未收到则清除）
+    uint32_t reported_noise;            // 噪声汇总日志
+    uint32_t reported_partial;
+    TickType_t last_report;
+} uart_bus_t;
+
+/**
+ * @brief 轮询总线状态
+ */
+typedef struct {
+    const sensor_poll_driver_t *drivers[SENSOR_HUB_MAX_BUS_DRIVERS];
+    TickType_t next_tick[SENSOR_HUB_MAX_BUS_DRIVERS];
+    TaskHandle_t task;
+} poll_bus_t;
+
+/**
+ * @brief 总线
+ */
+typedef struct {
+    bus_kind_t kind;
+    int index;
+    char name[16];
+    uint8_t driver_count;               // 注册时先填写驱动再发布计数，总线任务无锁读取
+    uint8_t driver_ids[SENSOR_HUB_MAX_BUS_DRIVERS];
+    sensor_bus_stats_t stats;
+    union {
+        uart_bus_t uart;
+        poll_bus_t poll;
+    };
+} sensor_bus_t;
+
+/* 全局变量 */
+static sensor_bus_t s_buses[SENSOR_HUB_MAX_BUSES];
+static int s_bus_count = 0;
+static uint8_t s_next_driver_id = 0;
+static QueueHandle_t s_sample_queue = NULL;
+static sensor_batch_callback_t s_batch_callback = NULL;
+static volatile bool s_low_power = false;
+static portMUX_TYPE s_registry_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief 样本送入样本队列（不阻塞总线任务）
+ */
+static void emit_sample(sensor_bus_t *bus, const sensor_sample_t *sample)
+{
+    bus->stats.frames++;
+    if (xQueueSend(s_sample_queue, sample, 0) != pdTRUE) {
+        bus->stats.dropped_samples++;
+    }
+}
+
+/**
+ * @brief 分配驱动编号并发布到总线
+ */
+static esp_err_t attach_driver(sensor_bus_t *bus, const void *driver, uint8_t *driver_id)
+{
+    esp_err_t ret = ESP_OK;
+    
+    portENTER_CRITICAL(&s_registry_lock);
+    uint8_t slot = bus->driver_count;
+    if (slot >= SENSOR_HUB_MAX_BUS_DRIVERS) {
+        ret = ESP_ERR_NO_MEM;
+    } else {
+        uint8_t id = s_next_driver_id++;
+        bus->driver_ids[slot] = id;
+        if (bus->kind == BUS_KIND_UART) {
+            bus->uart.descs[slot] = driver;
+            bus->uart.formats[slot] = &bus->uart.descs[slot]->format;
+        } else {
+            bus->poll.drivers[slot] = driver;
+            bus->poll.next_tick[slot] = xTaskGetTickCount();
+        }
+        __atomic_store_n(&bus->driver_count, slot + 1, __ATOMIC_RELEASE);
+        if (driver_id) {
+            *driver_id = id;
+        }
+    }
+    portEXIT_CRITICAL(&s_registry_lock);
+    
+    return ret;
+}
+
+/**
+ * @brief 占用一个总线槽位
+ */
+static sensor_bus_t *alloc_bus(bus_kind_t kind)
+{
+    sensor_bus_t *bus = NULL;
+    
+    portENTER_CRITICAL(&s_registry_lock);
+    if (s_bus_count < SENSOR_HUB_MAX_BUSES) {
+        bus = &s_buses[s_bus_count];
+        memset(bus, 0, sizeof(*bus));
+        bus->kind = kind;
+        bus->index = s_bus_count;
+    }
+    portEXIT_CRITICAL(&s_registry_lock);
+    
+    return bus;
+}
+
+/**
+ * @brief 发布总线（任务创建成功后调用）
+ */
+static void publish_bus(sensor_bus_t *bus)
+{
+    __atomic_store_n(&s_bus_count, bus->index + 1, __ATOMIC_RELEASE);
+}
+
+/* ==================== UART总线 ==================== */
+
+/**
+ * @brief 帧扫描回调：解码并送入样本队列
+ */
+static void uart_on_frame(void *ctx, uint8_t index, const uint8_t *frame)
+{
+    sensor_bus_t *bus = (sensor_bus_t *)ctx;
+    const sensor_frame_desc_t *desc = bus->uart.descs[index];
+    
+    sensor_sample_t sample = {
+        .type = desc->type,
+        .driver_id = bus->driver_ids[index],
+        .timestamp_us = esp_timer_get_time(),
+    };
+    if (desc->decode(frame, &sample)) {
+        emit_sample(bus, &sample);
+    }
+}
+
+/**
+ * @brief 扫描接收窗口，匹配总线上所有已注册的帧格式
+ * 
+ * @param bus 总线
+ * @param window 接收窗口
+ * @param len 窗口内字节数
+ * @return 扫描后剩余的字节数（可能是未收完的帧），已移动到窗口起点
+ */
+static size_t uart_scan_window(sensor_bus_t *bus, uint8_t *window, size_t len)
+{
+    CYCLE_TRACE_SCOPE(CYCLE_TRACE_SENSOR_FRAME);
+    uint8_t count = __atomic_load_n(&bus->driver_count, __ATOMIC_ACQUIRE);
+    sensor_frame_stats_t scan = {0};
+    
+    size_t remain = sensor_frame_scan(bus->uart.formats, count, window, len, uart_on_frame, bus, &scan);
+    bus->stats.checksum_errors += scan.checksum_errors;
+    bus->stats.noise_bytes += scan.noise_bytes;
+    return remain;
+}
+
+/**
+ * @brief 噪声汇总日志（限频，避免线路噪声时逐字节刷屏）
+ */
+static void uart_report_noise(sensor_bus_t *bus)
+{
+    uart_bus_t *uart = &bus->uart;
+    TickType_t now = xTaskGetTickCount();
+    if ((now - uart->last_report) < pdMS_TO_TICKS(SENSOR_HUB_NOISE_LOG_INTERVAL_MS)) {
+        return;
+    }
+    if (bus->stats.noise_bytes == uart->reported_noise && bus->stats.partial_frames == uart->reported_partial) {
+        return;
+    }
+    
+    ESP_LOGW(TAG, "%s noise: %lu bytes skipped, %lu partial frames dropped", bus->name,
+             bus->stats.noise_bytes - uart->reported_noise, bus->stats.partial_frames - uart->reported_partial);
+    uart->reported_noise = bus->stats.noise_bytes;
+    uart->reported_partial = bus->stats.partial_frames;
+    uart->last_report = now;
+}
+
+/**
+ * @brief 持有/释放禁止睡眠锁（仅总线任务调用）
+ */
+static void uart_stay_awake(uart_bus_t *uart, bool awake)
+{
+    if (!uart->pm_lock || awake == uart->lock_held) {
+        return;
+    }
+    if (awake) {
+        esp_pm_lock_acquire(uart->pm_lock);
+    } else {
+        esp_pm_lock_release(uart->pm_lock);
+    }
+    uart->lock_held = awake;
+}
+
+/**
+ * @brief 是否按低功耗调度接收（只有定期发帧的总线参与）
+ */
+static bool uart_low_power(const uart_bus_t *uart)
+{
+    return s_low_power && uart->config.frame_period_ms > 0;
+}
+
+/**
+ * @brief 计算下一次等待UART事件的超时
+ * 
+ * 低功耗模式：未持锁时睡到预计帧到达前的保护时间；持锁时最多等两个周期，超时视为失步。
+ * 失步后不再按帧周期调度，释放锁无限等待，由Light-sleep的UART唤醒接手，收到下一个完整帧后重新同步
+ */
+static TickType_t uart_wait_ticks(uart_bus_t *uart)
+{
+    if (!uart_low_power(uart)) {
+        uart_stay_awake(uart, false);
+        return portMAX_DELAY;
+    }
+    
+    uint16_t period = uart->config.frame_period_ms;
+    if (uart->lock_held) {
+        return pdMS_TO_TICKS(period * 2);
+    }
+    if (!uart->synced) {
+        return portMAX_DELAY;
+    }
+    
+    uint16_t guard = period > SENSOR_HUB_RX_GUARD_MS ? SENSOR_HUB_RX_GUARD_MS : period / 2;
+    TickType_t next = uart->last_frame_tick + pdMS_TO_TICKS(period - guard);
+    TickType_t now = xTaskGetTickCount();
+    return ((int32_t)(next - now) > 0) ? next - now : 0;
+}
+
+/**
+ * @brief UART总线任务
+ */
+static void uart_bus_task(void *arg)
+{
+    sensor_bus_t *bus = (sensor_bus_t *)arg;
+    uart_bus_t *uart = &bus->uart;
+    uint8_t window[SENSOR_HUB_UART_BUF_SIZE + SENSOR_HUB_FRAME_MAX];
+    size_t window_len = 0;
+    uart_event_t event;
+    
+    ESP_LOGI(TAG, "%s task started", bus->name);
+    
+    while (1) {
+        if (xQueueReceive(uart->queue, &event, uart_wait_ticks(uart)) != pdTRUE) {
+            // 仅低功耗模式会超时。未持锁：下一帧即将到达，保持唤醒；已持锁仍未收到：失步，交给UART唤醒
+            if (uart_low_power(uart)) {
+                if (uart->lock_held) {
+                    uart->synced = false;
+                }
+                uart_stay_awake(uart, !uart->lock_held);
+            }
+            continue;
+        }
+    
+        switch (event.type) {
+        case UART_DATA: {
+            uint32_t frames_before = bus->stats.frames;
+            size_t bytes_to_read = event.size;
+            while (bytes_to_read > 0) {
+                size_t space = sizeof(window) - window_len;
+                int chunk = uart_read_bytes(uart->config.port, window + window_len,
+                                            bytes_to_read > space ? space : bytes_to_read, 0);
+                if (chunk <= 0) {
+                    break;
+                }
+                bytes_to_read -= chunk;
+                window_len = uart_scan_window(bus, window, window_len + chunk);
+            }
+    
+            // 线路空闲：一次突发结束，剩余的不完整帧属于噪声或截断帧
+            if (event.timeout_flag && window_len > 0) {
+                bus->stats.partial_frames++;
+                window_len = 0;
+            }
+    
+            if (bus->stats.frames != frames_before) {
+                // 收到完整帧：到下一帧前允许睡眠
+                uart->last_frame_tick = xTaskGetTickCount();
+                uart->synced = true;
+                uart_stay_awake(uart, false);
+            } else if (uart_low_power(uart)) {
+                // 睡眠中被UART唤醒（首个突发已截断），保持唤醒等待下一帧
+                uart_stay_awake(uart, true);
+            }
+            uart_report_noise(bus);
+            break;
+        }
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            ESP_LOGW(TAG, "%s FIFO overflow or buffer full", bus->name);
+            uart_flush_input(uart->config.port);
+            xQueueReset(uart->queue);
+            bus->stats.overflows++;
+            window_len = 0;
+            break;
+        case UART_PARITY_ERR:
+        case UART_FRAME_ERR:
+            // 线路错误只计数，由滑动窗口校验丢弃坏数据
+            bus->stats.line_errors++;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * @brief 添加UART总线
+ */
+esp_err_t sensor_hub_add_uart_bus(const sensor_uart_bus_config_t *config, int *bus_id)
+{
+    if (!config || !bus_id || !s_sample_queue) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    int count = __atomic_load_n(&s_bus_count, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < count; i++) {
+        if (s_buses[i].kind == BUS_KIND_UART && s_buses[i].uart.config.port == config->port) {
+            *bus_id = i;
+            return ESP_OK;
+        }
+    }
+    
+    sensor_bus_t *bus = alloc_bus(BUS_KIND_UART);
+    if (!bus) {
+        ESP_LOGE(TAG, "Too many buses");
+        return ESP_ERR_NO_MEM;
+    }
+    bus->uart.config = *config;
+    snprintf(bus->name, sizeof(bus->name), "sensor_uart%d", config->port);
+    
+    uart_config_t uart_config = {
+        .baud_rate = config->baud_rate,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    
+    esp_err_t ret = uart_param_config(config->port, &uart_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "UART param config failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    ret = uart_set_pin(config->port, config->tx_pin, config->rx_pin,
+                       UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "UART set pin failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    ret = uart_driver_install(config->port, SENSOR_HUB_UART_BUF_SIZE * 2, 0, 20, &bus->uart.queue, 0);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "UART driver install failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    // 线路空闲 rx_timeout_chars 个字符时间即上报数据，一次突发一次唤醒
+    ret = uart_set_rx_timeout(config->port, config->rx_timeout_chars);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "UART set rx timeout failed: %s", esp_err_to_name(ret));
+        uart_driver_delete(config->port);
+        return ret;
+    }
+    
+    BaseType_t xReturned = xTaskCreate(uart_bus_task, bus->name, SENSOR_HUB_UART_TASK_STACK, bus,
+                                       SENSOR_HUB_BUS_TASK_PRIO, NULL);
+    if (xReturned != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create %s task", bus->name);
+        uart_driver_delete(config->port);
+        return ESP_FAIL;
+    }
+    
+    publish_bus(bus);
+    *bus_id = bus->index;
+    ESP_LOGI(TAG, "UART bus %d: UART%d RX=GPIO%d %d bps", bus->index, config->port,
+             config->rx_pin, config->baud_rate);
+    return ESP_OK;
+}
+
+/**
+ * @brief 在UART总线上注册帧格式驱动
+ */
+esp_err_t sensor_hub_register_uart_driver(int bus_id, const sensor_frame_desc_t *desc, uint8_t *driver_id)
+{
+    if (bus_id < 0 || bus_id >= __atomic_load_n(&s_bus_count, __ATOMIC_ACQUIRE) ||
+        s_buses[bus_id].kind != BUS_KIND_UART || !desc || !desc->format.checksum || !desc->decode ||
+        desc->format.header_len > SENSOR_FRAME_HEADER_MAX || desc->format.header_len > desc->format.frame_len ||
+        desc->format.frame_len == 0 || desc->format.frame_len > SENSOR_HUB_FRAME_MAX ||
+        desc->type >= SENSOR_TYPE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    esp_err_t ret = attach_driver(&s_buses[bus_id], desc, driver_id);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Driver %s registered on bus %d (%d-byte frames)", desc->name, bus_id, desc->format.frame_len);
+    }
+    return ret;
+}
+
+/* ==================== 轮询总线 ==================== */
+
+/**
+ * @brief 轮询总线任务
+ */
+static void poll_bus_task(void *arg)
+{
+    sensor_bus_t *bus = (sensor_bus_t *)arg;
+    poll_bus_t *poll = &bus->poll;
+    
+    ESP_LOGI(TAG, "%s task started", bus->name);
+    
+    while (1) {
+        uint8_t count = __atomic_load_n(&bus->driver_count, __ATOMIC_ACQUIRE);
+        TickType_t wait = portMAX_DELAY;
+        TickType_t now = xTaskGetTickCount();
+    
+        for (uint8_t i = 0; i < count; i++) {
+            const sensor_poll_driver_t *driver = poll->drivers[i];
+            TickType_t period = pdMS_TO_TICKS(driver->period_ms) > 0 ? pdMS_TO_TICKS(driver->period_ms) : 1;
+    
+            if ((int32_t)(now - poll->next_tick[i]) >= 0) {
+                sensor_sample_t sample = {
+                    .type = driver->type,
+                    .driver_id = bus->driver_ids[i],
+                    .timestamp_us = esp_timer_get_time(),
+                };
+                if (driver->read(driver->ctx, &sample) == ESP_OK) {
+                    emit_sample(bus, &sample);
+                } else {
+                    bus->stats.line_errors++;
+                }
+                // 读取耗时超过一个周期则从当前时刻重新对齐，不补读
+                poll->next_tick[i] += period;
+                now = xTaskGetTickCount();
+                if ((int32_t)(now - poll->next_tick[i]) >= 0) {
+                    poll->next_tick[i] = now + period;
+                }
+            }
+    
+            TickType_t remaining = poll->next_tick[i] - now;
+            if (remaining < wait) {
+                wait = remaining;
+            }
+        }
+    
+        // 注册新驱动时会通知本任务重新调度
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+/**
+ * @brief 添加轮询总线
+ */
+esp_err_t sensor_hub_add_poll_bus(const char *name, int *bus_id)
+{
+    if (!bus_id || !s_sample_queue) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    sensor_bus_t *bus = alloc_bus(BUS_KIND_POLL);
+    if (!bus) {
+        ESP_LOGE(TAG, "Too many buses");
+        return ESP_ERR_NO_MEM;
+    }
+    strncpy(bus->name, name ? name : "sensor_poll", sizeof(bus->name) - 1);
+    
+    BaseType_t xReturned = xTaskCreate(poll_bus_task, bus->name, SENSOR_HUB_POLL_TASK_STACK, bus,
+                                       SENSOR_HUB_BUS_TASK_PRIO, &bus->poll.task);
+    if (xReturned != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create %s task", bus->name);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    publish_bus(bus);
+    *bus_id = bus->index;
+    ESP_LOGI(TAG, "Poll bus %d: %s", bus->index, bus->name);
+    return ESP_OK;
+}
+
+/**
+ * @brief 在轮询总线上注册驱动
+ */
+esp_err_t sensor_hub_register_poll_driver(int bus_id, const sensor_poll_driver_t *driver, uint8_t *driver_id)
+{
+    if (bus_id < 0 || bus_id >= __atomic_load_n(&s_bus_count, __ATOMIC_ACQUIRE) ||
+        s_buses[bus_id].kind != BUS_KIND_POLL || !driver || !driver->read ||
+        driver->period_ms == 0 || driver->type >= SENSOR_TYPE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    sensor_bus_t *bus = &s_buses[bus_id];
+    esp_err_t ret = attach_driver(bus, driver, driver_id);
+    if (ret == ESP_OK) {
+        xTaskNotifyGive(bus->poll.task);
+        ESP_LOGI(TAG, "Driver %s registered on bus %d (every %lu ms)", driver->name, bus_id, driver->period_ms);
+    }
+    return ret;
+}
+
+/* ==================== 样本分发 ==================== */
+
+/**
+ * @brief 分发任务：合并同批样本后一次回调
+ */
+static void fanout_task(void *arg)
+{
+    sensor_sample_t batch[SENSOR_HUB_BATCH_MAX];
+    const TickType_t batch_window = pdMS_TO_TICKS(SENSOR_HUB_BATCH_WINDOW_MS);
+    
+    while (1) {
+        if (xQueueReceive(s_sample_queue, &batch[0], portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+    
+        size_t count = 1;
+        TickType_t deadline = xTaskGetTickCount() + batch_window;
+        while (count < SENSOR_HUB_BATCH_MAX) {
+            TickType_t now = xTaskGetTickCount();
+            TickType_t wait = ((int32_t)(deadline - now) > 0) ? deadline - now : 0;
+            if (xQueueReceive(s_sample_queue, &batch[count], wait) != pdTRUE) {
+                break;
+            }
+            count++;
+        }
+    
+        if (s_batch_callback) {
+            s_batch_callback(batch, count);
+        }
+    }
+}
+
+/**
+ * @brief 初始化传感器框架
+ */
+esp_err_t sensor_hub_init(sensor_batch_callback_t callback)
+{
+    if (s_sample_queue) {
+        ESP_LOGW(TAG, "Already initialized");
+        return ESP_OK;
+    }
+    
+    s_sample_queue = xQueueCreate(SENSOR_HUB_QUEUE_LEN, sizeof(sensor_sample_t));
+    if (!s_sample_queue) {
+        ESP_LOGE(TAG, "Failed to create sample queue");
+        return ESP_ERR_NO_MEM;
+    }
+    s_batch_callback = callback;
+    
+    BaseType_t xReturned = xTaskCreate(fanout_task, "sensor_fanout", SENSOR_HUB_FANOUT_TASK_STACK, NULL,
+                                       SENSOR_HUB_FANOUT_TASK_PRIO, NULL);
+    if (xReturned != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create fanout task");
+        vQueueDelete(s_sample_queue);
+        s_sample_queue = NULL;
+        return ESP_FAIL;
+    }
+    
+    ESP_LOGI(TAG, "Sensor hub initialized");
+    return ESP_OK;
+}
+
+/**
+ * @brief 设置低功耗接收
+ */
+esp_err_t sensor_hub_set_low_power(bool enable)
+{
+    int count = __atomic_load_n(&s_bus_count, __ATOMIC_ACQUIRE);
+    
+    for (int i = 0; i < count; i++) {
+        sensor_bus_t *bus = &s_buses[i];
+        if (bus->kind != BUS_KIND_UART || bus->uart.config.frame_period_ms == 0) {
+            continue;
+        }
+    
+        uart_port_t port = bus->uart.config.port;
+        esp_err_t ret;
+        if (enable) {
+            if (!bus->uart.pm_lock) {
+                ret = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, bus->name, &bus->uart.pm_lock);
+                if (ret != ESP_OK) {
+                    ESP_LOGE(TAG, "PM lock create failed: %s", esp_err_to_name(ret));
+                    return ret;
+                }
+            }
+            ret = uart_set_wakeup_threshold(port, SENSOR_HUB_UART_WAKEUP_THRESHOLD);
+            if (ret == ESP_OK) {
+                ret = esp_sleep_enable_uart_wakeup(port);
+            }
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "UART%d wakeup config failed: %s", port, esp_err_to_name(ret));
+                return ret;
+            }
+        }
+    }
+    
+    if (!enable) {
+        esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_UART);
+    }
+    s_low_power = enable;
+    
+    // 唤醒各UART总线任务按新模式重新计算等待时间
+    for (int i = 0; i < count; i++) {
+        if (s_buses[i].kind == BUS_KIND_UART) {
+            uart_event_t kick = { .type = UART_EVENT_MAX };
+            xQueueSend(s_buses[i].uart.queue, &kick, 0);
+        }
+    }
+    
+    ESP_LOGI(TAG, "Low power RX %s", enable ? "enabled" : "disabled");
+    return ESP_OK;
+}
+
+/**
+ * @brief 获取总线接收统计
+ */
+esp_err_t sensor_hub_get_bus_stats(int bus_id, sensor_bus_stats_t *stats)
+{
+    if (bus_id < 0 || bus_id >= __atomic_load_n(&s_bus_count, __ATOMIC_ACQUIRE) || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *stats = s_buses[bus_id].stats;
+    return ESP_OK;
+}
+
+/**
+ * @brief 获取总线数量
+ */
+int sensor_hub_get_bus_count(void)
+{
+    return __atomic_load_n(&s_bus_count, __ATOMIC_ACQUIRE);
+}
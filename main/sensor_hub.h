@@ -0,0 +1,214 @@
+/*
+ * 传感器总线框架 - 头文件
+ * 
+ * 功能：多传感器注册表
+ * - UART总线：驱动只提供帧描述（帧头、长度、校验、解码），每条总线一个读取任务，
+ *   按线路空闲分帧，滑动窗口匹配总线上所有已注册的帧格式（sensor_frame.h）
+ * - 轮询总线（I2C等）：驱动提供读取函数和周期，每条总线一个轮询任务
+ * - 所有样本带时间戳进入同一条样本队列，由分发任务合批后一次回调给应用层
+ */
+
+#ifndef SENSOR_HUB_H
+#define SENSOR_HUB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "driver/uart.h"
+#include "sensor_frame.h"
+#include "m701_codec.h"
+
+/* 配置参数 */
+#define SENSOR_HUB_MAX_BUSES            3           // 最大总线数
+#define SENSOR_HUB_MAX_BUS_DRIVERS      4           // 每条总线最大驱动数
+#define SENSOR_HUB_FRAME_MAX            64          // 帧最大长度
+#define SENSOR_HUB_UART_BUF_SIZE        256         // UART接收缓冲区大小
+#define SENSOR_HUB_UART_TASK_STACK      3072        // UART总线任务栈大小
+#define SENSOR_HUB_POLL_TASK_STACK      3072        // 轮询总线任务栈大小
+#define SENSOR_HUB_BUS_TASK_PRIO        5           // 总线任务优先级
+#define SENSOR_HUB_QUEUE_LEN            8           // 样本队列深度
+#define SENSOR_HUB_BATCH_MAX            4           // 每批最多样本数
+#define SENSOR_HUB_BATCH_WINDOW_MS      50          // 收到首个样本后等待同批样本的时间(ms)
+#define SENSOR_HUB_FANOUT_TASK_STACK    4096        // 分发任务栈大小
+#define SENSOR_HUB_FANOUT_TASK_PRIO     4           // 分发任务优先级
+#define SENSOR_HUB_NOISE_LOG_INTERVAL_MS    60000   // 噪声汇总日志最小间隔(ms)
+#define SENSOR_HUB_RX_GUARD_MS          100         // 低功耗：预计帧到达前提前保持唤醒的时间(ms)
+#define SENSOR_HUB_UART_WAKEUP_THRESHOLD    3       // 低功耗：UART唤醒所需的RX边沿数
+
+/**
+ * @brief 样本类型
+ */
+typedef enum {
+    SENSOR_TYPE_M701 = 0,       // M701SC 7合一空气质量
+    SENSOR_TYPE_MAX,
+} sensor_type_t;
+
+/**
+ * @brief 带时间戳的样本（所有传感器共用）
+ */
+typedef struct {
+    sensor_type_t type;         // 样本类型，决定 data 中有效的成员
+    uint8_t driver_id;          // 注册时分配的驱动编号
+    int64_t timestamp_us;       // 采样时间 (esp_timer_get_time)
+    union {
+        m701_sensor_data_t m701;
+    } data;
+} sensor_sample_t;
+
+/**
+ * @brief UART帧描述
+ */
+typedef struct {
+    const char *name;                               // 驱动名称（日志用）
+    sensor_type_t type;                             // 样本类型
+    sensor_frame_format_t format;                   // 帧头、长度和校验
+    bool (*decode)(const uint8_t *frame, sensor_sample_t *sample);  // 解码到 sample->data，在总线任务中调用
+} sensor_frame_desc_t;
+
+/**
+ * @brief UART总线配置
+ */
+typedef struct {
+    uart_port_t port;               // UART端口
+    int rx_pin;                     // RX引脚
+    int tx_pin;                     // TX引脚，UART_PIN_NO_CHANGE表示不使用
+    int baud_rate;                  // 波特率
+    uint8_t rx_timeout_chars;       // 线路空闲多少个字符时间视为一帧结束
+    uint16_t frame_period_ms;       // 传感器主动发帧周期，0表示不定期（不参与低功耗调度）
+} sensor_uart_bus_config_t;
+
+/**
+ * @brief 轮询驱动（I2C等主机发起读取的传感器）
+ */
+typedef struct {
+    const char *name;                               // 驱动名称（日志用）
+    sensor_type_t type;                             // 样本类型
+    uint32_t period_ms;                             // 读取周期
+    esp_err_t (*read)(void *ctx, sensor_sample_t *sample);  // 读取一个样本到 sample->data
+    void *ctx;                                      // 驱动上下文
+} sensor_poll_driver_t;
+
+/**
+ * @brief 总线接收统计
+ */
+typedef struct {
+    uint32_t frames;            // 有效样本数
+    uint32_t checksum_errors;   // 帧头吻合、长度足够但校验失败的次数
+    uint32_t noise_bytes;       // 滑动窗口跳过的字节数
+    uint32_t partial_frames;    // 线路空闲时丢弃的不完整帧
+    uint32_t overflows;         // FIFO溢出/缓冲区满次数
+    uint32_t line_errors;       // 奇偶校验/帧错误次数（轮询总线为读取失败次数）
+    uint32_t dropped_samples;   // 样本队列满丢弃的样本数
+} sensor_bus_stats_t;
+
+/**
+ * @brief 样本批回调函数类型
+ * 
+ * 在分发任务中调用，同一批内各传感器样本按到达顺序排列
+ * 
+ * @param samples 样本数组
+ * @param count 样本数量
+ */
+typedef void (*sensor_batch_callback_t)(const sensor_sample_t *samples, size_t count);
+
+/**
+ * @brief 初始化传感器框架
+ * 
+ * 创建样本队列和分发任务，需在注册总线和驱动之前调用
+ * 
+ * @param callback 样本批回调
+ * @return
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_NO_MEM: 内存不足
+ *     - ESP_FAIL: 任务创建失败
+ */
+esp_err_t sensor_hub_init(sensor_batch_callback_t callback);
+
+/**
+ * @brief 添加UART总线
+ * 
+ * 同一端口重复添加时返回已有总线
+ * 
+ * @param config 总线配置
+ * @param bus_id 输出总线编号
+ * @return
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效
+ *     - ESP_ERR_NO_MEM: 总线已满
+ *     - 其他: UART驱动错误
+ */
+esp_err_t sensor_hub_add_uart_bus(const sensor_uart_bus_config_t *config, int *bus_id);
+
+/**
+ * @brief 在UART总线上注册帧格式驱动
+ * 
+ * 可在总线运行中注册；desc 需在整个运行期间有效（通常为静态常量）
+ * 
+ * @param bus_id 总线编号
+ * @param desc 帧描述
+ * @param driver_id 输出驱动编号，可为NULL
+ * @return
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效
+ *     - ESP_ERR_NO_MEM: 驱动已满
+ */
+esp_err_t sensor_hub_register_uart_driver(int bus_id, const sensor_frame_desc_t *desc, uint8_t *driver_id);
+
+/**
+ * @brief 添加轮询总线
+ * 
+ * @param name 总线名称（任务名）
+ * @param bus_id 输出总线编号
+ * @return
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_NO_MEM: 总线已满或内存不足
+ */
+esp_err_t sensor_hub_add_poll_bus(const char *name, int *bus_id);
+
+/**
+ * @brief 在轮询总线上注册驱动
+ * 
+ * @param bus_id 总线编号
+ * @param driver 驱动描述，需在整个运行期间有效
+ * @param driver_id 输出驱动编号，可为NULL
+ * @return
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效
+ *     - ESP_ERR_NO_MEM: 驱动已满
+ */
+esp_err_t sensor_hub_register_poll_driver(int bus_id, const sensor_poll_driver_t *driver, uint8_t *driver_id);
+
+/**
+ * @brief 设置低功耗接收
+ * 
+ * 定期发帧的UART总线只在预计帧到达前 SENSOR_HUB_RX_GUARD_MS 起保持唤醒，
+ * 收到完整帧后立即释放；失步时由RX引脚的UART唤醒重新同步。
+ * 唤醒所用的首个突发会被截断丢弃，下一帧起恢复正常接收。
+ * 
+ * @param enable true=低功耗，false=常亮
+ * @return
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_NOT_SUPPORTED: 未启用 CONFIG_PM_ENABLE
+ */
+esp_err_t sensor_hub_set_low_power(bool enable);
+
+/**
+ * @brief 获取总线接收统计
+ * 
+ * @param bus_id 总线编号
+ * @param stats 输出统计
+ * @return
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 总线不存在
+ */
+esp_err_t sensor_hub_get_bus_stats(int bus_id, sensor_bus_stats_t *stats);
+
+/**
+ * @brief 获取总线数量
+ * 
+ * @return 已添加的总线数
+ */
+int sensor_hub_get_bus_count(void);
+
+#endif // SENSOR_HUB_H
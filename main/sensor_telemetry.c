@@ -0,0 +1,347 @@
+/*
+ * 传感器遥测聚合 - 实现文件
+ * 
+ * 窗口内逐样本累加 min/max/sum，窗口结束时生成一个批次放入环形缓冲，
+ * MQTT在线时依次发布；离线时最多缓存 SENSOR_TELEMETRY_BATCH_RING 个批次，
+ * 满了覆盖最旧的批次。
+ * 
+ * 批量消息格式（每个字段为 [min,max,mean]）：
+ * {"seq":3,"n":60,"co2":[410,452,430.5],...,"humi":[45.1,46.0,45.6]}
+ * 或二进制格式（见 sensor_telemetry.h），温湿度为0.01定点，无浮点格式化
+ * 报警消息格式：
+ * {"alarm":"co2","active":true,"value":1620,"threshold":1500}
+ */
+
+#include "sensor_telemetry.h"
+#include "esp_log.h"
+#include <string.h>
+#include <stdio.h>
+#include <float.h>
+
+/* 日志标签 */
+static const char* TAG = "TELEMETRY";
+
+/* 报警解除回差：低于阈值的90%才解除，避免在阈值附近反复报警 */
+#define ALARM_CLEAR_PERCENT     90
+
+/**
+ * @brief 单个字段的统计值
+ */
+typedef struct {
+    float min;
+    float max;
+    float mean;
+} field_stats_t;
+
+/**
+ * @brief 一个聚合批次
+ */
+typedef struct {
+    uint32_t seq;                           // 批次序号
+    uint16_t count;                         // 样本数
+    field_stats_t field[SENSOR_FIELD_MAX];
+} telemetry_batch_t;
+
+/* 字段名（与 m701_codec_to_json 的键一致）和输出精度，精度非0的字段二进制按0.01定点 */
+static const char *s_field_names[SENSOR_FIELD_MAX] = {
+    [SENSOR_FIELD_CO2]  = "co2",
+    [SENSOR_FIELD_HCHO] = "hcho",
+    [SENSOR_FIELD_TVOC] = "tvoc",
+    [SENSOR_FIELD_PM25] = "pm25",
+    [SENSOR_FIELD_PM10] = "pm10",
+    [SENSOR_FIELD_TEMP] = "temp",
+    [SENSOR_FIELD_HUMI] = "humi",
+};
+static const uint8_t s_field_precision[SENSOR_FIELD_MAX] = {
+    [SENSOR_FIELD_TEMP] = 1,
+    [SENSOR_FIELD_HUMI] = 1,
+};
+
+/* 全局变量 */
+static sensor_telemetry_config_t s_config = SENSOR_TELEMETRY_DEFAULT_CONFIG();
+static sensor_telemetry_publish_t s_publish = NULL;
+static volatile uint16_t s_next_window = 0;     // 待生效的窗口，0表示无变更
+static volatile m701_payload_format_t s_format = M701_PAYLOAD_JSON;
+
+/* 当前窗口累加器 */
+static float s_acc_min[SENSOR_FIELD_MAX];
+static float s_acc_max[SENSOR_FIELD_MAX];
+static float s_acc_sum[SENSOR_FIELD_MAX];
+static uint16_t s_acc_count = 0;
+
+/* 待发布批次环形缓冲 */
+static telemetry_batch_t s_batch_ring[SENSOR_TELEMETRY_BATCH_RING];
+static uint8_t s_batch_head = 0;                // 最旧批次位置
+static uint8_t s_batch_count = 0;
+static uint32_t s_batch_seq = 0;
+
+/* 报警状态（按字段位） */
+static uint32_t s_alarm_active = 0;
+
+/**
+ * @brief 取样本中某个字段的值
+ */
+static float sample_value(const m701_sensor_data_t *data, sensor_field_t field)
+{
+    switch (field) {
+    case SENSOR_FIELD_CO2:  return data->co2;
+    case SENSOR_FIELD_HCHO: return data->hcho;
+    case SENSOR_FIELD_TVOC: return data->tvoc;
+    case SENSOR_FIELD_PM25: return data->pm25;
+    case SENSOR_FIELD_PM10: return data->pm10;
+    case SENSOR_FIELD_TEMP: return data->temperature;
+    case SENSOR_FIELD_HUMI: return data->humidity;
+    default:                return 0.0f;
+    }
+}
+
+/**
+ * @brief 取某个字段的报警阈值，0表示不检测
+ */
+static uint16_t alarm_threshold(sensor_field_t field)
+{
+    switch (field) {
+    case SENSOR_FIELD_CO2:  return s_config.co2_alarm;
+    case SENSOR_FIELD_HCHO: return s_config.hcho_alarm;
+    case SENSOR_FIELD_TVOC: return s_config.tvoc_alarm;
+    case SENSOR_FIELD_PM25: return s_config.pm25_alarm;
+    default:                return 0;
+    }
+}
+
+/**
+ * @brief 清空当前窗口累加器
+ */
+static void reset_window(void)
+{
+    for (int i = 0; i < SENSOR_FIELD_MAX; i++) {
+        s_acc_min[i] = FLT_MAX;
+        s_acc_max[i] = -FLT_MAX;
+        s_acc_sum[i] = 0.0f;
+    }
+    s_acc_count = 0;
+}
+
+/**
+ * @brief 批次格式化为JSON
+ */
+static int batch_to_json(const telemetry_batch_t *batch, char *buf, size_t buf_size)
+{
+    int len = snprintf(buf, buf_size, "{\"seq\":%lu,\"n\":%u", (unsigned long)batch->seq, batch->count);
+    for (int i = 0; i < SENSOR_FIELD_MAX && len > 0 && len < buf_size; i++) {
+        int prec = s_field_precision[i];
+        len += snprintf(buf + len, buf_size - len, ",\"%s\":[%.*f,%.*f,%.1f]", s_field_names[i],
+                        prec, batch->field[i].min, prec, batch->field[i].max, batch->field[i].mean);
+    }
+    if (len > 0 && len < buf_size) {
+        len += snprintf(buf + len, buf_size - len, "}");
+    }
+    return (len > 0 && len < buf_size) ? len : 0;
+}
+
+/**
+ * @brief 小端写入16位值
+ */
+static uint8_t *put_le16(uint8_t *buf, uint16_t value)
+{
+    buf[0] = value & 0xFF;
+    buf[1] = value >> 8;
+    return buf + 2;
+}
+
+/**
+ * @brief 统计值转换为二进制字段（与单样本定标一致）
+ */
+static uint16_t stat_to_fixed(sensor_field_t field, float value)
+{
+    if (s_field_precision[field]) {
+        return (uint16_t)(int16_t)M701_TO_CENTI(value);
+    }
+    return (uint16_t)(value + 0.5f);
+}
+
+/**
+ * @brief 批次编码为二进制
+ */
+static int batch_to_binary(const telemetry_batch_t *batch, uint8_t *buf, size_t buf_size)
+{
+    if (buf_size < SENSOR_TELEMETRY_BIN_LEN) {
+        return 0;
+    }
+    
+    uint8_t *p = buf;
+    *p++ = M701_BIN_VERSION;
+    *p++ = M701_BIN_TYPE_BATCH;
+    p = put_le16(p, batch->seq & 0xFFFF);
+    p = put_le16(p, batch->seq >> 16);
+    p = put_le16(p, batch->count);
+    for (int i = 0; i < SENSOR_FIELD_MAX; i++) {
+        p = put_le16(p, stat_to_fixed(i, batch->field[i].min));
+        p = put_le16(p, stat_to_fixed(i, batch->field[i].max));
+        p = put_le16(p, stat_to_fixed(i, batch->field[i].mean));
+    }
+    return p - buf;
+}
+
+/**
+ * @brief 依次发布缓冲区中的批次，发布失败时保留剩余批次
+ */
+static void flush_batches(void)
+{
+    uint8_t payload[SENSOR_TELEMETRY_JSON_MAX];
+    
+    while (s_batch_count > 0) {
+        const telemetry_batch_t *batch = &s_batch_ring[s_batch_head];
+        int len = (s_format == M701_PAYLOAD_BINARY) ?
+                  batch_to_binary(batch, payload, sizeof(payload)) :
+                  batch_to_json(batch, (char*)payload, sizeof(payload));
+        if (len > 0 && !s_publish(false, payload, len)) {
+            return;
+        }
+        s_batch_head = (s_batch_head + 1) % SENSOR_TELEMETRY_BATCH_RING;
+        s_batch_count--;
+    }
+}
+
+/**
+ * @brief 当前窗口结束，生成批次放入环形缓冲
+ */
+static void close_window(void)
+{
+    if (s_batch_count == SENSOR_TELEMETRY_BATCH_RING) {
+        // 缓冲已满：丢弃最旧批次
+        s_batch_head = (s_batch_head + 1) % SENSOR_TELEMETRY_BATCH_RING;
+        s_batch_count--;
+        ESP_LOGW(TAG, "Batch buffer full, oldest batch dropped");
+    }
+    
+    telemetry_batch_t *batch = &s_batch_ring[(s_batch_head + s_batch_count) % SENSOR_TELEMETRY_BATCH_RING];
+    batch->seq = s_batch_seq++;
+    batch->count = s_acc_count;
+    for (int i = 0; i < SENSOR_FIELD_MAX; i++) {
+        batch->field[i].min = s_acc_min[i];
+        batch->field[i].max = s_acc_max[i];
+        batch->field[i].mean = s_acc_sum[i] / s_acc_count;
+    }
+    s_batch_count++;
+    
+    reset_window();
+}
+
+/**
+ * @brief 检查报警阈值，越过阈值或解除报警时立即发布
+ */
+static void check_alarms(const m701_sensor_data_t *data)
+{
+    for (int i = 0; i < SENSOR_FIELD_MAX; i++) {
+        uint16_t threshold = alarm_threshold(i);
+        if (threshold == 0) {
+            continue;
+        }
+    
+        float value = sample_value(data, i);
+        bool active = (s_alarm_active & (1U << i)) != 0;
+        bool trigger = !active && value >= threshold;
+        bool clear = active && value < threshold * ALARM_CLEAR_PERCENT / 100.0f;
+        if (!trigger && !clear) {
+            continue;
+        }
+    
+        char json[96];
+        int len = snprintf(json, sizeof(json), "{\"alarm\":\"%s\",\"active\":%s,\"value\":%.0f,\"threshold\":%u}",
+                           s_field_names[i], trigger ? "true" : "false", value, threshold);
+        // 发布失败不切换状态，下一个样本重试
+        if (s_publish(true, (const uint8_t*)json, len)) {
+            s_alarm_active ^= (1U << i);
+            ESP_LOGW(TAG, "Alarm %s %s (value=%.0f)", s_field_names[i], trigger ? "raised" : "cleared", value);
+        }
+    }
+}
+
+/**
+ * @brief 初始化遥测聚合
+ */
+esp_err_t sensor_telemetry_init(const sensor_telemetry_config_t *config, sensor_telemetry_publish_t publish)
+{
+    if (!publish) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (config) {
+        if (config->window_samples == 0 || config->window_samples > SENSOR_TELEMETRY_WINDOW_MAX) {
+            ESP_LOGE(TAG, "Invalid window: %d", config->window_samples);
+            return ESP_ERR_INVALID_ARG;
+        }
+        s_config = *config;
+    }
+    
+    s_publish = publish;
+    s_format = s_config.format;
+    s_batch_head = 0;
+    s_batch_count = 0;
+    s_alarm_active = 0;
+    reset_window();
+    
+    ESP_LOGI(TAG, "Telemetry initialized (window=%d samples)", s_config.window_samples);
+    return ESP_OK;
+}
+
+/**
+ * @brief 加入一个传感器样本
+ */
+void sensor_telemetry_add_sample(const m701_sensor_data_t *data)
+{
+    if (!s_publish || !data || !data->valid) {
+        return;
+    }
+    
+    check_alarms(data);
+    
+    for (int i = 0; i < SENSOR_FIELD_MAX; i++) {
+        float value = sample_value(data, i);
+        if (value < s_acc_min[i]) {
+            s_acc_min[i] = value;
+        }
+        if (value > s_acc_max[i]) {
+            s_acc_max[i] = value;
+        }
+        s_acc_sum[i] += value;
+    }
+    s_acc_count++;
+    
+    if (s_acc_count >= s_config.window_samples) {
+        close_window();
+        // 窗口边界处应用新的窗口大小
+        if (s_next_window) {
+            s_config.window_samples = s_next_window;
+            s_next_window = 0;
+        }
+    }
+    
+    if (s_batch_count > 0) {
+        flush_batches();
+    }
+}
+
+/**
+ * @brief 设置聚合窗口
+ */
+esp_err_t sensor_telemetry_set_window(uint16_t window_samples)
+{
+    if (window_samples == 0 || window_samples > SENSOR_TELEMETRY_WINDOW_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    s_next_window = window_samples;
+    ESP_LOGI(TAG, "Window set to %d samples", window_samples);
+    return ESP_OK;
+}
+
+/**
+ * @brief 设置批量消息格式
+ */
+void sensor_telemetry_set_format(m701_payload_format_t format)
+{
+    s_format = format;
+    ESP_LOGI(TAG, "Batch format set to %s", format == M701_PAYLOAD_BINARY ? "binary" : "json");
+}
@@ -0,0 +1,121 @@
+/*
+ * 传感器遥测聚合 - 头文件
+ * 
+ * 功能：把M701逐帧数据按窗口聚合为 min/max/mean，合并成一条批量消息发布
+ * 超过报警阈值时立即发布报警消息，聚合不会掩盖突发事件
+ */
+
+#ifndef SENSOR_TELEMETRY_H
+#define SENSOR_TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "m701_codec.h"
+
+/* 配置参数 */
+#define SENSOR_TELEMETRY_WINDOW_DEFAULT 60          // 默认聚合窗口（样本数，约1秒1帧）
+#define SENSOR_TELEMETRY_WINDOW_MAX     3600        // 最大聚合窗口（样本数）
+#define SENSOR_TELEMETRY_BATCH_RING     4           // 待发布批次环形缓冲深度（离线时缓存）
+#define SENSOR_TELEMETRY_JSON_MAX       512         // 单条消息JSON最大长度
+
+/* 二进制批次长度：头部 + 序号(4) + 样本数(2) + 7个字段各 min/max/mean (3x2) */
+#define SENSOR_TELEMETRY_BIN_LEN        (M701_BIN_HEADER_LEN + 6 + SENSOR_FIELD_MAX * 6)
+
+/* 默认报警阈值，0表示不检测 */
+#define SENSOR_TELEMETRY_CO2_ALARM      1500        // CO2 (ppm)
+#define SENSOR_TELEMETRY_HCHO_ALARM     100         // 甲醛 (µg/m³)
+#define SENSOR_TELEMETRY_TVOC_ALARM     600         // TVOC (µg/m³)
+#define SENSOR_TELEMETRY_PM25_ALARM     75          // PM2.5 (µg/m³)
+
+/**
+ * @brief 聚合字段
+ */
+typedef enum {
+    SENSOR_FIELD_CO2 = 0,
+    SENSOR_FIELD_HCHO,
+    SENSOR_FIELD_TVOC,
+    SENSOR_FIELD_PM25,
+    SENSOR_FIELD_PM10,
+    SENSOR_FIELD_TEMP,
+    SENSOR_FIELD_HUMI,
+    SENSOR_FIELD_MAX,
+} sensor_field_t;
+
+/**
+ * @brief 遥测配置
+ */
+typedef struct {
+    uint16_t window_samples;    // 聚合窗口（样本数）
+    uint16_t co2_alarm;         // CO2报警阈值，0为关闭
+    uint16_t hcho_alarm;        // 甲醛报警阈值，0为关闭
+    uint16_t tvoc_alarm;        // TVOC报警阈值，0为关闭
+    uint16_t pm25_alarm;        // PM2.5报警阈值，0为关闭
+    m701_payload_format_t format;   // 批量消息格式
+} sensor_telemetry_config_t;
+
+#define SENSOR_TELEMETRY_DEFAULT_CONFIG() {             \
+    .window_samples = SENSOR_TELEMETRY_WINDOW_DEFAULT,  \
+    .co2_alarm = SENSOR_TELEMETRY_CO2_ALARM,            \
+    .hcho_alarm = SENSOR_TELEMETRY_HCHO_ALARM,          \
+    .tvoc_alarm = SENSOR_TELEMETRY_TVOC_ALARM,          \
+    .pm25_alarm = SENSOR_TELEMETRY_PM25_ALARM,          \
+    .format = M701_PAYLOAD_JSON,                        \
+}
+
+/**
+ * @brief 发布回调函数类型
+ * 
+ * 报警消息始终为JSON；批量消息为JSON或二进制，取决于配置的格式。
+ * 二进制批次（小端）：版本、类型 M701_BIN_TYPE_BATCH、序号(uint32)、样本数(uint16)，
+ * 随后按 sensor_field_t 顺序每个字段 min/max/mean 各16位，定标同 m701_codec_to_binary
+ * 
+ * @param alarm true为报警消息，false为批量消息
+ * @param payload 消息内容
+ * @param len 消息长度
+ * @return true 发布成功；false 发布失败（批量消息保留在缓冲区中稍后重试）
+ */
+typedef bool (*sensor_telemetry_publish_t)(bool alarm, const uint8_t *payload, int len);
+
+/**
+ * @brief 初始化遥测聚合
+ * 
+ * @param config 配置，NULL使用默认配置
+ * @param publish 发布回调
+ * @return
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效
+ */
+esp_err_t sensor_telemetry_init(const sensor_telemetry_config_t *config, sensor_telemetry_publish_t publish);
+
+/**
+ * @brief 加入一个传感器样本
+ * 
+ * 在传感器任务中调用；窗口满时生成批次并尝试发布，越过阈值时立即发布报警
+ * 
+ * @param data 传感器数据
+ */
+void sensor_telemetry_add_sample(const m701_sensor_data_t *data);
+
+/**
+ * @brief 设置聚合窗口
+ * 
+ * 在当前窗口结束后生效
+ * 
+ * @param window_samples 样本数 (1 ~ SENSOR_TELEMETRY_WINDOW_MAX)
+ * @return
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效
+ */
+esp_err_t sensor_telemetry_set_window(uint16_t window_samples);
+
+/**
+ * @brief 设置批量消息格式
+ * 
+ * 对尚未发布的批次立即生效
+ * 
+ * @param format 负载格式
+ */
+void sensor_telemetry_set_format(m701_payload_format_t format);
+
+#endif // SENSOR_TELEMETRY_H
@@ -7,11 +7,34 @@
  * - PWM频率：50Hz，周期20ms = 20000μs
  * - LEDC分辨率：14位 (16384级)
  * - 占空比计算：duty = (pulse_us / 20000) * 16384
+ * 
+ * 多舵机：
+ * 所有通道挂在同一个LEDC定时器上，PWM周期对齐。多通道写入持 s_duty_mutex 先依次写占空比，
+ * 再连续锁存，锁存后在下一个PWM周期起点生效，多轴姿态通常在同一周期生效（锁存恰好跨过
+ * 周期起点时相差一个周期）。ledc_set_duty 在安装渐变后会获取渐变信号量，不能在临界区内调用，
+ * 临界区只用于拷贝轨迹状态。
+ * 
+ * 轨迹规划：
+ * 共用一个 esp_timer，每个PWM周期为所有运动中的舵机更新一次位置。速度朝 v_des 以不超过
+ * 加速度上限的步长变化，v_des = min(v_max, sqrt(2 * a_max * 剩余距离))，即能在目标处
+ * 恰好减速到0的最大速度，形成梯形速度曲线（距离短时为三角形）。新目标只改变 v_des，
+ * 当前速度连续，抢占无冲击。
+ * 
+ * 硬件渐变：
+ * servo_move_to 使用LEDC渐变引擎按时间匀速改变占空比，渐变结束中断只投递一次完成回调
+ * 到FreeRTOS定时器服务任务，移动期间CPU零开销。
  */
 
 #include "servo_driver.h"
 #include "driver/ledc.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/timers.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include <math.h>
+#include <string.h>
 
 /* 日志标签 */
 static const char* TAG = "SERVO";
@@ -19,15 +42,49 @@ static const char* TAG = "SERVO";
 /* LEDC配置 */
 #define LEDC_TIMER              LEDC_TIMER_0
 #define LEDC_MODE               LEDC_LOW_SPEED_MODE
-#define LEDC_CHANNEL            LEDC_CHANNEL_0
 #define LEDC_DUTY_RES           LEDC_TIMER_14_BIT   // 14位分辨率 (0-16383)
 #define LEDC_DUTY_MAX           16384               // 2^14
 
 /* PWM周期(μs) */
 #define PWM_PERIOD_US           (1000000 / SERVO_PWM_FREQ_HZ)  // 20000μs
 
-/* 当前角度 */
-static float s_current_angle = 0.0f;
+/* 到达判定：剩余距离小于此值且能在一个周期内停下即视为到达(度) */
+#define MOTION_ARRIVE_EPS       0.05f
+
+/**
+ * @brief 舵机通道状态
+ * 
+ * 轨迹字段（target/velocity/moving/限值）受 s_motion_lock 保护
+ */
+struct servo_channel {
+    bool in_use;
+    ledc_channel_t channel;
+    servo_config_t config;
+    float current_angle;
+    
+    // 轨迹
+    float target_angle;
+    float velocity;                 // 当前角速度(度/秒)
+    float max_velocity;
+    float max_accel;
+    bool moving;
+    
+    // 硬件渐变
+    volatile bool fading;
+    volatile uint32_t fade_seq;     // 每次渐变加1，丢弃被打断渐变的完成事件
+    float fade_target;
+    servo_move_done_cb_t fade_callback;
+    void *fade_arg;
+};
+
+/* 全局变量 */
+static struct servo_channel s_channels[SERVO_MAX_CHANNELS];
+static portMUX_TYPE s_motion_lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t s_motion_timer = NULL;
+static bool s_timer_armed = false;              // 受 s_motion_lock 保护
+static SemaphoreHandle_t s_duty_mutex = NULL;   // 串行化占空比写入（轨迹定时器与直接设置角度）
+static bool s_shared_ready = false;             // LEDC定时器/渐变/轨迹定时器已初始化
+static servo_handle_t s_default = NULL;
 
 /**
  * @brief 将脉冲宽度转换为LEDC占空比
@@ -41,19 +98,276 @@ static uint32_t pulse_to_duty(uint32_t pulse_us)
 /**
  * @brief 将角度转换为脉冲宽度
  */
-static uint32_t angle_to_pulse(float angle)
+static uint32_t angle_to_pulse(const struct servo_channel *servo, float angle)
 {
     // pulse = min_pulse + (angle / max_angle) * (max_pulse - min_pulse)
-    uint32_t pulse_range = SERVO_MAX_PULSE_US - SERVO_MIN_PULSE_US;
-    return SERVO_MIN_PULSE_US + (uint32_t)((angle / SERVO_MAX_ANGLE) * pulse_range);
+    uint32_t pulse_range = servo->config.max_pulse_us - servo->config.min_pulse_us;
+    return servo->config.min_pulse_us + (uint32_t)((angle / servo->config.max_angle) * pulse_range);
 }
 
 /**
- * @brief 初始化舵机驱动
+ * @brief 将LEDC占空比转换为角度
  */
-esp_err_t servo_init(void)
+static float duty_to_angle(const struct servo_channel *servo, uint32_t duty)
 {
-    ESP_LOGI(TAG, "Initializing servo driver on GPIO%d", SERVO_GPIO_PIN);
+    float pulse_us = (float)duty * PWM_PERIOD_US / LEDC_DUTY_MAX;
+    float angle = (pulse_us - servo->config.min_pulse_us) /
+                  (servo->config.max_pulse_us - servo->config.min_pulse_us) * servo->config.max_angle;
+    if (angle < 0.0f) {
+        angle = 0.0f;
+    } else if (angle > servo->config.max_angle) {
+        angle = servo->config.max_angle;
+    }
+    return angle;
+}
+
+/**
+ * @brief 句柄和角度检查
+ */
+static bool angle_is_valid(servo_handle_t servo, float angle)
+{
+    if (!servo || !servo->in_use) {
+        return false;
+    }
+    if (angle < 0.0f || angle > servo->config.max_angle) {
+        ESP_LOGW(TAG, "Angle %.1f out of range [0, %.1f]", angle, servo->config.max_angle);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 停止硬件渐变，停在当前占空比，被打断的渐变不再回调
+ */
+static void fade_stop(struct servo_channel *servo)
+{
+    if (!servo->fading) {
+        return;
+    }
+    servo->fade_seq++;
+    ledc_fade_stop(LEDC_MODE, servo->channel);
+    servo->current_angle = duty_to_angle(servo, ledc_get_duty(LEDC_MODE, servo->channel));
+    servo->fading = false;
+}
+
+/**
+ * @brief 停止轨迹和硬件渐变（直接设置角度前调用）
+ * 
+ * 轨迹定时器是共用的，这里只清除本通道的运动标志，定时器在没有运动通道时自行停止
+ */
+static void motion_stop(struct servo_channel *servo)
+{
+    portENTER_CRITICAL(&s_motion_lock);
+    servo->velocity = 0.0f;
+    servo->moving = false;
+    portEXIT_CRITICAL(&s_motion_lock);
+    
+    fade_stop(servo);
+}
+
+/**
+ * @brief 确保轨迹定时器在运行
+ */
+static esp_err_t motion_kick(void)
+{
+    portENTER_CRITICAL(&s_motion_lock);
+    bool start = !s_timer_armed;
+    s_timer_armed = true;
+    portEXIT_CRITICAL(&s_motion_lock);
+    
+    // 已在运行：回调会自然处理新目标
+    if (!start) {
+        return ESP_OK;
+    }
+    
+    esp_err_t ret = esp_timer_start_once(s_motion_timer, 0);
+    if (ret != ESP_OK) {
+        portENTER_CRITICAL(&s_motion_lock);
+        s_timer_armed = false;
+        portEXIT_CRITICAL(&s_motion_lock);
+        ESP_LOGE(TAG, "Motion timer start failed: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/**
+ * @brief 渐变完成（定时器服务任务中执行）
+ */
+static void fade_done_deferred(void *arg, uint32_t seq)
+{
+    struct servo_channel *servo = (struct servo_channel *)arg;
+    if (seq != servo->fade_seq || !servo->fading) {
+        return;
+    }
+    
+    servo->fading = false;
+    servo->current_angle = servo->fade_target;
+    servo->target_angle = servo->fade_target;
+    ESP_LOGD(TAG, "Servo ch%d fade reached %.1f deg", servo->channel, servo->fade_target);
+    
+    if (servo->fade_callback) {
+        servo->fade_callback(servo->fade_target, servo->fade_arg);
+    }
+}
+
+/**
+ * @brief LEDC渐变结束中断回调
+ */
+static bool IRAM_ATTR fade_end_isr(const ledc_cb_param_t *param, void *user_arg)
+{
+    struct servo_channel *servo = (struct servo_channel *)user_arg;
+    BaseType_t woken = pdFALSE;
+    if (param->event == LEDC_FADE_END_EVT) {
+        xTimerPendFunctionCallFromISR(fade_done_deferred, servo, servo->fade_seq, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+/**
+ * @brief 计算一个周期后的位置和速度
+ */
+static void motion_step(float max_angle, float target, float v_max, float a_max, float *pos, float *vel)
+{
+    const float dt = SERVO_MOTION_PERIOD_MS / 1000.0f;
+    float p = *pos;
+    float v = *vel;
+    float dist = target - p;
+    float dv_max = a_max * dt;
+    
+    // 到达：距离足够小且一个周期内能停下
+    if (fabsf(dist) < MOTION_ARRIVE_EPS && fabsf(v) <= dv_max) {
+        *pos = target;
+        *vel = 0.0f;
+        return;
+    }
+    
+    // 能在目标处减速到0的最大速度，再受限于加速度
+    float v_des = sqrtf(2.0f * a_max * fabsf(dist));
+    if (v_des > v_max) {
+        v_des = v_max;
+    }
+    v_des = copysignf(v_des, dist);
+    float dv = v_des - v;
+    if (dv > dv_max) {
+        dv = dv_max;
+    } else if (dv < -dv_max) {
+        dv = -dv_max;
+    }
+    v += dv;
+    
+    float step = v * dt;
+    if (step * dist > 0 && fabsf(step) >= fabsf(dist) && fabsf(v) <= dv_max) {
+        // 本周期越过目标且速度已足够低，直接落在目标上
+        p = target;
+        v = 0.0f;
+    } else {
+        p += step;
+    }
+    if (p < 0.0f) {
+        p = 0.0f;
+        v = 0.0f;
+    } else if (p > max_angle) {
+        p = max_angle;
+        v = 0.0f;
+    }
+    
+    *pos = p;
+    *vel = v;
+}
+
+/**
+ * @brief 轨迹定时器回调，每个PWM周期一次
+ * 
+ * 单次定时器由回调自行续期：没有运动中的通道时不再续期，
+ * 与 motion_kick 的启动判断都在同一临界区内完成，不会漏启也不会重复启动。
+ * 持 s_duty_mutex 写入并锁存所有通道的新占空比；期间被直接设置角度而停止的通道会被跳过
+ * （servo_set_pose 先停止轨迹再获取互斥锁，其写入总在本次之后）。
+ */
+static void motion_timer_callback(void *arg)
+{
+    struct servo_channel *active[SERVO_MAX_CHANNELS];
+    float target[SERVO_MAX_CHANNELS];
+    float v_max[SERVO_MAX_CHANNELS];
+    float a_max[SERVO_MAX_CHANNELS];
+    float pos[SERVO_MAX_CHANNELS];
+    float vel[SERVO_MAX_CHANNELS];
+    size_t count = 0;
+    
+    portENTER_CRITICAL(&s_motion_lock);
+    for (int i = 0; i < SERVO_MAX_CHANNELS; i++) {
+        struct servo_channel *servo = &s_channels[i];
+        if (servo->in_use && servo->moving) {
+            active[count] = servo;
+            target[count] = servo->target_angle;
+            v_max[count] = servo->max_velocity;
+            a_max[count] = servo->max_accel;
+            pos[count] = servo->current_angle;
+            vel[count] = servo->velocity;
+            count++;
+        }
+    }
+    portEXIT_CRITICAL(&s_motion_lock);
+    
+    for (size_t i = 0; i < count; i++) {
+        motion_step(active[i]->config.max_angle, target[i], v_max[i], a_max[i], &pos[i], &vel[i]);
+    }
+    
+    xSemaphoreTake(s_duty_mutex, portMAX_DELAY);
+    bool write[SERVO_MAX_CHANNELS];
+    portENTER_CRITICAL(&s_motion_lock);
+    for (size_t i = 0; i < count; i++) {
+        write[i] = active[i]->moving;
+    }
+    portEXIT_CRITICAL(&s_motion_lock);
+    
+    for (size_t i = 0; i < count; i++) {
+        if (write[i]) {
+            ledc_set_duty(LEDC_MODE, active[i]->channel, pulse_to_duty(angle_to_pulse(active[i], pos[i])));
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (write[i]) {
+            ledc_update_duty(LEDC_MODE, active[i]->channel);
+        }
+    }
+    
+    bool next = false;
+    portENTER_CRITICAL(&s_motion_lock);
+    for (size_t i = 0; i < count; i++) {
+        struct servo_channel *servo = active[i];
+        if (!write[i] || !servo->moving) {
+            continue;
+        }
+        servo->current_angle = pos[i];
+        servo->velocity = vel[i];
+        // 期间目标被改写则继续运动
+        if (vel[i] == 0.0f && pos[i] == servo->target_angle) {
+            servo->moving = false;
+        }
+    }
+    for (int i = 0; i < SERVO_MAX_CHANNELS; i++) {
+        if (s_channels[i].in_use && s_channels[i].moving) {
+            next = true;
+            break;
+        }
+    }
+    s_timer_armed = next;
+    portEXIT_CRITICAL(&s_motion_lock);
+    xSemaphoreGive(s_duty_mutex);
+    
+    if (next) {
+        esp_timer_start_once(s_motion_timer, SERVO_MOTION_PERIOD_MS * 1000);
+    }
+}
+
+/**
+ * @brief 初始化共用资源：LEDC定时器、渐变中断服务、轨迹定时器
+ */
+static esp_err_t shared_init(void)
+{
+    if (s_shared_ready) {
+        return ESP_OK;
+    }
     
     // 配置LEDC定时器
     ledc_timer_config_t ledc_timer = {
@@ -68,14 +382,78 @@ esp_err_t servo_init(void)
         ESP_LOGE(TAG, "LEDC timer config failed: %s", esp_err_to_name(ret));
         return ret;
     }
+    
+    // 硬件渐变
+    ret = ledc_fade_func_install(0);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "LEDC fade install failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    if (!s_duty_mutex) {
+        s_duty_mutex = xSemaphoreCreateMutex();
+    }
+    if (!s_duty_mutex) {
+        ESP_LOGE(TAG, "Duty mutex create failed");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // 轨迹定时器
+    const esp_timer_create_args_t timer_args = {
+        .callback = motion_timer_callback,
+        .name = "servo_motion",
+    };
+    ret = esp_timer_create(&timer_args, &s_motion_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Motion timer create failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    s_shared_ready = true;
+    ESP_LOGI(TAG, "Servo PWM freq=%dHz, resolution=%d bits", SERVO_PWM_FREQ_HZ, LEDC_DUTY_RES);
+    return ESP_OK;
+}
 
+/**
+ * @brief 创建舵机通道
+ */
+esp_err_t servo_channel_create(const servo_config_t *config, servo_handle_t *handle)
+{
+    if (!config || !handle || config->min_pulse_us >= config->max_pulse_us ||
+        config->max_pulse_us >= PWM_PERIOD_US || !(config->max_angle > 0.0f)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    esp_err_t ret = shared_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    struct servo_channel *servo = NULL;
+    for (int i = 0; i < SERVO_MAX_CHANNELS; i++) {
+        if (!s_channels[i].in_use) {
+            servo = &s_channels[i];
+            break;
+        }
+    }
+    if (!servo) {
+        ESP_LOGE(TAG, "No free LEDC channel");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    memset(servo, 0, sizeof(*servo));
+    servo->channel = (ledc_channel_t)(servo - s_channels);
+    servo->config = *config;
+    servo->max_velocity = SERVO_MAX_VELOCITY_DPS;
+    servo->max_accel = SERVO_MAX_ACCEL_DPS2;
+    
     // 配置LEDC通道
     ledc_channel_config_t ledc_channel = {
         .speed_mode     = LEDC_MODE,
-        .channel        = LEDC_CHANNEL,
+        .channel        = servo->channel,
         .timer_sel      = LEDC_TIMER,
         .intr_type      = LEDC_INTR_DISABLE,
-        .gpio_num       = SERVO_GPIO_PIN,
+        .gpio_num       = config->gpio_num,
         .duty           = 0,
         .hpoint         = 0
     };
@@ -84,86 +462,303 @@ esp_err_t servo_init(void)
         ESP_LOGE(TAG, "LEDC channel config failed: %s", esp_err_to_name(ret));
         return ret;
     }
+    
+    ledc_cbs_t fade_cbs = {
+        .fade_cb = fade_end_isr,
+    };
+    ret = ledc_cb_register(LEDC_MODE, servo->channel, &fade_cbs, servo);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "LEDC fade callback register failed: %s", esp_err_to_name(ret));
+        ledc_stop(LEDC_MODE, servo->channel, 0);
+        return ret;
+    }
+    
+    servo->in_use = true;
+    *handle = servo;
+    ESP_LOGI(TAG, "Servo ch%d on GPIO%d", servo->channel, config->gpio_num);
+    return ESP_OK;
+}
 
-    // 初始化到中立位置
-    servo_center();
+/**
+ * @brief 删除舵机通道
+ */
+esp_err_t servo_channel_delete(servo_handle_t servo)
+{
+    if (!servo || !servo->in_use) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    motion_stop(servo);
+    ledc_stop(LEDC_MODE, servo->channel, 0);
     
-    ESP_LOGI(TAG, "Servo initialized, PWM freq=%dHz, resolution=%d bits", 
-             SERVO_PWM_FREQ_HZ, LEDC_DUTY_RES);
+    portENTER_CRITICAL(&s_motion_lock);
+    servo->in_use = false;
+    portEXIT_CRITICAL(&s_motion_lock);
     
+    if (servo == s_default) {
+        s_default = NULL;
+    }
     return ESP_OK;
 }
 
 /**
- * @brief 设置舵机角度
+ * @brief 设置舵机角度（立即跳到目标）
  */
-esp_err_t servo_set_angle(float angle)
+esp_err_t servo_channel_set_angle(servo_handle_t servo, float angle)
+{
+    return servo_set_pose(&servo, &angle, 1);
+}
+
+/**
+ * @brief 设置舵机脉冲宽度（立即生效）
+ */
+esp_err_t servo_channel_set_pulse(servo_handle_t servo, uint32_t pulse_us)
 {
-    // 角度范围检查
-    if (angle < 0.0f || angle > SERVO_MAX_ANGLE) {
-        ESP_LOGW(TAG, "Angle %.1f out of range [0, %.1f]", angle, SERVO_MAX_ANGLE);
+    if (!servo || !servo->in_use) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // 脉冲宽度范围检查
+    if (pulse_us < servo->config.min_pulse_us || pulse_us > servo->config.max_pulse_us) {
+        ESP_LOGW(TAG, "Pulse %lu us out of range [%lu, %lu]",
+                 pulse_us, servo->config.min_pulse_us, servo->config.max_pulse_us);
         return ESP_ERR_INVALID_ARG;
     }
     
-    // 计算脉冲宽度和占空比
-    uint32_t pulse_us = angle_to_pulse(angle);
-    uint32_t duty = pulse_to_duty(pulse_us);
+    // 换算成角度后按单轴姿态写入
+    uint32_t pulse_range = servo->config.max_pulse_us - servo->config.min_pulse_us;
+    float angle = ((float)(pulse_us - servo->config.min_pulse_us) / pulse_range) * servo->config.max_angle;
+    return servo_set_pose(&servo, &angle, 1);
+}
+
+/**
+ * @brief 按梯形速度曲线移动到目标角度
+ */
+esp_err_t servo_channel_set_target(servo_handle_t servo, float angle)
+{
+    return servo_set_pose_target(&servo, &angle, 1);
+}
+
+/**
+ * @brief 由LEDC硬件渐变在指定时间内匀速移动到目标角度
+ */
+esp_err_t servo_channel_move_to(servo_handle_t servo, float angle, uint32_t duration_ms,
+                                servo_move_done_cb_t callback, void *arg)
+{
+    if (!angle_is_valid(servo, angle)) {
+        return ESP_ERR_INVALID_ARG;
+    }
     
-    // 设置LEDC占空比
-    esp_err_t ret = ledc_set_duty(LEDC_MODE, LEDC_CHANNEL, duty);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Set duty failed: %s", esp_err_to_name(ret));
+    // 不足一个PWM周期无法渐变，直接跳到目标
+    if (duration_ms < SERVO_MOTION_PERIOD_MS) {
+        esp_err_t ret = servo_channel_set_angle(servo, angle);
+        if (ret == ESP_OK && callback) {
+            callback(angle, arg);
+        }
         return ret;
     }
     
-    ret = ledc_update_duty(LEDC_MODE, LEDC_CHANNEL);
+    // 中止轨迹或上一次渐变，从当前占空比开始
+    motion_stop(servo);
+    
+    servo->fade_target = angle;
+    servo->fade_callback = callback;
+    servo->fade_arg = arg;
+    servo->fade_seq++;
+    servo->fading = true;
+    
+    uint32_t duty = pulse_to_duty(angle_to_pulse(servo, angle));
+    esp_err_t ret = ledc_set_fade_with_time(LEDC_MODE, servo->channel, duty, duration_ms);
+    if (ret == ESP_OK) {
+        ret = ledc_fade_start(LEDC_MODE, servo->channel, LEDC_FADE_NO_WAIT);
+    }
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Update duty failed: %s", esp_err_to_name(ret));
+        servo->fading = false;
+        ESP_LOGE(TAG, "Fade start failed: %s", esp_err_to_name(ret));
         return ret;
     }
     
-    s_current_angle = angle;
-    ESP_LOGI(TAG, "Servo angle set to %.1f deg (pulse=%lu us, duty=%lu)", 
-             angle, pulse_us, duty);
+    ESP_LOGD(TAG, "Servo ch%d fade to %.1f deg in %lu ms", servo->channel, angle, duration_ms);
+    return ESP_OK;
+}
+
+/**
+ * @brief 设置轨迹的速度和加速度上限
+ */
+esp_err_t servo_channel_set_motion_limits(servo_handle_t servo, float max_velocity, float max_accel)
+{
+    if (!servo || !servo->in_use || !(max_velocity > 0.0f) || !(max_accel > 0.0f)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    portENTER_CRITICAL(&s_motion_lock);
+    servo->max_velocity = max_velocity;
+    servo->max_accel = max_accel;
+    portEXIT_CRITICAL(&s_motion_lock);
     
+    ESP_LOGI(TAG, "Servo ch%d motion limits: %.1f deg/s, %.1f deg/s^2",
+             servo->channel, max_velocity, max_accel);
     return ESP_OK;
 }
 
 /**
- * @brief 设置舵机脉冲宽度
+ * @brief 获取舵机当前角度
  */
-esp_err_t servo_set_pulse(uint32_t pulse_us)
+float servo_channel_get_angle(servo_handle_t servo)
 {
-    // 脉冲宽度范围检查
-    if (pulse_us < SERVO_MIN_PULSE_US || pulse_us > SERVO_MAX_PULSE_US) {
-        ESP_LOGW(TAG, "Pulse %lu us out of range [%d, %d]", 
-                 pulse_us, SERVO_MIN_PULSE_US, SERVO_MAX_PULSE_US);
+    if (!servo || !servo->in_use) {
+        return 0.0f;
+    }
+    // 硬件渐变中从占空比寄存器读取实时位置
+    if (servo->fading) {
+        return duty_to_angle(servo, ledc_get_duty(LEDC_MODE, servo->channel));
+    }
+    return servo->current_angle;
+}
+
+/**
+ * @brief 舵机是否正在运动
+ */
+bool servo_channel_is_moving(servo_handle_t servo)
+{
+    if (!servo || !servo->in_use) {
+        return false;
+    }
+    return servo->moving || servo->fading;
+}
+
+/**
+ * @brief 同步设置多轴姿态（立即跳到目标）
+ */
+esp_err_t servo_set_pose(const servo_handle_t *handles, const float *angles, size_t count)
+{
+    if (!handles || !angles || count == 0 || count > SERVO_MAX_CHANNELS) {
         return ESP_ERR_INVALID_ARG;
     }
+    for (size_t i = 0; i < count; i++) {
+        if (!angle_is_valid(handles[i], angles[i])) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
     
-    // 计算占空比
-    uint32_t duty = pulse_to_duty(pulse_us);
+    for (size_t i = 0; i < count; i++) {
+        motion_stop(handles[i]);
+    }
+    
+    // 全部写入后连续锁存，下一个PWM周期生效
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(s_duty_mutex, portMAX_DELAY);
+    for (size_t i = 0; i < count && ret == ESP_OK; i++) {
+        struct servo_channel *servo = handles[i];
+        ret = ledc_set_duty(LEDC_MODE, servo->channel, pulse_to_duty(angle_to_pulse(servo, angles[i])));
+    }
+    for (size_t i = 0; i < count && ret == ESP_OK; i++) {
+        ret = ledc_update_duty(LEDC_MODE, handles[i]->channel);
+    }
+    if (ret == ESP_OK) {
+        portENTER_CRITICAL(&s_motion_lock);
+        for (size_t i = 0; i < count; i++) {
+            handles[i]->current_angle = angles[i];
+            handles[i]->target_angle = angles[i];
+        }
+        portEXIT_CRITICAL(&s_motion_lock);
+    }
+    xSemaphoreGive(s_duty_mutex);
     
-    // 设置LEDC占空比
-    esp_err_t ret = ledc_set_duty(LEDC_MODE, LEDC_CHANNEL, duty);
     if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Set duty failed: %s", esp_err_to_name(ret));
         return ret;
     }
     
-    ret = ledc_update_duty(LEDC_MODE, LEDC_CHANNEL);
+    ESP_LOGD(TAG, "Servo pose set (%d axes)", (int)count);
+    return ESP_OK;
+}
+
+/**
+ * @brief 多轴姿态按轨迹移动
+ */
+esp_err_t servo_set_pose_target(const servo_handle_t *handles, const float *angles, size_t count)
+{
+    if (!handles || !angles || count == 0 || count > SERVO_MAX_CHANNELS || !s_motion_timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!angle_is_valid(handles[i], angles[i])) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    
+    // 从硬件渐变的当前位置接手
+    for (size_t i = 0; i < count; i++) {
+        fade_stop(handles[i]);
+    }
+    
+    portENTER_CRITICAL(&s_motion_lock);
+    for (size_t i = 0; i < count; i++) {
+        handles[i]->target_angle = angles[i];
+        handles[i]->moving = true;
+    }
+    portEXIT_CRITICAL(&s_motion_lock);
+    
+    ESP_LOGD(TAG, "Servo pose target (%d axes)", (int)count);
+    return motion_kick();
+}
+
+/* ==================== 默认舵机接口 ==================== */
+
+/**
+ * @brief 初始化舵机驱动
+ */
+esp_err_t servo_init(void)
+{
+    if (s_default) {
+        ESP_LOGW(TAG, "Already initialized");
+        return ESP_OK;
+    }
+    
+    ESP_LOGI(TAG, "Initializing servo driver on GPIO%d", SERVO_GPIO_PIN);
+    
+    servo_config_t config = SERVO_DEFAULT_CONFIG(SERVO_GPIO_PIN);
+    esp_err_t ret = servo_channel_create(&config, &s_default);
     if (ret != ESP_OK) {
         return ret;
     }
     
-    // 更新当前角度
-    uint32_t pulse_range = SERVO_MAX_PULSE_US - SERVO_MIN_PULSE_US;
-    s_current_angle = ((float)(pulse_us - SERVO_MIN_PULSE_US) / pulse_range) * SERVO_MAX_ANGLE;
-    
-    ESP_LOGI(TAG, "Servo pulse set to %lu us (angle=%.1f deg)", pulse_us, s_current_angle);
+    // 初始化到中立位置
+    servo_center();
     
     return ESP_OK;
 }
 
+/**
+ * @brief 获取默认舵机句柄
+ */
+servo_handle_t servo_get_default(void)
+{
+    return s_default;
+}
+
+/**
+ * @brief 设置舵机角度
+ */
+esp_err_t servo_set_angle(float angle)
+{
+    if (!s_default) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return servo_channel_set_angle(s_default, angle);
+}
+
+/**
+ * @brief 设置舵机脉冲宽度
+ */
+esp_err_t servo_set_pulse(uint32_t pulse_us)
+{
+    if (!s_default) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return servo_channel_set_pulse(s_default, pulse_us);
+}
+
 /**
  * @brief 将舵机移动到中立位置
  */
@@ -178,5 +773,46 @@ esp_err_t servo_center(void)
  */
 float servo_get_angle(void)
 {
-    return s_current_angle;
+    return servo_channel_get_angle(s_default);
+}
+
+/**
+ * @brief 按梯形速度曲线移动到目标角度
+ */
+esp_err_t servo_set_target(float angle)
+{
+    if (!s_default) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return servo_channel_set_target(s_default, angle);
+}
+
+/**
+ * @brief 由LEDC硬件渐变在指定时间内匀速移动到目标角度
+ */
+esp_err_t servo_move_to(float angle, uint32_t duration_ms, servo_move_done_cb_t callback, void *arg)
+{
+    if (!s_default) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return servo_channel_move_to(s_default, angle, duration_ms, callback, arg);
+}
+
+/**
+ * @brief 设置轨迹的速度和加速度上限
+ */
+esp_err_t servo_set_motion_limits(float max_velocity, float max_accel)
+{
+    if (!s_default) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return servo_channel_set_motion_limits(s_default, max_velocity, max_accel);
+}
+
+/**
+ * @brief 舵机是否正在运动
+ */
+bool servo_is_moving(void)
+{
+    return servo_channel_is_moving(s_default);
 }
@@ -8,27 +8,213 @@
  * - 中立位置：1500μs
  * - 运行角度：270°
  * - PWM频率：50Hz（周期20ms）
+ * 
+ * 多舵机：所有通道共用一个50Hz LEDC定时器和一个轨迹定时器，
+ * 同一PWM周期内的多通道写入批量锁存，多轴姿态同时生效。
+ * 不带句柄的 servo_xxx 接口操作 SERVO_GPIO_PIN 上的默认舵机。
  */
 
 #ifndef SERVO_DRIVER_H
 #define SERVO_DRIVER_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include "esp_err.h"
 #include "driver/gpio.h"
 
 /* 舵机配置参数 */
-#define SERVO_GPIO_PIN          GPIO_NUM_2      // 舵机信号引脚
+#define SERVO_GPIO_PIN          GPIO_NUM_2      // 默认舵机信号引脚
 #define SERVO_PWM_FREQ_HZ       50              // PWM频率50Hz
 #define SERVO_MIN_PULSE_US      500             // 最小脉冲宽度(μs)
 #define SERVO_MAX_PULSE_US      2500            // 最大脉冲宽度(μs)
 #define SERVO_CENTER_PULSE_US   1500            // 中立位置脉冲宽度(μs)
 #define SERVO_MAX_ANGLE         270.0f          // 最大角度(度)
+#define SERVO_MAX_CHANNELS      6               // 最大舵机数（ESP32-C3 LEDC通道数）
+
+/* 轨迹规划参数 */
+#define SERVO_MOTION_PERIOD_MS  (1000 / SERVO_PWM_FREQ_HZ)  // 轨迹更新周期，与PWM周期一致(20ms)
+#define SERVO_MAX_VELOCITY_DPS  180.0f          // 默认最大角速度(度/秒)
+#define SERVO_MAX_ACCEL_DPS2    720.0f          // 默认最大角加速度(度/秒²)
+
+/**
+ * @brief 舵机句柄
+ */
+typedef struct servo_channel *servo_handle_t;
+
+/**
+ * @brief 舵机通道配置
+ */
+typedef struct {
+    gpio_num_t gpio_num;            // 信号引脚
+    uint32_t min_pulse_us;          // 0度对应的脉冲宽度(μs)
+    uint32_t max_pulse_us;          // 最大角度对应的脉冲宽度(μs)
+    float max_angle;                // 最大角度(度)
+} servo_config_t;
+
+/* TD-8120MG 默认配置 */
+#define SERVO_DEFAULT_CONFIG(gpio) {            \
+    .gpio_num = (gpio),                         \
+    .min_pulse_us = SERVO_MIN_PULSE_US,         \
+    .max_pulse_us = SERVO_MAX_PULSE_US,         \
+    .max_angle = SERVO_MAX_ANGLE,               \
+}
+
+/**
+ * @brief 定时移动完成回调函数类型
+ * 
+ * 在FreeRTOS定时器服务任务中调用，不可长时间阻塞
+ * 
+ * @param angle 到达的角度
+ * @param arg 用户参数
+ */
+typedef void (*servo_move_done_cb_t)(float angle, void *arg);
+
+/* ==================== 多舵机接口 ==================== */
+
+/**
+ * @brief 创建舵机通道
+ * 
+ * 首次调用时配置共用的LEDC定时器、渐变中断和轨迹定时器。
+ * 创建后输出保持低电平，第一次设置角度后开始输出脉冲。
+ * 
+ * @param config 通道配置
+ * @param handle 输出句柄
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效
+ *     - ESP_ERR_NO_MEM: 通道已用完
+ *     - 其他: LEDC错误
+ */
+esp_err_t servo_channel_create(const servo_config_t *config, servo_handle_t *handle);
+
+/**
+ * @brief 删除舵机通道
+ * 
+ * 停止运动并关闭输出，释放LEDC通道
+ * 
+ * @param handle 舵机句柄
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 句柄无效
+ */
+esp_err_t servo_channel_delete(servo_handle_t handle);
+
+/**
+ * @brief 设置舵机角度（立即跳到目标，中止正在进行的运动）
+ * 
+ * @param handle 舵机句柄
+ * @param angle 目标角度 (0 ~ max_angle)
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 角度超出范围
+ */
+esp_err_t servo_channel_set_angle(servo_handle_t handle, float angle);
+
+/**
+ * @brief 设置舵机脉冲宽度（立即生效，中止正在进行的运动）
+ * 
+ * @param handle 舵机句柄
+ * @param pulse_us 脉冲宽度 (min_pulse_us ~ max_pulse_us)
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 脉冲宽度超出范围
+ */
+esp_err_t servo_channel_set_pulse(servo_handle_t handle, uint32_t pulse_us);
+
+/**
+ * @brief 按梯形速度曲线移动到目标角度
+ * 
+ * 由共用轨迹定时器每个PWM周期更新一次，同一周期内所有运动中舵机的占空比一起锁存。
+ * 运动中再次调用会以当前位置和速度为起点平滑转向新目标。
+ * 
+ * @param handle 舵机句柄
+ * @param angle 目标角度
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 角度超出范围
+ */
+esp_err_t servo_channel_set_target(servo_handle_t handle, float angle);
+
+/**
+ * @brief 由LEDC硬件渐变在指定时间内匀速移动到目标角度
+ * 
+ * 参见 servo_move_to
+ * 
+ * @param handle 舵机句柄
+ * @param angle 目标角度
+ * @param duration_ms 移动时间(ms)，0表示立即跳到目标并同步回调
+ * @param callback 完成回调，可为NULL
+ * @param arg 回调用户参数
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 角度超出范围
+ */
+esp_err_t servo_channel_move_to(servo_handle_t handle, float angle, uint32_t duration_ms,
+                                servo_move_done_cb_t callback, void *arg);
+
+/**
+ * @brief 设置轨迹的速度和加速度上限
+ * 
+ * @param handle 舵机句柄
+ * @param max_velocity 最大角速度(度/秒)
+ * @param max_accel 最大角加速度(度/秒²)
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 参数不为正数
+ */
+esp_err_t servo_channel_set_motion_limits(servo_handle_t handle, float max_velocity, float max_accel);
+
+/**
+ * @brief 获取舵机当前角度
+ * 
+ * @param handle 舵机句柄
+ * @return 当前角度，句柄无效返回0
+ */
+float servo_channel_get_angle(servo_handle_t handle);
+
+/**
+ * @brief 舵机是否正在运动（轨迹或硬件渐变）
+ * 
+ * @param handle 舵机句柄
+ * @return true=运动中
+ */
+bool servo_channel_is_moving(servo_handle_t handle);
+
+/**
+ * @brief 同步设置多轴姿态（立即跳到目标）
+ * 
+ * 先写入全部通道的占空比，再连续锁存，各通道在下一个PWM周期起点生效（通常为同一周期）
+ * 
+ * @param handles 舵机句柄数组
+ * @param angles 目标角度数组
+ * @param count 舵机数量
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效或任一角度超出范围（不修改任何通道）
+ */
+esp_err_t servo_set_pose(const servo_handle_t *handles, const float *angles, size_t count);
+
+/**
+ * @brief 多轴姿态按轨迹移动
+ * 
+ * 各轴同时出发，目标在同一临界区内写入，不会被轨迹定时器拆到两个周期
+ * 
+ * @param handles 舵机句柄数组
+ * @param angles 目标角度数组
+ * @param count 舵机数量
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效或任一角度超出范围（不修改任何通道）
+ */
+esp_err_t servo_set_pose_target(const servo_handle_t *handles, const float *angles, size_t count);
+
+/* ==================== 默认舵机接口 ==================== */
 
 /**
  * @brief 初始化舵机驱动
  * 
- * 配置LEDC外设产生50Hz PWM信号
+ * 在 SERVO_GPIO_PIN 上创建默认舵机并移动到中立位置
  * 
  * @return 
  *     - ESP_OK: 成功
@@ -36,9 +222,18 @@
  */
 esp_err_t servo_init(void);
 
+/**
+ * @brief 获取默认舵机句柄
+ * 
+ * @return 句柄，未初始化返回NULL
+ */
+servo_handle_t servo_get_default(void);
+
 /**
  * @brief 设置舵机角度
  * 
+ * 直接跳到目标占空比，会中止正在进行的轨迹
+ * 
  * @param angle 目标角度 (0.0 ~ 270.0度)
  * @return 
  *     - ESP_OK: 成功
@@ -46,6 +241,59 @@ esp_err_t servo_init(void);
  */
 esp_err_t servo_set_angle(float angle);
 
+/**
+ * @brief 按梯形速度曲线移动到目标角度
+ * 
+ * 由 esp_timer 每个PWM周期更新一次占空比，立即返回不阻塞。
+ * 运动中再次调用会以当前位置和速度为起点平滑转向新目标，不会突变。
+ * 
+ * @param angle 目标角度 (0.0 ~ 270.0度)
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 角度超出范围
+ *     - ESP_ERR_INVALID_STATE: 未初始化
+ */
+esp_err_t servo_set_target(float angle);
+
+/**
+ * @brief 由LEDC硬件渐变在指定时间内匀速移动到目标角度
+ * 
+ * 渐变过程完全由硬件完成，每个PWM周期无需CPU参与，适合BLE+WiFi共存时CPU繁忙的场景。
+ * 运动中再次调用会从当前占空比开始新的渐变，被打断的移动不再回调。
+ * 与 servo_set_target 互斥：任一方调用都会中止另一方正在进行的运动。
+ * 
+ * @param angle 目标角度 (0.0 ~ 270.0度)
+ * @param duration_ms 移动时间(ms)，0表示立即跳到目标并同步回调
+ * @param callback 完成回调，可为NULL
+ * @param arg 回调用户参数
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 角度超出范围
+ *     - ESP_ERR_INVALID_STATE: 未初始化
+ */
+esp_err_t servo_move_to(float angle, uint32_t duration_ms, servo_move_done_cb_t callback, void *arg);
+
+/**
+ * @brief 设置轨迹的速度和加速度上限
+ * 
+ * 对运动中的轨迹立即生效
+ * 
+ * @param max_velocity 最大角速度(度/秒)
+ * @param max_accel 最大角加速度(度/秒²)
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_ARG: 参数不为正数
+ *     - ESP_ERR_INVALID_STATE: 未初始化
+ */
+esp_err_t servo_set_motion_limits(float max_velocity, float max_accel);
+
+/**
+ * @brief 舵机是否正在运动（轨迹或硬件渐变）
+ * 
+ * @return true=运动中
+ */
+bool servo_is_moving(void);
+
 /**
  * @brief 设置舵机脉冲宽度
  * 
@@ -2,6 +2,11 @@
  * WiFi管理器 - 实现文件
  * 
  * 功能：管理WiFi连接
+ * 
+ * 连接策略：
+ * - 凭据和上次关联的 BSSID/信道保存在NVS，上电后固定 BSSID+信道直接关联，跳过全信道扫描
+ * - 快速连接失败（AP更换或换信道）立即改为全信道扫描，按信号强度选AP
+ * - 全信道扫描仍失败则按指数退避重试，不设上限
  */
 
 #include "wifi_manager.h"
@@ -9,6 +14,9 @@
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_netif.h"
+#include "esp_timer.h"
+#include "esp_mac.h"
+#include "nvs.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
@@ -21,13 +29,171 @@ static const char* TAG = "WIFI_MGR";
 #define WIFI_CONNECTED_BIT BIT0
 #define WIFI_FAIL_BIT      BIT1
 
+/* NVS键 */
+#define WIFI_NVS_KEY_CONFIG "cfg"
+
+/**
+ * @brief NVS中保存的连接参数
+ */
+typedef struct {
+    char ssid[33];
+    char password[65];
+    uint8_t bssid[6];
+    uint8_t channel;            // 上次关联AP的信道，0表示没有记录
+} wifi_stored_config_t;
+
 /* 全局变量 */
 static wifi_status_callback_t s_status_callback = NULL;
 static EventGroupHandle_t s_wifi_event_group = NULL;
 static int s_retry_num = 0;
-static const int WIFI_MAX_RETRY = 5;
 static bool s_connected = false;
+static wifi_stored_config_t s_stored = {0};
+static bool s_has_stored = false;
+static bool s_fast_connect = false;         // 当前尝试是否固定 BSSID/信道
+static bool s_auto_reconnect = false;       // 主动断开后不再重连
+static uint32_t s_backoff_ms = WIFI_BACKOFF_MIN_MS;
+static esp_timer_handle_t s_retry_timer = NULL;
+static int64_t s_connect_start_us = 0;
+static bool s_connecting = false;           // 有连接尝试正在进行
+static bool s_scanning = false;             // 有扫描正在进行
+static wifi_progress_callback_t s_progress_callback = NULL;
+static wifi_scan_callback_t s_scan_callback = NULL;
+static wifi_ap_record_t s_scan_records[WIFI_SCAN_MAX_AP];
 static char s_ip_addr[16] = {0};
+static wifi_ps_type_t s_ps_type = WIFI_PS_MIN_MODEM;     // 省电模式（默认DTIM1）
+static uint8_t s_listen_interval = 0;                   // 监听间隔，0为默认
+
+/**
+ * @brief 从NVS读取连接参数
+ */
+static void load_stored_config(void)
+{
+    nvs_handle_t handle;
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+    
+    size_t len = sizeof(s_stored);
+    esp_err_t ret = nvs_get_blob(handle, WIFI_NVS_KEY_CONFIG, &s_stored, &len);
+    nvs_close(handle);
+    
+    s_has_stored = (ret == ESP_OK && len == sizeof(s_stored) && s_stored.ssid[0] != '\0');
+    if (!s_has_stored) {
+        memset(&s_stored, 0, sizeof(s_stored));
+    }
+}
+
+/**
+ * @brief 保存连接参数到NVS
+ */
+static void save_stored_config(void)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(WIFI_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret == ESP_OK) {
+        ret = nvs_set_blob(handle, WIFI_NVS_KEY_CONFIG, &s_stored, sizeof(s_stored));
+        if (ret == ESP_OK) {
+            ret = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save WiFi config: %s", esp_err_to_name(ret));
+    }
+}
+
+/**
+ * @brief 按保存的参数发起一次连接
+ * 
+ * @param fast true=固定 BSSID+信道，false=全信道扫描按信号强度选AP
+ */
+static void start_connect(bool fast)
+{
+    wifi_config_t wifi_config = {0};
+    strncpy((char*)wifi_config.sta.ssid, s_stored.ssid, sizeof(wifi_config.sta.ssid));
+    strncpy((char*)wifi_config.sta.password, s_stored.password, sizeof(wifi_config.sta.password));
+    wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+    wifi_config.sta.listen_interval = s_listen_interval;
+    
+    if (fast) {
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, s_stored.bssid, sizeof(wifi_config.sta.bssid));
+        wifi_config.sta.channel = s_stored.channel;
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+    } else {
+        wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        wifi_config.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    }
+    s_fast_connect = fast;
+    
+    esp_err_t ret = esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+    if (ret == ESP_OK) {
+        ret = esp_wifi_connect();
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Connect request failed: %s", esp_err_to_name(ret));
+        return;
+    }
+    s_connecting = true;
+    if (s_progress_callback) {
+        s_progress_callback(WIFI_MANAGER_CONNECTING, 0, s_retry_num + 1);
+    }
+}
+
+/**
+ * @brief 退避定时器回调：重新发起全信道扫描连接
+ */
+static void retry_timer_callback(void *arg)
+{
+    // 扫描期间不发起连接，扫描完成后重新调度
+    if (s_auto_reconnect && !s_connected && !s_scanning) {
+        start_connect(false);
+    }
+}
+
+/**
+ * @brief 扫描完成：取出结果交给回调，恢复被扫描推迟的重连
+ */
+static void handle_scan_done(void)
+{
+    uint16_t count = WIFI_SCAN_MAX_AP;
+    if (esp_wifi_scan_get_ap_records(&count, s_scan_records) != ESP_OK) {
+        count = 0;
+    }
+    s_scanning = false;
+    ESP_LOGI(TAG, "Scan done, %d APs", count);
+    
+    wifi_scan_callback_t callback = s_scan_callback;
+    s_scan_callback = NULL;
+    if (callback) {
+        callback(s_scan_records, count);
+    }
+    
+    if (s_auto_reconnect && !s_connected && !s_connecting) {
+        esp_timer_stop(s_retry_timer);
+        esp_timer_start_once(s_retry_timer, (uint64_t)s_backoff_ms * 1000);
+    }
+}
+
+/**
+ * @brief 连接成功后记录AP的 BSSID/信道，变化时才写NVS
+ */
+static void remember_ap(void)
+{
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return;
+    }
+    if (memcmp(s_stored.bssid, ap.bssid, sizeof(s_stored.bssid)) == 0 &&
+        s_stored.channel == ap.primary) {
+        return;
+    }
+    
+    memcpy(s_stored.bssid, ap.bssid, sizeof(s_stored.bssid));
+    s_stored.channel = ap.primary;
+    save_stored_config();
+    ESP_LOGI(TAG, "Stored AP " MACSTR " on channel %d", MAC2STR(ap.bssid), ap.primary);
+}
 
 /**
  * @brief WiFi事件处理函数
@@ -39,7 +205,14 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
         switch (event_id) {
         case WIFI_EVENT_STA_START:
             ESP_LOGI(TAG, "WiFi station started");
-            esp_wifi_connect();
+            if (s_has_stored) {
+                ESP_LOGI(TAG, "Connecting to stored WiFi: %s (channel %d)", s_stored.ssid, s_stored.channel);
+                s_auto_reconnect = true;
+                s_connect_start_us = esp_timer_get_time();
+                start_connect(s_stored.channel != 0);
+            } else {
+                ESP_LOGI(TAG, "No stored WiFi config, waiting for provisioning");
+            }
             break;
             
         case WIFI_EVENT_STA_CONNECTED:
@@ -47,22 +220,45 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
             s_retry_num = 0;
             break;
             
-        case WIFI_EVENT_STA_DISCONNECTED:
-            ESP_LOGI(TAG, "WiFi disconnected");
+        case WIFI_EVENT_SCAN_DONE:
+            handle_scan_done();
+            break;
+            
+        case WIFI_EVENT_STA_DISCONNECTED: {
+            wifi_event_sta_disconnected_t *event = (wifi_event_sta_disconnected_t *)event_data;
+            ESP_LOGI(TAG, "WiFi disconnected (reason %d)", event->reason);
             s_connected = false;
+            s_connecting = false;
             if (s_status_callback) {
                 s_status_callback(false, NULL);
             }
             
-            if (s_retry_num < WIFI_MAX_RETRY) {
-                esp_wifi_connect();
-                s_retry_num++;
-                ESP_LOGI(TAG, "Retry to connect to AP (%d/%d)", s_retry_num, WIFI_MAX_RETRY);
-            } else {
+            if (!s_auto_reconnect) {
+                break;
+            }
+            
+            s_retry_num++;
+            if (s_retry_num == WIFI_FAIL_NOTIFY_RETRY) {
+                // 通知等待中的 wifi_manager_connect，后台继续重试
                 xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
-                ESP_LOGE(TAG, "Failed to connect after %d retries", WIFI_MAX_RETRY);
+                ESP_LOGE(TAG, "Failed to connect after %d retries, still retrying", s_retry_num);
+            }
+            if (s_progress_callback) {
+                s_progress_callback(s_retry_num >= WIFI_FAIL_NOTIFY_RETRY ? WIFI_MANAGER_FAILED : WIFI_MANAGER_RETRYING,
+                                    event->reason, s_retry_num);
+            }
+            
+            if (s_fast_connect) {
+                // 记录的AP不可用（更换路由或信道）：立即改为全信道扫描
+                ESP_LOGW(TAG, "Fast connect failed, falling back to full scan");
+                start_connect(false);
+            } else {
+                ESP_LOGI(TAG, "Retry to connect to AP in %lu ms (attempt %d)", s_backoff_ms, s_retry_num);
+                esp_timer_start_once(s_retry_timer, (uint64_t)s_backoff_ms * 1000);
+                s_backoff_ms = s_backoff_ms * 2 > WIFI_BACKOFF_MAX_MS ? WIFI_BACKOFF_MAX_MS : s_backoff_ms * 2;
             }
             break;
+        }
             
         default:
             break;
@@ -74,8 +270,21 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
             
             snprintf(s_ip_addr, sizeof(s_ip_addr), IPSTR, IP2STR(&event->ip_info.ip));
             s_connected = true;
+            s_connecting = false;
+            s_retry_num = 0;
+            s_backoff_ms = WIFI_BACKOFF_MIN_MS;
             xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
             
+            if (s_connect_start_us > 0) {
+                ESP_LOGI(TAG, "Connected in %lld ms (%s)", (esp_timer_get_time() - s_connect_start_us) / 1000,
+                         s_fast_connect ? "fast" : "full scan");
+                s_connect_start_us = 0;
+            }
+            remember_ap();
+            if (s_progress_callback) {
+                s_progress_callback(WIFI_MANAGER_CONNECTED, 0, 0);
+            }
+            
             if (s_status_callback) {
                 s_status_callback(true, s_ip_addr);
             }
@@ -102,10 +311,23 @@ esp_err_t wifi_manager_init(wifi_status_callback_t callback)
     // 创建事件组
     s_wifi_event_group = xEventGroupCreate();
     
+    // 退避重连定时器
+    const esp_timer_create_args_t timer_args = {
+        .callback = retry_timer_callback,
+        .name = "wifi_retry",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_retry_timer));
+    
+    // 读取保存的凭据，STA启动后自动连接
+    load_stored_config();
+    
     // WiFi配置
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
     
+    // 凭据由本模块保存，驱动不再在每次 set_config 时写Flash
+    ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM));
+    
     // 注册事件处理器
     ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
                                                         ESP_EVENT_ANY_ID,
@@ -121,17 +343,19 @@ esp_err_t wifi_manager_init(wifi_status_callback_t callback)
     // 设置WiFi模式为STA
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_start());
+    ESP_ERROR_CHECK(esp_wifi_set_ps(s_ps_type));
     
     ESP_LOGI(TAG, "WiFi manager initialized");
     return ESP_OK;
 }
 
 /**
- * @brief 连接WiFi
+ * @brief 发起WiFi连接（不等待结果）
  */
-esp_err_t wifi_manager_connect(const char *ssid, const char *password)
+esp_err_t wifi_manager_start_connect(const char *ssid, const char *password)
 {
-    if (!ssid || strlen(ssid) == 0) {
+    if (!ssid || strlen(ssid) == 0 || strlen(ssid) >= sizeof(s_stored.ssid) ||
+        (password && strlen(password) >= sizeof(s_stored.password))) {
         ESP_LOGE(TAG, "Invalid SSID");
         return ESP_ERR_INVALID_ARG;
     }
@@ -140,25 +364,51 @@ esp_err_t wifi_manager_connect(const char *ssid, const char *password)
     
     // 清除事件组
     xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT);
+    esp_timer_stop(s_retry_timer);
     s_retry_num = 0;
+    s_backoff_ms = WIFI_BACKOFF_MIN_MS;
     
-    // 配置WiFi
-    wifi_config_t wifi_config = {0};
-    strncpy((char*)wifi_config.sta.ssid, ssid, sizeof(wifi_config.sta.ssid) - 1);
-    if (password) {
-        strncpy((char*)wifi_config.sta.password, password, sizeof(wifi_config.sta.password) - 1);
+    // 凭据变化时保存，原记录的AP作废；凭据相同且有AP记录时走快速连接
+    if (!password) {
+        password = "";
+    }
+    if (!s_has_stored || strcmp(s_stored.ssid, ssid) != 0 || strcmp(s_stored.password, password) != 0) {
+        memset(&s_stored, 0, sizeof(s_stored));
+        strncpy(s_stored.ssid, ssid, sizeof(s_stored.ssid) - 1);
+        strncpy(s_stored.password, password, sizeof(s_stored.password) - 1);
+        s_has_stored = true;
+        save_stored_config();
+    }
+    
+    s_auto_reconnect = true;
+    s_connect_start_us = esp_timer_get_time();
+    if (s_scanning) {
+        // 扫描完成后由 handle_scan_done 发起连接
+        ESP_LOGI(TAG, "Scan in progress, connect deferred");
+        s_fast_connect = false;
+    } else {
+        start_connect(s_stored.channel != 0);
     }
-    wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
     
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
-    ESP_ERROR_CHECK(esp_wifi_connect());
+    return ESP_OK;
+}
+
+/**
+ * @brief 连接WiFi
+ */
+esp_err_t wifi_manager_connect(const char *ssid, const char *password)
+{
+    esp_err_t ret = wifi_manager_start_connect(ssid, password);
+    if (ret != ESP_OK) {
+        return ret;
+    }
     
     // 等待连接结果
     EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
                                           WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
                                           pdFALSE,
                                           pdFALSE,
-                                          pdMS_TO_TICKS(30000));
+                                          pdMS_TO_TICKS(WIFI_CONNECT_TIMEOUT_MS));
     
     if (bits & WIFI_CONNECTED_BIT) {
         ESP_LOGI(TAG, "WiFi connected successfully");
@@ -178,6 +428,8 @@ esp_err_t wifi_manager_connect(const char *ssid, const char *password)
 esp_err_t wifi_manager_disconnect(void)
 {
     ESP_LOGI(TAG, "Disconnecting WiFi");
+    s_auto_reconnect = false;
+    esp_timer_stop(s_retry_timer);
     ESP_ERROR_CHECK(esp_wifi_disconnect());
     s_connected = false;
     if (s_status_callback) {
@@ -186,6 +438,41 @@ esp_err_t wifi_manager_disconnect(void)
     return ESP_OK;
 }
 
+/**
+ * @brief 设置连接进度回调
+ */
+void wifi_manager_set_progress_callback(wifi_progress_callback_t callback)
+{
+    s_progress_callback = callback;
+}
+
+/**
+ * @brief 异步扫描周围的AP
+ */
+esp_err_t wifi_manager_scan(wifi_scan_callback_t callback)
+{
+    if (s_scanning || s_connecting) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // 退避等待中的重连推迟到扫描完成
+    esp_timer_stop(s_retry_timer);
+    s_scan_callback = callback;
+    s_scanning = true;
+    esp_err_t ret = esp_wifi_scan_start(NULL, false);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Scan start failed: %s", esp_err_to_name(ret));
+        s_scanning = false;
+        s_scan_callback = NULL;
+        if (s_auto_reconnect && !s_connected) {
+            esp_timer_start_once(s_retry_timer, (uint64_t)s_backoff_ms * 1000);
+        }
+        return ret;
+    }
+    
+    return ESP_OK;
+}
+
 /**
  * @brief 获取WiFi连接状态
  */
@@ -211,3 +498,22 @@ const char* wifi_manager_get_ip(char *ip_buf, size_t buf_size)
     return s_ip_addr;
 }
 
+/**
+ * @brief 设置WiFi省电模式
+ */
+esp_err_t wifi_manager_set_power_save(wifi_ps_type_t ps_type, uint8_t listen_interval)
+{
+    s_listen_interval = (ps_type == WIFI_PS_MAX_MODEM) ? listen_interval : 0;
+    
+    esp_err_t ret = esp_wifi_set_ps(ps_type);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Set power save failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    s_ps_type = ps_type;
+    ESP_LOGI(TAG, "Power save %s (listen interval=%d)",
+             ps_type == WIFI_PS_MAX_MODEM ? "MAX_MODEM" : (ps_type == WIFI_PS_MIN_MODEM ? "MIN_MODEM" : "NONE"),
+             s_listen_interval);
+    return ESP_OK;
+}
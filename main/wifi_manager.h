@@ -2,14 +2,25 @@
  * WiFi管理器 - 头文件
  * 
  * 功能：管理WiFi连接，支持通过BLE配置WiFi参数
+ * 
+ * 凭据和上次关联的 BSSID/信道保存在NVS，上电后直接连接，无需重新配网
  */
 
 #ifndef WIFI_MANAGER_H
 #define WIFI_MANAGER_H
 
 #include "esp_err.h"
+#include "esp_wifi.h"
 #include <stdbool.h>
 
+/* 配置参数 */
+#define WIFI_NVS_NAMESPACE          "wifi"      // NVS命名空间
+#define WIFI_CONNECT_TIMEOUT_MS     30000       // wifi_manager_connect 等待结果的超时(ms)
+#define WIFI_FAIL_NOTIFY_RETRY      5           // 连续失败次数达到后 wifi_manager_connect 返回失败（后台继续重试）
+#define WIFI_BACKOFF_MIN_MS         500         // 全信道扫描重连的初始退避(ms)
+#define WIFI_BACKOFF_MAX_MS         60000       // 最大退避(ms)
+#define WIFI_SCAN_MAX_AP            16          // 扫描结果最多保留的AP数
+
 /**
  * @brief WiFi连接状态回调函数类型
  * 
@@ -18,9 +29,38 @@
  */
 typedef void (*wifi_status_callback_t)(bool connected, const char *ip_addr);
 
+/**
+ * @brief 连接进度
+ */
+typedef enum {
+    WIFI_MANAGER_CONNECTING = 0,    // 开始一次连接尝试
+    WIFI_MANAGER_CONNECTED,         // 已获取IP
+    WIFI_MANAGER_RETRYING,          // 本次尝试失败，即将重试
+    WIFI_MANAGER_FAILED,            // 连续失败达到 WIFI_FAIL_NOTIFY_RETRY 次（后台继续重试）
+} wifi_manager_state_t;
+
+/**
+ * @brief 连接进度回调函数类型（在事件循环任务中调用）
+ * 
+ * @param state 进度
+ * @param reason 断开原因（wifi_err_reason_t），仅 RETRYING/FAILED 有效
+ * @param attempt 第几次尝试
+ */
+typedef void (*wifi_progress_callback_t)(wifi_manager_state_t state, uint8_t reason, int attempt);
+
+/**
+ * @brief 扫描完成回调函数类型（在事件循环任务中调用）
+ * 
+ * @param records AP列表，仅在回调期间有效
+ * @param count AP数量
+ */
+typedef void (*wifi_scan_callback_t)(const wifi_ap_record_t *records, uint16_t count);
+
 /**
  * @brief 初始化WiFi管理器
  * 
+ * 需在NVS初始化之后调用。NVS中有保存的凭据时，STA启动后立即按记录的 BSSID/信道快速连接
+ * 
  * @param callback 连接状态回调函数
  * @return 
  *     - ESP_OK: 成功
@@ -31,17 +71,56 @@ esp_err_t wifi_manager_init(wifi_status_callback_t callback);
 /**
  * @brief 连接WiFi
  * 
+ * 凭据变化时保存到NVS。失败后在后台按指数退避持续重试，直到连接成功或调用 wifi_manager_disconnect
+ * 
  * @param ssid WiFi SSID
  * @param password WiFi密码
  * @return 
- *     - ESP_OK: 开始连接
+ *     - ESP_OK: 连接成功
+ *     - ESP_FAIL: 连续多次失败（后台继续重试）
+ *     - ESP_ERR_TIMEOUT: 等待超时（后台继续重试）
  *     - ESP_ERR_INVALID_ARG: 参数无效
  */
 esp_err_t wifi_manager_connect(const char *ssid, const char *password);
 
+/**
+ * @brief 发起WiFi连接，不等待结果
+ * 
+ * 与 wifi_manager_connect 相同，但立即返回，结果通过进度回调和状态回调通知
+ * 
+ * @param ssid WiFi SSID
+ * @param password WiFi密码
+ * @return 
+ *     - ESP_OK: 已开始连接
+ *     - ESP_ERR_INVALID_ARG: 参数无效
+ */
+esp_err_t wifi_manager_start_connect(const char *ssid, const char *password);
+
+/**
+ * @brief 设置连接进度回调
+ * 
+ * @param callback 进度回调函数
+ */
+void wifi_manager_set_progress_callback(wifi_progress_callback_t callback);
+
+/**
+ * @brief 异步扫描周围的AP
+ * 
+ * 扫描期间暂停退避重连，扫描完成后恢复
+ * 
+ * @param callback 扫描完成回调
+ * @return 
+ *     - ESP_OK: 已开始扫描
+ *     - ESP_ERR_INVALID_STATE: 正在连接或扫描
+ *     - 其他: esp_wifi_scan_start 返回的错误
+ */
+esp_err_t wifi_manager_scan(wifi_scan_callback_t callback);
+
 /**
  * @brief 断开WiFi连接
  * 
+ * 停止自动重连，保存的凭据保留
+ * 
  * @return 
  *     - ESP_OK: 成功
  */
@@ -63,5 +142,18 @@ bool wifi_manager_is_connected(void);
  */
 const char* wifi_manager_get_ip(char *ip_buf, size_t buf_size);
 
+/**
+ * @brief 设置WiFi省电模式
+ * 
+ * 省电模式立即生效；监听间隔在下次关联AP时生效
+ * 
+ * @param ps_type 省电模式（与BLE共存时不能为 WIFI_PS_NONE）
+ * @param listen_interval WIFI_PS_MAX_MODEM 下的监听间隔（信标周期数），0使用默认值
+ * @return 
+ *     - ESP_OK: 成功
+ *     - 其他: esp_wifi_set_ps 返回的错误
+ */
+esp_err_t wifi_manager_set_power_save(wifi_ps_type_t ps_type, uint8_t listen_interval);
+
 #endif // WIFI_MANAGER_H
 
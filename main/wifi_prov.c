@@ -0,0 +1,193 @@
+/*
+ * WiFi配网 - 实现文件
+ * 
+ * 功能：解析配网请求，把扫描结果和连接进度编码为JSON并分块通知
+ */
+
+#include "wifi_prov.h"
+#include "wifi_manager.h"
+#include "ble_service.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "cJSON.h"
+#include <string.h>
+#include <stdio.h>
+
+/* 日志标签 */
+static const char* TAG = "WIFI_PROV";
+
+/* 全局变量 */
+static SemaphoreHandle_t s_lock = NULL;         // 保护消息缓冲（事件循环任务和命令任务都会发送）
+static char s_msg[WIFI_PROV_MSG_MAX];
+static uint8_t s_chunk[BLE_LOCAL_MTU];
+
+/**
+ * @brief 把消息按MTU分块通知（持锁调用）
+ */
+static void send_message(const char *msg, int len)
+{
+    // 通知最大负载为 MTU-3，分块头占1字节
+    int chunk_max = ble_service_get_mtu() - 3 - 1;
+    if (chunk_max > (int)sizeof(s_chunk) - 1) {
+        chunk_max = sizeof(s_chunk) - 1;
+    }
+    
+    uint8_t seq = 0;
+    int offset = 0;
+    do {
+        int n = len - offset < chunk_max ? len - offset : chunk_max;
+        s_chunk[0] = (seq++ & 0x7F) | (offset + n >= len ? WIFI_PROV_CHUNK_LAST : 0);
+        memcpy(s_chunk + 1, msg + offset, n);
+        if (ble_service_notify_prov(s_chunk, n + 1) != ESP_OK) {
+            // 未连接或未订阅：丢弃剩余分块
+            return;
+        }
+        offset += n;
+    } while (offset < len);
+}
+
+/**
+ * @brief 发送一条格式化的短消息
+ */
+static void send_text(const char *text)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    send_message(text, strlen(text));
+    xSemaphoreGive(s_lock);
+}
+
+/**
+ * @brief 写入JSON转义后的字符串
+ * 
+ * @return 写入的字节数，空间不足返回-1
+ */
+static int append_escaped(char *buf, int size, const char *str)
+{
+    int n = 0;
+    for (const char *p = str; *p; p++) {
+        char c = *p;
+        if (c == '"' || c == '\\') {
+            if (n + 2 >= size) {
+                return -1;
+            }
+            buf[n++] = '\\';
+            buf[n++] = c;
+        } else if ((unsigned char)c >= 0x20) {
+            if (n + 1 >= size) {
+                return -1;
+            }
+            buf[n++] = c;
+        }
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+/**
+ * @brief 扫描完成回调：编码AP列表并分块通知
+ */
+static void on_scan_done(const wifi_ap_record_t *records, uint16_t count)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    
+    int len = snprintf(s_msg, sizeof(s_msg), "{\"scan\":[");
+    int added = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        char ssid[72];
+        if (append_escaped(ssid, sizeof(ssid), (const char *)records[i].ssid) < 0) {
+            continue;
+        }
+        int n = snprintf(s_msg + len, sizeof(s_msg) - len, "%s{\"ssid\":\"%s\",\"rssi\":%d,\"ch\":%d,\"auth\":%d}",
+                         added > 0 ? "," : "", ssid, records[i].rssi, records[i].primary, records[i].authmode);
+        // 留出结尾 "]}" 的空间，放不下的AP舍弃
+        if (n < 0 || len + n + 3 > sizeof(s_msg)) {
+            ESP_LOGW(TAG, "Scan result truncated at %d APs", i);
+            break;
+        }
+        len += n;
+        added++;
+    }
+    len += snprintf(s_msg + len, sizeof(s_msg) - len, "]}");
+
+    send_message(s_msg, len);
+    xSemaphoreGive(s_lock);
+}
+
+/**
+ * @brief 连接进度回调
+ */
+static void on_progress(wifi_manager_state_t state, uint8_t reason, int attempt)
+{
+    char text[80];
+    char ip[16] = {0};
+
+    switch (state) {
+    case WIFI_MANAGER_CONNECTING:
+        snprintf(text, sizeof(text), "{\"state\":\"connecting\",\"attempt\":%d}", attempt);
+        break;
+    case WIFI_MANAGER_CONNECTED:
+        wifi_manager_get_ip(ip, sizeof(ip));
+        snprintf(text, sizeof(text), "{\"state\":\"connected\",\"ip\":\"%s\"}", ip);
+        break;
+    case WIFI_MANAGER_RETRYING:
+        snprintf(text, sizeof(text), "{\"state\":\"retrying\",\"reason\":%d,\"attempt\":%d}", reason, attempt);
+        break;
+    case WIFI_MANAGER_FAILED:
+        snprintf(text, sizeof(text), "{\"state\":\"failed\",\"reason\":%d,\"attempt\":%d}", reason, attempt);
+        break;
+    default:
+        return;
+    }
+    send_text(text);
+}
+
+/**
+ * @brief 初始化配网模块
+ */
+esp_err_t wifi_prov_init(void)
+{
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock) {
+        ESP_LOGE(TAG, "Failed to create mutex");
+        return ESP_ERR_NO_MEM;
+    }
+
+    wifi_manager_set_progress_callback(on_progress);
+    return ESP_OK;
+}
+
+/**
+ * @brief 处理配网请求
+ */
+void wifi_prov_handle_request(const char *request_json)
+{
+    cJSON *json = cJSON_Parse(request_json);
+    if (!json) {
+        ESP_LOGW(TAG, "Invalid provisioning request");
+        send_text("{\"error\":\"invalid\"}");
+        return;
+    }
+
+    cJSON *cmd = cJSON_GetObjectItem(json, "cmd");
+    cJSON *ssid = cJSON_GetObjectItem(json, "ssid");
+    cJSON *password = cJSON_GetObjectItem(json, "password");
+
+    if (cmd && cJSON_IsString(cmd) && strcmp(cmd->valuestring, "scan") == 0) {
+        ESP_LOGI(TAG, "Scan requested");
+        if (wifi_manager_scan(on_scan_done) != ESP_OK) {
+            send_text("{\"error\":\"busy\"}");
+        }
+    } else if (ssid && cJSON_IsString(ssid)) {
+        const char *pass = (password && cJSON_IsString(password)) ? password->valuestring : "";
+        ESP_LOGI(TAG, "WiFi config: SSID=%s", ssid->valuestring);
+        if (wifi_manager_start_connect(ssid->valuestring, pass) != ESP_OK) {
+            send_text("{\"error\":\"invalid\"}");
+        }
+    } else {
+        ESP_LOGW(TAG, "Unknown provisioning request");
+        send_text("{\"error\":\"invalid\"}");
+    }
+
+    cJSON_Delete(json);
+}
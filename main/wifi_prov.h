@@ -0,0 +1,48 @@
+/*
+ * WiFi配网 - 头文件
+ * 
+ * 功能：通过BLE配网，扫描结果和连接进度通过配网状态特征值（0xFF08）通知回客户端
+ * 
+ * 请求（写入WiFi配置特征值 0xFF04，JSON）：
+ * - {"cmd":"scan"}                         扫描周围AP
+ * - {"ssid":"xxx","password":"xxx"}         连接（密码可省略）
+ * 
+ * 通知（JSON，按MTU分块，每块首字节为 序号(bit0~6) | 最后一块(bit7)，客户端按序拼接）：
+ * - {"scan":[{"ssid":"xxx","rssi":-50,"ch":6,"auth":3},...]}
+ * - {"state":"connecting","attempt":1}
+ * - {"state":"connected","ip":"192.168.1.10"}
+ * - {"state":"retrying","reason":201,"attempt":2}
+ * - {"state":"failed","reason":202,"attempt":5}     后台继续重试
+ * - {"error":"busy"} / {"error":"invalid"}
+ */
+
+#ifndef WIFI_PROV_H
+#define WIFI_PROV_H
+
+#include "esp_err.h"
+
+/* 配置参数 */
+#define WIFI_PROV_MSG_MAX       1536        // 单条通知消息最大长度（分块前）
+#define WIFI_PROV_CHUNK_LAST    0x80        // 分块头：最后一块标志
+
+/**
+ * @brief 初始化配网模块
+ * 
+ * 注册WiFi连接进度回调，需在 wifi_manager_init 之后调用
+ * 
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_NO_MEM: 内存不足
+ */
+esp_err_t wifi_prov_init(void);
+
+/**
+ * @brief 处理配网请求
+ * 
+ * 立即返回，扫描结果和连接进度异步通知
+ * 
+ * @param request_json 请求JSON字符串
+ */
+void wifi_prov_handle_request(const char *request_json);
+
+#endif // WIFI_PROV_H
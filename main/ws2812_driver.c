@@ -5,9 +5,17 @@
  */
 
 #include "ws2812_driver.h"
+#include "ws2812_frame.h"
+#include "metrics.h"
+#include "cycle_trace.h"
 #include "driver/rmt_tx.h"
 #include "esp_log.h"
 #include "esp_check.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "soc/soc_caps.h"
 #include <string.h>
 
 /* 日志标签 */
@@ -16,41 +24,145 @@ static const char* TAG = "WS2812";
 /* RMT配置 */
 #define RESOLUTION_HZ 10000000
 
+/* 帧符号数（每bit一个RMT符号，帧尾附加一个复位符号） */
+#define FRAME_SYMBOLS (WS2812_LED_COUNT * 24 + 1)
+
+/* RMT中断优先级（提高优先级以减少Wi-Fi/BLE共存时的补充延迟） */
+#define TX_INTR_PRIORITY 3
+
+#if WS2812_TX_USE_DMA && SOC_RMT_SUPPORT_DMA
+/*
+ * DMA模式：DMA缓冲容纳整帧符号，提交时一次编码完成，
+ * 发送期间不需要任何ISR补充，CPU开销与LED数量无关
+ */
+#define TX_WITH_DMA           1
+#define TX_MEM_BLOCK_SYMBOLS  FRAME_SYMBOLS
+#else
+/*
+ * 非DMA模式（ESP32-C3的RMT不支持DMA）：占用两个TX通道的全部RMT内存块，
+ * 由ISR按块补充符号，补充中断次数减半
+ */
+#define TX_WITH_DMA           0
+#define TX_MEM_BLOCK_SYMBOLS  (SOC_RMT_MEM_WORDS_PER_CHANNEL * 2)
+#endif
+
+/* WS2812位时序（完全照搬参考代码） */
+static const rmt_symbol_word_t ws2812_bit0 = {
+    .level0 = 1,
+    .duration0 = 0.3 * RESOLUTION_HZ / 1000000, // T0H=0.3us
+    .level1 = 0,
+    .duration1 = 0.9 * RESOLUTION_HZ / 1000000, // T0L=0.9us
+};
+
+static const rmt_symbol_word_t ws2812_bit1 = {
+    .level0 = 1,
+    .duration0 = 0.9 * RESOLUTION_HZ / 1000000, // T1H=0.9us
+    .level1 = 0,
+    .duration1 = 0.3 * RESOLUTION_HZ / 1000000, // T1L=0.3us
+};
+
+/* 完全照搬参考代码的Reset配置: 100us total reset time */
+#define RESET_TICKS   (RESOLUTION_HZ / 1000000 * 100 / 2)
+
+static const rmt_symbol_word_t ws2812_reset_code = {
+    .level0 = 0,
+    .duration0 = RESET_TICKS,
+    .level1 = 0,
+    .duration1 = RESET_TICKS,
+};
+
+/* 颜色调色板 (GRB格式: 0xGGRRBB) */
+static const uint32_t color_palette[] = {
+    0x000000, // 0: 灭
+    0x001000, // 1: 红 (G=0, R=16, B=0)
+    0x0A1000, // 2: 橙 (G=10, R=16, B=0)
+    0x101000, // 3: 黄 (G=16, R=16, B=0)
+    0x100000, // 4: 绿 (G=16, R=0, B=0)
+    0x100010, // 5: 青 (G=16, R=0, B=16)
+    0x000010, // 6: 蓝 (G=0, R=0, B=16)
+    0x000808, // 7: 紫 (G=0, R=8, B=8)
+};
+
+#define PALETTE_SIZE      (sizeof(color_palette) / sizeof(color_palette[0]))
+#define SYMBOLS_PER_LED   24
+
+/*
+ * 调色板波形表：每种颜色预先展开为24个RMT符号（GRB，高位先发），
+ * 初始化时生成一次，编码器直接按颜色索引拷贝。放在DRAM供IRAM安全的ISR读取。
+ */
+static DRAM_ATTR rmt_symbol_word_t s_palette_symbols[PALETTE_SIZE][SYMBOLS_PER_LED];
+
 /* 全局变量 */
 static rmt_channel_handle_t led_chan = NULL;
 static rmt_encoder_handle_t led_encoder = NULL;
 
+/*
+ * 帧缓冲环：s_frame_head指向下一个可填充的缓冲，s_frames_in_flight为已交给RMT
+ * 但尚未发送完成的帧数。RMT按提交顺序完成事务，因此完成回调只需计数减一。
+ * 提交路径由s_submit_mutex串行化，保证缓冲的占用顺序与rmt_transmit顺序一致。
+ */
+static uint8_t s_frame_buf[WS2812_FRAME_BUF_NUM][WS2812_LED_COUNT];   // 已校验的颜色索引
+static uint8_t s_frame_head = 0;
+static volatile uint8_t s_frames_in_flight = 0;
+static uint8_t s_pending_leds[WS2812_LED_COUNT];   // 缓冲全忙时暂存的最新帧
+static volatile bool s_pending = false;
+static int64_t s_slot_submit_us[WS2812_FRAME_BUF_NUM];  // 各帧缓冲的提交时间，发送完成时统计延迟
+static int64_t s_pending_submit_us = 0;
+
+/*
+ * 最近一次提交的帧（已发送或已暂存），用于去重和局部更新。
+ * s_work_frame为组帧暂存区，二者均由s_submit_mutex保护。
+ */
+static uint8_t s_last_frame[WS2812_LED_COUNT];
+static uint8_t s_work_frame[WS2812_LED_COUNT];
+static bool s_last_valid = false;     // 上电后首帧必须发送
+static uint8_t s_brightness = 255;    // 全局亮度，255为调色板原值
+static portMUX_TYPE s_frame_lock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t s_submit_mutex = NULL;
+static TaskHandle_t s_tx_task = NULL;
+
 /* 内部结构体定义 */
 typedef struct {
     rmt_encoder_t base;
-    rmt_encoder_t *bytes_encoder;
     rmt_encoder_t *copy_encoder;
     int state;
+    size_t led_idx;                 // 当前正在编码的LED
     rmt_symbol_word_t reset_code;
-} rmt_led_strip_encoder_t;
+} rmt_palette_encoder_t;
 
-/* 编码器实现 */
-static size_t rmt_encode_led_strip(rmt_encoder_t *encoder, rmt_channel_handle_t channel,
-                                    const void *primary_data, size_t data_size,
-                                    rmt_encode_state_t *ret_state)
+/*
+ * 调色板编码器实现（在RMT ISR中调用，需放在IRAM）
+ * 
+ * 输入数据为颜色索引数组（每LED一字节），逐LED拷贝波形表中对应的24个符号，
+ * 不再在发送时逐bit展开。RMT内存写满时记录LED位置，下次补充时继续。
+ */
+static IRAM_ATTR size_t rmt_encode_palette(rmt_encoder_t *encoder, rmt_channel_handle_t channel,
+                                           const void *primary_data, size_t data_size,
+                                           rmt_encode_state_t *ret_state)
 {
-    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    rmt_palette_encoder_t *led_encoder = __containerof(encoder, rmt_palette_encoder_t, base);
+    const uint8_t *color_idx = (const uint8_t *)primary_data;
     rmt_encode_state_t session_state = RMT_ENCODING_RESET;
     rmt_encode_state_t state = RMT_ENCODING_RESET;
     size_t encoded_symbols = 0;
-    rmt_encoder_handle_t bytes_encoder = led_encoder->bytes_encoder;
     rmt_encoder_handle_t copy_encoder = led_encoder->copy_encoder;
 
     switch (led_encoder->state) {
-    case 0: // send RGB data
-        encoded_symbols += bytes_encoder->encode(bytes_encoder, channel, primary_data, data_size, &session_state);
-        if (session_state & RMT_ENCODING_COMPLETE) {
-            led_encoder->state = 1; // switch to next state
-        }
-        if (session_state & RMT_ENCODING_MEM_FULL) {
-            state |= RMT_ENCODING_MEM_FULL;
-            goto out;
+    case 0: // send LED waveforms
+        while (led_encoder->led_idx < data_size) {
+            encoded_symbols += copy_encoder->encode(copy_encoder, channel,
+                                                    s_palette_symbols[color_idx[led_encoder->led_idx]],
+                                                    sizeof(s_palette_symbols[0]), &session_state);
+            if (session_state & RMT_ENCODING_COMPLETE) {
+                led_encoder->led_idx++;
+            }
+            if (session_state & RMT_ENCODING_MEM_FULL) {
+                state |= RMT_ENCODING_MEM_FULL;
+                goto out;
+            }
         }
+        led_encoder->led_idx = 0;
+        led_encoder->state = 1; // switch to next state
     // fall-through
     case 1: // send reset code
         encoded_symbols += copy_encoder->encode(copy_encoder, channel, &led_encoder->reset_code,
@@ -69,77 +181,62 @@ out:
     return encoded_symbols;
 }
 
-static esp_err_t rmt_del_led_strip_encoder(rmt_encoder_t *encoder)
+static esp_err_t rmt_del_palette_encoder(rmt_encoder_t *encoder)
 {
-    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
-    rmt_del_encoder(led_encoder->bytes_encoder);
+    rmt_palette_encoder_t *led_encoder = __containerof(encoder, rmt_palette_encoder_t, base);
     rmt_del_encoder(led_encoder->copy_encoder);
     free(led_encoder);
     return ESP_OK;
 }
 
-static esp_err_t rmt_led_strip_encoder_reset(rmt_encoder_t *encoder)
+static esp_err_t rmt_palette_encoder_reset(rmt_encoder_t *encoder)
 {
-    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
-    rmt_encoder_reset(led_encoder->bytes_encoder);
+    rmt_palette_encoder_t *led_encoder = __containerof(encoder, rmt_palette_encoder_t, base);
     rmt_encoder_reset(led_encoder->copy_encoder);
     led_encoder->state = RMT_ENCODING_RESET;
+    led_encoder->led_idx = 0;
     return ESP_OK;
 }
 
-static esp_err_t rmt_new_led_strip_encoder(rmt_encoder_handle_t *ret_encoder)
+/**
+ * @brief 生成调色板波形表
+ */
+static void build_palette_symbols(uint8_t brightness)
+{
+    for (int color_idx = 0; color_idx < PALETTE_SIZE; color_idx++) {
+        uint32_t color = ws2812_frame_scale_color(color_palette[color_idx], brightness);
+        
+        // GRB顺序，高位先发: G7...G0R7...R0B7...B0
+        for (int bit = 0; bit < SYMBOLS_PER_LED; bit++) {
+            bool one = color & (1UL << (SYMBOLS_PER_LED - 1 - bit));
+            s_palette_symbols[color_idx][bit] = one ? ws2812_bit1 : ws2812_bit0;
+        }
+    }
+}
+
+static esp_err_t rmt_new_palette_encoder(rmt_encoder_handle_t *ret_encoder)
 {
     esp_err_t ret = ESP_OK;
-    rmt_led_strip_encoder_t *led_encoder = NULL;
-    
-    led_encoder = calloc(1, sizeof(rmt_led_strip_encoder_t));
-    ESP_GOTO_ON_FALSE(led_encoder, ESP_ERR_NO_MEM, err, TAG, "no mem for led strip encoder");
-    
-    led_encoder->base.encode = rmt_encode_led_strip;
-    led_encoder->base.del = rmt_del_led_strip_encoder;
-    led_encoder->base.reset = rmt_led_strip_encoder_reset;
-    
-    // 完全照搬参考代码的时序配置
-    rmt_bytes_encoder_config_t bytes_encoder_config = {
-        .bit0 = {
-            .level0 = 1,
-            .duration0 = 0.3 * RESOLUTION_HZ / 1000000, // T0H=0.3us
-            .level1 = 0,
-            .duration1 = 0.9 * RESOLUTION_HZ / 1000000, // T0L=0.9us
-        },
-        .bit1 = {
-            .level0 = 1,
-            .duration0 = 0.9 * RESOLUTION_HZ / 1000000, // T1H=0.9us
-            .level1 = 0,
-            .duration1 = 0.3 * RESOLUTION_HZ / 1000000, // T1L=0.3us
-        },
-        .flags.msb_first = 1 // WS2812 transfer bit order: G7...G0R7...R0B7...B0
-    };
+    rmt_palette_encoder_t *led_encoder = NULL;
+    
+    led_encoder = calloc(1, sizeof(rmt_palette_encoder_t));
+    ESP_GOTO_ON_FALSE(led_encoder, ESP_ERR_NO_MEM, err, TAG, "no mem for palette encoder");
     
-    ESP_GOTO_ON_ERROR(rmt_new_bytes_encoder(&bytes_encoder_config, &led_encoder->bytes_encoder), err, TAG, "create bytes encoder failed");
+    led_encoder->base.encode = rmt_encode_palette;
+    led_encoder->base.del = rmt_del_palette_encoder;
+    led_encoder->base.reset = rmt_palette_encoder_reset;
     
     rmt_copy_encoder_config_t copy_encoder_config = {};
     ESP_GOTO_ON_ERROR(rmt_new_copy_encoder(&copy_encoder_config, &led_encoder->copy_encoder), err, TAG, "create copy encoder failed");
     
-    // 完全照搬参考代码的Reset配置
-    // 100us total reset time
-    uint32_t reset_ticks = RESOLUTION_HZ / 1000000 * 100 / 2; 
-    
-    led_encoder->reset_code = (rmt_symbol_word_t) {
-        .level0 = 0,
-        .duration0 = reset_ticks,
-        .level1 = 0,
-        .duration1 = reset_ticks,
-    };
+    led_encoder->reset_code = ws2812_reset_code;
+    build_palette_symbols(s_brightness);
     
     *ret_encoder = &led_encoder->base;
     return ESP_OK;
 
 err:
     if (led_encoder) {
-        if (led_encoder->bytes_encoder) {
-            rmt_del_encoder(led_encoder->bytes_encoder);
-        }
         if (led_encoder->copy_encoder) {
             rmt_del_encoder(led_encoder->copy_encoder);
         }
@@ -148,6 +245,141 @@ err:
     return ret;
 }
 
+/**
+ * @brief 将已校验的帧交给RMT发送（调用者需持有s_submit_mutex）
+ * 
+ * 申请空闲帧缓冲，全忙时暂存为待发送帧
+ * 
+ * @param frame 帧数据
+ * @param submit_us 提交时间，用于统计提交到发送完成的延迟
+ */
+static esp_err_t transmit_locked(const uint8_t *frame, int64_t submit_us)
+{
+    int slot = -1;
+    portENTER_CRITICAL(&s_frame_lock);
+    if (s_frames_in_flight < WS2812_FRAME_BUF_NUM) {
+        slot = s_frame_head;
+        s_frame_head = (s_frame_head + 1) % WS2812_FRAME_BUF_NUM;
+        s_frames_in_flight++;
+        s_slot_submit_us[slot] = submit_us;
+        s_pending = false;   // 新帧覆盖尚未补发的旧帧
+    } else {
+        memcpy(s_pending_leds, frame, WS2812_LED_COUNT);
+        s_pending_submit_us = submit_us;
+        s_pending = true;
+    }
+    portEXIT_CRITICAL(&s_frame_lock);
+    
+    if (slot < 0) {
+        return ESP_OK;
+    }
+    
+    memcpy(s_frame_buf[slot], frame, WS2812_LED_COUNT);
+    
+    // 配置传输
+    rmt_transmit_config_t tx_config = {
+        .loop_count = 0,
+    };
+    
+    // 发送数据（不等待完成，缓冲在发送完成回调中释放）
+    esp_err_t ret = rmt_transmit(led_chan, led_encoder, s_frame_buf[slot], sizeof(s_frame_buf[slot]), &tx_config);
+    if (ret != ESP_OK) {
+        portENTER_CRITICAL(&s_frame_lock);
+        s_frame_head = slot;
+        s_frames_in_flight--;
+        portEXIT_CRITICAL(&s_frame_lock);
+        ESP_LOGE(TAG, "rmt transmit failed: %s", esp_err_to_name(ret));
+    } else {
+        ESP_LOGD(TAG, "LED frame submitted (slot %d)", slot);
+    }
+    return ret;
+}
+
+/**
+ * @brief 提交s_work_frame中组好的帧（调用者需持有s_submit_mutex）
+ * 
+ * 与上一次提交的帧相同则直接跳过，不占用RMT
+ */
+static esp_err_t commit_work_frame_locked(void)
+{
+    if (s_last_valid && memcmp(s_work_frame, s_last_frame, WS2812_LED_COUNT) == 0) {
+        ESP_LOGV(TAG, "LED frame unchanged, skipped");
+        return ESP_OK;
+    }
+    
+    memcpy(s_last_frame, s_work_frame, WS2812_LED_COUNT);
+    s_last_valid = true;
+    
+    esp_err_t ret = transmit_locked(s_work_frame, esp_timer_get_time());
+    if (ret != ESP_OK) {
+        s_last_valid = false;   // 发送失败，下次相同的帧不能被去重
+    }
+    return ret;
+}
+
+/**
+ * @brief RMT发送完成回调（ISR上下文）
+ * 
+ * 释放最早提交的帧缓冲并记录延迟，若有待发送帧则唤醒补发任务
+ */
+static IRAM_ATTR bool ws2812_on_trans_done(rmt_channel_handle_t channel, const rmt_tx_done_event_data_t *edata,
+                                 void *user_ctx)
+{
+    BaseType_t task_woken = pdFALSE;
+    bool pending;
+    int64_t submit_us = -1;
+    
+    portENTER_CRITICAL_ISR(&s_frame_lock);
+    if (s_frames_in_flight > 0) {
+        // 最早提交的缓冲位于环头之前 s_frames_in_flight 个位置
+        int slot = (s_frame_head + WS2812_FRAME_BUF_NUM - s_frames_in_flight) % WS2812_FRAME_BUF_NUM;
+        submit_us = s_slot_submit_us[slot];
+        s_frames_in_flight--;
+    }
+    pending = s_pending;
+    portEXIT_CRITICAL_ISR(&s_frame_lock);
+    
+    if (submit_us >= 0) {
+        metrics_record_since(METRICS_LATENCY_LED_FRAME, submit_us);
+    }
+    if (pending && s_tx_task) {
+        vTaskNotifyGiveFromISR(s_tx_task, &task_woken);
+    }
+    return task_woken == pdTRUE;
+}
+
+/**
+ * @brief 待发送帧补发任务
+ * 
+ * 仅在帧缓冲全忙期间有新帧提交时才会被唤醒
+ */
+static void ws2812_tx_task(void *arg)
+{
+    uint8_t frame[WS2812_LED_COUNT];
+    int64_t submit_us = 0;
+    
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        
+        bool pending;
+        portENTER_CRITICAL(&s_frame_lock);
+        pending = s_pending;
+        if (pending) {
+            memcpy(frame, s_pending_leds, sizeof(frame));
+            submit_us = s_pending_submit_us;
+            s_pending = false;
+        }
+        portEXIT_CRITICAL(&s_frame_lock);
+        
+        if (pending) {
+            // 该帧提交时已经过去重，这里直接发送；延迟从最初提交时算起
+            xSemaphoreTake(s_submit_mutex, portMAX_DELAY);
+            transmit_locked(frame, submit_us);
+            xSemaphoreGive(s_submit_mutex);
+        }
+    }
+}
+
 /**
  * @brief 初始化WS2812驱动
  */
@@ -161,93 +393,168 @@ esp_err_t ws2812_init(void)
     rmt_tx_channel_config_t tx_chan_config = {
         .clk_src = RMT_CLK_SRC_DEFAULT,
         .gpio_num = WS2812_GPIO_PIN,
-        .mem_block_symbols = 64,
+        .mem_block_symbols = TX_MEM_BLOCK_SYMBOLS,
         .resolution_hz = RESOLUTION_HZ,
-        .trans_queue_depth = 4,
+        .trans_queue_depth = WS2812_FRAME_BUF_NUM,
+        .intr_priority = TX_INTR_PRIORITY,
         .flags.invert_out = false,
-        .flags.with_dma = false,
+        .flags.with_dma = TX_WITH_DMA,
     };
     
     ESP_GOTO_ON_ERROR(rmt_new_tx_channel(&tx_chan_config, &led_chan), err, TAG, "create tx channel failed");
     
-    // 创建LED编码器
-    ESP_GOTO_ON_ERROR(rmt_new_led_strip_encoder(&led_encoder), err, TAG, "create encoder failed");
+    // 创建调色板编码器
+    ESP_GOTO_ON_ERROR(rmt_new_palette_encoder(&led_encoder), err, TAG, "create encoder failed");
+    
+    // 创建提交锁和补发任务
+    s_submit_mutex = xSemaphoreCreateMutex();
+    ESP_GOTO_ON_FALSE(s_submit_mutex, ESP_ERR_NO_MEM, err, TAG, "create submit mutex failed");
+    ESP_GOTO_ON_FALSE(xTaskCreate(ws2812_tx_task, "ws2812_tx", 2048, NULL, 6, &s_tx_task) == pdPASS,
+                      ESP_ERR_NO_MEM, err, TAG, "create tx task failed");
+    
+    // 注册发送完成回调（必须在使能通道之前）
+    rmt_tx_event_callbacks_t cbs = {
+        .on_trans_done = ws2812_on_trans_done,
+    };
+    ESP_GOTO_ON_ERROR(rmt_tx_register_event_callbacks(led_chan, &cbs, NULL), err, TAG, "register tx callback failed");
     
     // 使能RMT通道
     ESP_GOTO_ON_ERROR(rmt_enable(led_chan), err, TAG, "enable rmt failed");
     
-    ESP_LOGI(TAG, "WS2812 initialized on GPIO%d", WS2812_GPIO_PIN);
+    ESP_LOGI(TAG, "WS2812 initialized on GPIO%d (%d LEDs, %s, %d symbols)", WS2812_GPIO_PIN,
+             WS2812_LED_COUNT, TX_WITH_DMA ? "DMA" : "RMT mem", TX_MEM_BLOCK_SYMBOLS);
     
     // 初始化后清除所有LED
     ws2812_clear_all();
     return ESP_OK;
 
 err:
+    if (s_tx_task) {
+        vTaskDelete(s_tx_task);
+        s_tx_task = NULL;
+    }
+    if (s_submit_mutex) {
+        vSemaphoreDelete(s_submit_mutex);
+        s_submit_mutex = NULL;
+    }
     if (led_chan) {
         rmt_del_channel(led_chan);
+        led_chan = NULL;
     }
     if (led_encoder) {
         rmt_del_encoder(led_encoder);
+        led_encoder = NULL;
     }
     return ret;
 }
 
 /**
- * @brief 更新LED状态
+ * @brief 提交一帧LED数据（异步）
  */
-esp_err_t ws2812_update_leds(uint8_t *led_data_in)
+esp_err_t ws2812_submit_frame(const uint8_t *led_data)
 {
-    // 颜色调色板 (GRB格式: 0xGGRRBB)
-    static const uint32_t color_palette[] = {
-        0x000000, // 0: 灭
-        0x001000, // 1: 红 (G=0, R=16, B=0)
-        0x0A1000, // 2: 橙 (G=10, R=16, B=0)
-        0x101000, // 3: 黄 (G=16, R=16, B=0)
-        0x100000, // 4: 绿 (G=16, R=0, B=0)
-        0x100010, // 5: 青 (G=16, R=0, B=16)
-        0x000010, // 6: 蓝 (G=0, R=0, B=16)
-        0x000808, // 7: 紫 (G=0, R=8, B=8)
-    };
+    CYCLE_TRACE_SCOPE(CYCLE_TRACE_LED_SUBMIT);
+    ESP_RETURN_ON_FALSE(led_data, ESP_ERR_INVALID_ARG, TAG, "led data is NULL");
+    ESP_RETURN_ON_FALSE(led_chan && s_submit_mutex, ESP_ERR_INVALID_STATE, TAG, "driver not initialized");
+    
+    xSemaphoreTake(s_submit_mutex, portMAX_DELAY);
+    ws2812_frame_sanitize(led_data, s_work_frame, WS2812_LED_COUNT, PALETTE_SIZE);
+    esp_err_t ret = commit_work_frame_locked();
+    xSemaphoreGive(s_submit_mutex);
+    
+    return ret;
+}
 
-    // 准备LED数据（GRB格式，每个LED 3字节）
-    uint8_t led_data_out[WS2812_LED_COUNT * 3];
-    int data_idx = 0;
+/**
+ * @brief 局部更新连续若干个LED（异步）
+ */
+esp_err_t ws2812_update_range(uint16_t start, uint16_t count, const uint8_t *led_data)
+{
+    CYCLE_TRACE_SCOPE(CYCLE_TRACE_LED_SUBMIT);
+    ESP_RETURN_ON_FALSE(led_data, ESP_ERR_INVALID_ARG, TAG, "led data is NULL");
+    ESP_RETURN_ON_FALSE(count > 0 && start < WS2812_LED_COUNT && count <= WS2812_LED_COUNT - start,
+                        ESP_ERR_INVALID_ARG, TAG, "range %u+%u out of bounds", start, count);
+    ESP_RETURN_ON_FALSE(led_chan && s_submit_mutex, ESP_ERR_INVALID_STATE, TAG, "driver not initialized");
     
-    // 遍历32个LED
-    for (int led = 0; led < WS2812_LED_COUNT; led++) {
-        uint8_t color_idx = led_data_in[led];
-        uint32_t color;
-        
-        if (color_idx < sizeof(color_palette)/sizeof(color_palette[0])) {
-            color = color_palette[color_idx];
-        } else {
-            color = color_palette[1]; // 默认红色
-        }
-        
-        // GRB顺序 (与参考代码一致: g, r, b)
-        led_data_out[data_idx++] = (color >> 16) & 0xFF;  // Green
-        led_data_out[data_idx++] = (color >> 8) & 0xFF;   // Red
-        led_data_out[data_idx++] = color & 0xFF;          // Blue
-    }
+    xSemaphoreTake(s_submit_mutex, portMAX_DELAY);
     
-    // 配置传输
-    rmt_transmit_config_t tx_config = {
-        .loop_count = 0,
-    };
+    // 以上一次提交的帧为底，只替换指定区间
+    memcpy(s_work_frame, s_last_frame, WS2812_LED_COUNT);
+    ws2812_frame_sanitize(led_data, &s_work_frame[start], count, PALETTE_SIZE);
+    esp_err_t ret = commit_work_frame_locked();
     
-    // 发送数据
-    ESP_ERROR_CHECK(rmt_transmit(led_chan, led_encoder, led_data_out, sizeof(led_data_out), &tx_config));
-    ESP_ERROR_CHECK(rmt_tx_wait_all_done(led_chan, 100));
+    xSemaphoreGive(s_submit_mutex);
+    return ret;
+}
+
+/**
+ * @brief 设置单个LED颜色（异步）
+ */
+esp_err_t ws2812_set_pixel(uint16_t index, uint8_t color_idx)
+{
+    return ws2812_update_range(index, 1, &color_idx);
+}
+
+/**
+ * @brief 设置全局亮度
+ */
+esp_err_t ws2812_set_brightness(uint8_t brightness)
+{
+    ESP_RETURN_ON_FALSE(led_chan && s_submit_mutex, ESP_ERR_INVALID_STATE, TAG, "driver not initialized");
     
-    ESP_LOGI(TAG, "LED updated success");
+    xSemaphoreTake(s_submit_mutex, portMAX_DELAY);
+    if (brightness != s_brightness) {
+        // 正在发送的帧可能混用新旧波形，只影响一帧，下一帧即恢复一致
+        s_brightness = brightness;
+        build_palette_symbols(brightness);
+        s_last_valid = false;   // 颜色索引不变也必须重新发送
+    }
+    xSemaphoreGive(s_submit_mutex);
     return ESP_OK;
 }
 
+/**
+ * @brief 获取最近一次提交的帧
+ */
+void ws2812_get_frame(uint8_t *led_data)
+{
+    if (!led_data) {
+        return;
+    }
+    if (s_submit_mutex) {
+        xSemaphoreTake(s_submit_mutex, portMAX_DELAY);
+    }
+    memcpy(led_data, s_last_frame, WS2812_LED_COUNT);
+    if (s_submit_mutex) {
+        xSemaphoreGive(s_submit_mutex);
+    }
+}
+
+/**
+ * @brief 等待所有已提交的帧发送完成
+ */
+esp_err_t ws2812_wait_all_done(int timeout_ms)
+{
+    ESP_RETURN_ON_FALSE(led_chan, ESP_ERR_INVALID_STATE, TAG, "driver not initialized");
+    return rmt_tx_wait_all_done(led_chan, timeout_ms);
+}
+
+/**
+ * @brief 更新LED状态（同步）
+ */
+esp_err_t ws2812_update_leds(uint8_t *led_data_in)
+{
+    // 先等待在途帧完成，确保本帧能直接占用帧缓冲而不是被暂存
+    ESP_RETURN_ON_ERROR(ws2812_wait_all_done(100), TAG, "wait previous frame failed");
+    ESP_RETURN_ON_ERROR(ws2812_submit_frame(led_data_in), TAG, "submit frame failed");
+    return ws2812_wait_all_done(100);
+}
+
 /**
  * @brief 清除所有LED
  */
 esp_err_t ws2812_clear_all(void)
 {
-    uint8_t all_off[WS2812_LED_COUNT] = {0};
-    return ws2812_update_leds(all_off);
+    static const uint8_t all_off[WS2812_LED_COUNT] = {0};
+    return ws2812_submit_frame(all_off);
 }
@@ -15,6 +15,8 @@
 /* 配置参数 */
 #define WS2812_LED_COUNT    60          // LED数量
 #define WS2812_GPIO_PIN     GPIO_NUM_1  // GPIO引脚
+#define WS2812_FRAME_BUF_NUM 2          // 静态帧缓冲数量（双缓冲）
+#define WS2812_TX_USE_DMA   1           // 芯片支持时使用RMT DMA发送（ESP32-C3不支持，自动退化为RMT内存模式）
 
 /* RGB颜色定义 (GRB格式) */
 #define WS2812_COLOR_OFF    0x000000
@@ -30,11 +32,83 @@
 esp_err_t ws2812_init(void);
 
 /**
- * @brief 更新LED状态
+ * @brief 提交一帧LED数据（异步，立即返回）
+ * 
+ * 将颜色索引拷贝到空闲的静态帧缓冲并启动RMT发送，不等待发送完成。
+ * 发送时由调色板编码器按索引直接拷贝预生成的RMT波形。
+ * 若所有帧缓冲都在发送中，则暂存为待发送帧，前一帧发送完成后自动补发，
+ * 连续提交时只保留最新一帧。可在BLE/MQTT回调中直接调用。
+ * 与上一次提交的帧完全相同时直接跳过，不占用RMT。
+ * 
+ * @param led_data 60字节LED颜色索引数组 (0~7)
+ * @return 
+ *     - ESP_OK: 已提交或已暂存
+ *     - ESP_ERR_INVALID_ARG: 参数为空
+ *     - ESP_ERR_INVALID_STATE: 驱动未初始化
+ */
+esp_err_t ws2812_submit_frame(const uint8_t *led_data);
+
+/**
+ * @brief 局部更新连续若干个LED（异步）
+ * 
+ * 以最近一次提交的帧为底，只替换 [start, start+count) 区间，结果帧未变化时不发送
+ * 
+ * @param start 起始LED索引
+ * @param count LED个数
+ * @param led_data count字节颜色索引数组 (0~7)
+ * @return 
+ *     - ESP_OK: 已提交或无变化
+ *     - ESP_ERR_INVALID_ARG: 区间越界或参数为空
+ *     - ESP_ERR_INVALID_STATE: 驱动未初始化
+ */
+esp_err_t ws2812_update_range(uint16_t start, uint16_t count, const uint8_t *led_data);
+
+/**
+ * @brief 设置单个LED颜色（异步）
+ * 
+ * @param index LED索引
+ * @param color_idx 颜色索引 (0~7)
+ * @return 同 ws2812_update_range()
+ */
+esp_err_t ws2812_set_pixel(uint16_t index, uint8_t color_idx);
+
+/**
+ * @brief 设置全局亮度
+ * 
+ * 按比例缩放调色板并重建波形表，在下一次提交的帧生效
+ * 
+ * @param brightness 亮度 (0~255)，255为调色板原始亮度
+ * @return 
+ *     - ESP_OK: 成功
+ *     - ESP_ERR_INVALID_STATE: 驱动未初始化
+ */
+esp_err_t ws2812_set_brightness(uint8_t brightness);
+
+/**
+ * @brief 获取最近一次提交的帧
+ * 
+ * @param led_data 输出缓冲区，至少60字节
+ */
+void ws2812_get_frame(uint8_t *led_data);
+
+/**
+ * @brief 等待所有已提交的帧发送完成
+ * 
+ * @param timeout_ms 超时时间(ms)，-1表示一直等待
+ * @return 
+ *     - ESP_OK: 发送完成
+ *     - ESP_ERR_TIMEOUT: 超时
+ */
+esp_err_t ws2812_wait_all_done(int timeout_ms);
+
+/**
+ * @brief 更新LED状态（同步）
  * 
  * 根据60字节数据更新LED状态，每字节对应一个LED
  * 0:灭, 1:红, 2:橙, 3:黄, 4:绿, 5:青, 6:蓝, 7:紫
  * 
+ * 等价于 ws2812_submit_frame() 后等待发送完成，适用于需要确认帧已输出的场合。
+ * 
  * @param led_data 60字节LED颜色索引数组
  * @return 
  *     - ESP_OK: 成功
@@ -0,0 +1,27 @@
+/*
+ * WS2812 帧准备 - 实现文件
+ */
+
+#include "ws2812_frame.h"
+
+/**
+ * @brief 按亮度缩放GRB颜色值
+ */
+uint32_t ws2812_frame_scale_color(uint32_t grb, uint8_t brightness)
+{
+    uint32_t g = ((grb >> 16) & 0xFF) * brightness / 255;
+    uint32_t r = ((grb >> 8) & 0xFF) * brightness / 255;
+    uint32_t b = (grb & 0xFF) * brightness / 255;
+    return (g << 16) | (r << 8) | b;
+}
+
+/**
+ * @brief 拷贝颜色索引，越界索引替换为红色
+ */
+void ws2812_frame_sanitize(const uint8_t *in, uint8_t *out, size_t count, uint8_t palette_size)
+{
+    for (size_t led = 0; led < count; led++) {
+        uint8_t color_idx = in[led];
+        out[led] = (color_idx < palette_size) ? color_idx : WS2812_FRAME_INVALID_COLOR;
+    }
+}
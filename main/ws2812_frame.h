@@ -0,0 +1,36 @@
+/*
+ * WS2812 帧准备 - 头文件
+ * 
+ * 功能：颜色索引帧的校验和亮度缩放，与ESP-IDF无关
+ * （ws2812_driver 使用，也可在主机上编译）
+ */
+
+#ifndef WS2812_FRAME_H
+#define WS2812_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* 越界颜色索引的替换值（红色） */
+#define WS2812_FRAME_INVALID_COLOR  1
+
+/**
+ * @brief 按亮度缩放GRB颜色值
+ * 
+ * @param grb 颜色 (0xGGRRBB)
+ * @param brightness 亮度 0~255
+ * @return 缩放后的颜色
+ */
+uint32_t ws2812_frame_scale_color(uint32_t grb, uint8_t brightness);
+
+/**
+ * @brief 拷贝颜色索引，越界索引替换为 WS2812_FRAME_INVALID_COLOR
+ * 
+ * @param in 输入颜色索引
+ * @param out 输出缓冲区（可与 in 相同）
+ * @param count LED个数
+ * @param palette_size 调色板颜色数
+ */
+void ws2812_frame_sanitize(const uint8_t *in, uint8_t *out, size_t count, uint8_t palette_size);
+
+#endif // WS2812_FRAME_H
@@ -0,0 +1,171 @@
+/*
+ * 主机端基准
+ * 
+ * 功能：帧扫描、负载编码、LED帧准备的耗时（ns/帧），用于在烧录前发现性能回退
+ * 只报告耗时不判定阈值（主机与ESP32-C3的绝对值不可比，关注相对变化）
+ * 
+ * 用法：host_bench [--quick]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sensor_frame.h"
+#include "m701_codec.h"
+#include "ws2812_frame.h"
+#include "ble_protocol.h"
+#include "host_frames.h"
+
+#define STREAM_SIZE     (256 * 1024)
+#define UART_CHUNK      64              // 模拟每次UART读取的字节数
+#define WINDOW_SIZE     (256 + 64)      // 与 sensor_hub 的接收窗口一致
+#define LED_MAX         1000
+
+/* 颜色调色板（与 ws2812_driver 相同，GRB格式） */
+static const uint32_t s_palette[] = {
+    0x000000, 0x001000, 0x0A1000, 0x101000, 0x100000, 0x100010, 0x000010, 0x000808,
+};
+#define PALETTE_SIZE    (sizeof(s_palette) / sizeof(s_palette[0]))
+
+static int s_scale = 1;                 // --quick 时缩减迭代次数
+static volatile uint32_t s_sink;        // 防止结果被优化掉
+static int s_errors = 0;                // 扫描结果与生成的帧数不符
+
+/**
+ * @brief 单调时钟(ns)
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void report(const char *name, uint64_t elapsed_ns, uint64_t units, const char *unit)
+{
+    printf("%-36s %10.1f ns/%s\n", name, (double)elapsed_ns / units, unit);
+}
+
+static void count_frame(void *ctx, uint8_t index, const uint8_t *frame)
+{
+    (void)index;
+    (*(size_t *)ctx)++;
+    s_sink += frame[2];
+}
+
+/**
+ * @brief 帧扫描：按 UART_CHUNK 分片送入接收窗口，与 sensor_hub 的读取循环相同
+ */
+static void bench_frame_scan(const char *name, uint32_t noise_max)
+{
+    static uint8_t stream[STREAM_SIZE];
+    static const sensor_frame_format_t format = M701_FRAME_FORMAT();
+    static const sensor_frame_format_t *const formats[] = { &format };
+    uint32_t rng = 0xC0FFEE;
+    size_t frames = 0;
+    size_t len = host_build_noisy_stream(&rng, stream, sizeof(stream), &frames, noise_max, NULL);
+    int rounds = 40 / s_scale + 1;
+    
+    size_t found = 0;
+    uint64_t start = now_ns();
+    for (int round = 0; round < rounds; round++) {
+        uint8_t window[WINDOW_SIZE];
+        size_t window_len = 0;
+        for (size_t pos = 0; pos < len; pos += UART_CHUNK) {
+            size_t chunk = (len - pos < UART_CHUNK) ? len - pos : UART_CHUNK;
+            memcpy(window + window_len, stream + pos, chunk);
+            window_len = sensor_frame_scan(formats, 1, window, window_len + chunk, count_frame, &found, NULL);
+        }
+    }
+    uint64_t elapsed = now_ns() - start;
+    
+    if (found != frames * rounds) {
+        printf("%s: found %zu frames, expected %zu\n", name, found, frames * rounds);
+        s_errors++;
+    }
+    report(name, elapsed, (uint64_t)frames * rounds, "frame");
+}
+
+/**
+ * @brief 负载编码（解析帧 + 编码）
+ */
+static void bench_encode(const char *name, m701_payload_format_t format)
+{
+    enum { SAMPLES = 256 };
+    uint8_t frames[SAMPLES][M701_FRAME_SIZE];
+    uint32_t rng = 0x1234;
+    for (int i = 0; i < SAMPLES; i++) {
+        m701_sensor_data_t sample;
+        host_random_sample(&rng, &sample);
+        host_build_m701_frame(&sample, frames[i]);
+    }
+    int iterations = 400000 / s_scale;
+    
+    uint8_t buf[128];
+    uint64_t start = now_ns();
+    for (int i = 0; i < iterations; i++) {
+        m701_sensor_data_t data;
+        m701_codec_parse_frame(frames[i % SAMPLES], &data);
+        s_sink += m701_codec_encode(&data, format, buf, sizeof(buf));
+    }
+    report(name, now_ns() - start, iterations, "sample");
+}
+
+/**
+ * @brief LED帧准备：BLE写入解析 -> 索引校验 -> 按亮度展开为GRB字节（驱动端调色板展开的等价工作）
+ */
+static void bench_led_prep(uint16_t led_count, bool binary)
+{
+    static uint8_t ascii[LED_MAX];
+    static uint8_t packet[BLE_LED_BIN_HEADER_LEN + BLE_LED_BIN_PAYLOAD_LEN(LED_MAX)];
+    static uint8_t leds[LED_MAX];
+    static uint8_t grb[LED_MAX * 3];
+    uint32_t rng = 0xBEEF;
+    for (uint16_t i = 0; i < led_count; i++) {
+        leds[i] = host_rand(&rng) % PALETTE_SIZE;
+        ascii[i] = '0' + leds[i];
+    }
+    uint16_t packet_len = ble_protocol_pack_led_binary(leds, 0, led_count, packet);
+    int iterations = (int)(20000000 / led_count) / s_scale + 1;
+    
+    uint64_t start = now_ns();
+    for (int n = 0; n < iterations; n++) {
+        bool ok = binary ? ble_protocol_parse_led_binary(packet, packet_len, leds, led_count)
+                         : ble_protocol_parse_led_string(ascii, led_count, leds, led_count);
+        ws2812_frame_sanitize(leds, leds, led_count, PALETTE_SIZE);
+        uint8_t brightness = 64 + (n & 0x7F);
+        for (uint16_t i = 0; i < led_count; i++) {
+            uint32_t color = ws2812_frame_scale_color(s_palette[leds[i]], brightness);
+            grb[i * 3] = color >> 16;
+            grb[i * 3 + 1] = color >> 8;
+            grb[i * 3 + 2] = color;
+        }
+        s_sink += ok + grb[(n % led_count) * 3];
+    }
+    uint64_t elapsed = now_ns() - start;
+    
+    char name[48];
+    snprintf(name, sizeof(name), "led prep %s %u LEDs", binary ? "binary" : "string", led_count);
+    report(name, elapsed, iterations, "frame");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "--quick") == 0) {
+        s_scale = 100;
+    }
+    
+    bench_frame_scan("m701 scan (clean stream)", 0);
+    bench_frame_scan("m701 scan (noisy, <=24B/frame)", 24);
+    bench_frame_scan("m701 scan (noisy, <=96B/frame)", 96);
+    bench_encode("m701 parse + encode json", M701_PAYLOAD_JSON);
+    bench_encode("m701 parse + encode binary", M701_PAYLOAD_BINARY);
+    
+    static const uint16_t led_counts[] = { 60, 300, 1000 };
+    for (size_t i = 0; i < sizeof(led_counts) / sizeof(led_counts[0]); i++) {
+        bench_led_prep(led_counts[i], false);
+        bench_led_prep(led_counts[i], true);
+    }
+    return s_errors ? 1 : 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * 主机测试 - 测试数据生成
+ * 
+ * 功能：构造M701数据帧、带伪帧头的噪声流，供 host_tests 和 host_bench 共用
+ */
+
+#ifndef HOST_FRAMES_H
+#define HOST_FRAMES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "m701_codec.h"
+
+/**
+ * @brief 伪随机数（xorshift32，固定种子保证每次运行数据相同）
+ */
+static inline uint32_t host_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/**
+ * @brief 计算并写入帧末尾的sum8校验
+ */
+static inline void host_frame_seal(uint8_t *frame, size_t len)
+{
+    uint8_t sum = 0;
+    for (size_t i = 0; i < len - 1; i++) {
+        sum += frame[i];
+    }
+    frame[len - 1] = sum;
+}
+
+/**
+ * @brief 按传感器读数构造M701数据帧
+ * 
+ * @param data 读数（温湿度取两位小数）
+ * @param frame 输出帧（M701_FRAME_SIZE 字节）
+ */
+static inline void host_build_m701_frame(const m701_sensor_data_t *data, uint8_t *frame)
+{
+    float temp = data->temperature < 0 ? -data->temperature : data->temperature;
+    int32_t temp_centi = M701_TO_CENTI(temp);
+    int32_t humi_centi = M701_TO_CENTI(data->humidity);
+    
+    frame[0] = M701_FRAME_HEADER;
+    frame[1] = 0x02;
+    frame[2] = data->co2 >> 8;
+    frame[3] = data->co2 & 0xFF;
+    frame[4] = data->hcho >> 8;
+    frame[5] = data->hcho & 0xFF;
+    frame[6] = data->tvoc >> 8;
+    frame[7] = data->tvoc & 0xFF;
+    frame[8] = data->pm25 >> 8;
+    frame[9] = data->pm25 & 0xFF;
+    frame[10] = data->pm10 >> 8;
+    frame[11] = data->pm10 & 0xFF;
+    frame[12] = (uint8_t)(temp_centi / 100) | (data->temperature < 0 ? 0x80 : 0);
+    frame[13] = temp_centi % 100;
+    frame[14] = humi_centi / 100;
+    frame[15] = humi_centi % 100;
+    host_frame_seal(frame, M701_FRAME_SIZE);
+}
+
+/**
+ * @brief 生成随机读数
+ */
+static inline void host_random_sample(uint32_t *rng, m701_sensor_data_t *data)
+{
+    data->co2 = 400 + host_rand(rng) % 4600;
+    data->hcho = host_rand(rng) % 1000;
+    data->tvoc = host_rand(rng) % 2000;
+    data->pm25 = host_rand(rng) % 500;
+    data->pm10 = host_rand(rng) % 600;
+    data->temperature = (int32_t)(host_rand(rng) % 8000 - 2000) / 100.0f;  // -20.00 ~ 59.99
+    data->humidity = (host_rand(rng) % 10000) / 100.0f;
+    data->valid = true;
+}
+
+/**
+ * @brief 生成带噪声的M701字节流
+ * 
+ * 每个真帧前插入 0~noise_max 个噪声字节，噪声中约1/4为伪帧头 0x3C 0x02
+ * （伪帧可能与后面的真帧重叠；偶然通过校验的伪帧头会被破坏，保证流中只有真帧能匹配）
+ * 
+ * @param rng 随机数状态
+ * @param out 输出缓冲区
+ * @param out_size 缓冲区大小
+ * @param frames 输出：写入的真帧个数
+ * @param noise_max 每帧前最多噪声字节数
+ * @param samples 输出：按顺序记录真帧读数（至少 out_size / M701_FRAME_SIZE 个），可为NULL
+ * @return 写入的字节数
+ */
+static inline size_t host_build_noisy_stream(uint32_t *rng, uint8_t *out, size_t out_size,
+                                             size_t *frames, uint32_t noise_max,
+                                             m701_sensor_data_t *samples)
+{
+    size_t len = 0;
+    *frames = 0;
+    
+    while (true) {
+        uint32_t noise = noise_max ? host_rand(rng) % (noise_max + 1) : 0;
+        if (len + noise + M701_FRAME_SIZE > out_size) {
+            break;
+        }
+        size_t noise_start = len;
+        for (uint32_t i = 0; i < noise; i++) {
+            uint8_t b = host_rand(rng) & 0xFF;
+            if (i + 1 < noise && (host_rand(rng) & 3) == 0) {
+                out[len++] = M701_FRAME_HEADER;
+                b = 0x02;
+                i++;
+            }
+            out[len++] = b;
+        }
+        
+        m701_sensor_data_t sample;
+        host_random_sample(rng, &sample);
+        host_build_m701_frame(&sample, out + len);
+        for (size_t pos = len; pos-- > noise_start; ) {     // 从后往前，避免破坏后影响前面已检查的窗口
+            if (out[pos] == M701_FRAME_HEADER && out[pos + 1] == 0x02) {
+                uint8_t sum = 0;
+                for (size_t i = 0; i < M701_FRAME_SIZE - 1; i++) {
+                    sum += out[pos + i];
+                }
+                if (sum == out[pos + M701_FRAME_SIZE - 1]) {
+                    out[pos] ^= 0x01;
+                }
+            }
+        }
+        if (samples) {
+            samples[*frames] = sample;
+        }
+        len += M701_FRAME_SIZE;
+        (*frames)++;
+    }
+    return len;
+}
+
+#endif // HOST_FRAMES_H
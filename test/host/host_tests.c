@@ -0,0 +1,297 @@
+/*
+ * 主机端回归测试
+ * 
+ * 功能：帧扫描、M701编解码、LED帧解析与准备的正确性检查，任一检查失败返回非0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sensor_frame.h"
+#include "m701_codec.h"
+#include "ws2812_frame.h"
+#include "ble_protocol.h"
+#include "host_frames.h"
+
+#define STREAM_SIZE     (64 * 1024)
+#define WINDOW_SIZE     (256 + 64)      // 与 sensor_hub 的接收窗口一致
+
+static int s_failures = 0;
+
+#define CHECK(cond) do {                                                    \
+    if (!(cond)) {                                                          \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);              \
+        s_failures++;                                                       \
+    }                                                                       \
+} while (0)
+
+/* 扫描回调收集的结果 */
+typedef struct {
+    m701_sensor_data_t *samples;
+    size_t count;
+    size_t max;
+} collect_ctx_t;
+
+static void collect_frame(void *ctx, uint8_t index, const uint8_t *frame)
+{
+    collect_ctx_t *collect = ctx;
+    (void)index;
+    if (collect->count < collect->max) {
+        m701_codec_parse_frame(frame, &collect->samples[collect->count]);
+    }
+    collect->count++;
+}
+
+static const sensor_frame_format_t s_m701_format = M701_FRAME_FORMAT();
+static const sensor_frame_format_t *const s_formats[] = { &s_m701_format };
+
+/**
+ * @brief 读数是否一致（温湿度按0.01比较）
+ */
+static bool sample_equal(const m701_sensor_data_t *a, const m701_sensor_data_t *b)
+{
+    return a->co2 == b->co2 && a->hcho == b->hcho && a->tvoc == b->tvoc &&
+           a->pm25 == b->pm25 && a->pm10 == b->pm10 &&
+           M701_TO_CENTI(a->temperature) == M701_TO_CENTI(b->temperature) &&
+           M701_TO_CENTI(a->humidity) == M701_TO_CENTI(b->humidity);
+}
+
+/**
+ * @brief 一次性扫描一段数据
+ */
+static size_t scan_once(const uint8_t *data, size_t len, collect_ctx_t *collect, sensor_frame_stats_t *stats)
+{
+    uint8_t window[WINDOW_SIZE];
+    memcpy(window, data, len);
+    return sensor_frame_scan(s_formats, 1, window, len, collect_frame, collect, stats);
+}
+
+/**
+ * @brief 帧构造 -> 扫描 -> 解析 -> JSON/二进制编码往返
+ */
+static void test_codec_roundtrip(void)
+{
+    uint32_t rng = 0x12345678;
+    for (int n = 0; n < 1000; n++) {
+        m701_sensor_data_t sample, parsed;
+        uint8_t frame[M701_FRAME_SIZE];
+        host_random_sample(&rng, &sample);
+        host_build_m701_frame(&sample, frame);
+        
+        CHECK(sensor_frame_checksum_sum8(frame, sizeof(frame)));
+        collect_ctx_t collect = { .samples = &parsed, .max = 1 };
+        CHECK(scan_once(frame, sizeof(frame), &collect, NULL) == 0);
+        CHECK(collect.count == 1);
+        CHECK(parsed.valid);
+        CHECK(sample_equal(&sample, &parsed));
+        
+        uint8_t bin[M701_BIN_SAMPLE_LEN];
+        CHECK(m701_codec_encode(&parsed, M701_PAYLOAD_BINARY, bin, sizeof(bin)) == M701_BIN_SAMPLE_LEN);
+        CHECK(bin[0] == M701_BIN_VERSION && bin[1] == M701_BIN_TYPE_SAMPLE);
+        CHECK((bin[2] | (bin[3] << 8)) == sample.co2);
+        CHECK((bin[10] | (bin[11] << 8)) == sample.pm10);
+        CHECK((int16_t)(bin[12] | (bin[13] << 8)) == M701_TO_CENTI(sample.temperature));
+        CHECK((bin[14] | (bin[15] << 8)) == M701_TO_CENTI(sample.humidity));
+        
+        char json[128];
+        int len = m701_codec_encode(&parsed, M701_PAYLOAD_JSON, (uint8_t *)json, sizeof(json));
+        CHECK(len > 0 && json[len] == '\0');
+        int co2, hcho, tvoc, pm25, pm10;
+        float temp, humi;
+        CHECK(sscanf(json, "{\"co2\":%d,\"hcho\":%d,\"tvoc\":%d,\"pm25\":%d,\"pm10\":%d,\"temp\":%f,\"humi\":%f}",
+                     &co2, &hcho, &tvoc, &pm25, &pm10, &temp, &humi) == 7);
+        CHECK(co2 == sample.co2 && hcho == sample.hcho && tvoc == sample.tvoc &&
+              pm25 == sample.pm25 && pm10 == sample.pm10);
+        CHECK(fabsf(temp - sample.temperature) < 0.051f);      // JSON保留1位小数
+        CHECK(fabsf(humi - sample.humidity) < 0.051f);
+    }
+    
+    // 缓冲区不足时不输出截断的负载
+    m701_sensor_data_t sample = { .co2 = 400, .valid = true };
+    uint8_t small[8];
+    CHECK(m701_codec_encode(&sample, M701_PAYLOAD_BINARY, small, sizeof(small)) == 0);
+    CHECK(m701_codec_encode(&sample, M701_PAYLOAD_JSON, small, sizeof(small)) == 0);
+}
+
+/**
+ * @brief 伪帧头（含与真帧重叠的情况）不会吞掉后面的真帧
+ */
+static void test_fake_headers(void)
+{
+    m701_sensor_data_t sample = { .co2 = 812, .hcho = 12, .tvoc = 340, .pm25 = 35, .pm10 = 48,
+                                  .temperature = 23.45f, .humidity = 56.7f, .valid = true };
+    uint8_t frame[M701_FRAME_SIZE];
+    host_build_m701_frame(&sample, frame);
+    
+    // 伪帧头后紧跟真帧：伪帧窗口覆盖真帧的前15字节
+    for (size_t gap = 0; gap < M701_FRAME_SIZE; gap++) {
+        uint8_t data[2 + M701_FRAME_SIZE * 2];
+        size_t len = 0;
+        data[len++] = M701_FRAME_HEADER;
+        data[len++] = 0x02;
+        for (size_t i = 0; i < gap; i++) {
+            data[len++] = 0xA5;
+        }
+        memcpy(data + len, frame, sizeof(frame));
+        len += sizeof(frame);
+        
+        m701_sensor_data_t parsed;
+        collect_ctx_t collect = { .samples = &parsed, .max = 1 };
+        sensor_frame_stats_t stats = { 0 };
+        size_t remain = scan_once(data, len, &collect, &stats);
+        CHECK(collect.count == 1);
+        CHECK(remain == 0);
+        CHECK(sample_equal(&sample, &parsed));
+        CHECK(stats.noise_bytes == 2 + gap);
+    }
+    
+    // 噪声流按随机长度分片送入接收窗口（模拟UART读取），真帧全部按顺序解析出来
+    static uint8_t stream[STREAM_SIZE];
+    static m701_sensor_data_t expected[STREAM_SIZE / M701_FRAME_SIZE];
+    static m701_sensor_data_t parsed[STREAM_SIZE / M701_FRAME_SIZE];
+    uint32_t rng = 0xC0FFEE;
+    size_t frames = 0;
+    size_t len = host_build_noisy_stream(&rng, stream, sizeof(stream), &frames, 24, expected);
+    CHECK(frames > 1000);
+    
+    collect_ctx_t collect = { .samples = parsed, .max = frames };
+    uint8_t window[WINDOW_SIZE];
+    size_t window_len = 0;
+    size_t pos = 0;
+    while (pos < len) {
+        size_t chunk = 1 + host_rand(&rng) % 64;
+        if (chunk > len - pos) {
+            chunk = len - pos;
+        }
+        if (chunk > sizeof(window) - window_len) {
+            chunk = sizeof(window) - window_len;
+        }
+        memcpy(window + window_len, stream + pos, chunk);
+        pos += chunk;
+        window_len = sensor_frame_scan(s_formats, 1, window, window_len + chunk, collect_frame, &collect, NULL);
+    }
+    CHECK(collect.count == frames);
+    CHECK(window_len == 0);
+    size_t mismatched = 0;
+    for (size_t i = 0; i < frames && i < collect.count; i++) {
+        if (!sample_equal(&expected[i], &parsed[i])) {
+            mismatched++;
+        }
+    }
+    CHECK(mismatched == 0);
+}
+
+/**
+ * @brief 校验错误的帧被丢弃并计数，未收完的帧保留在窗口中
+ */
+static void test_checksum_reject(void)
+{
+    m701_sensor_data_t sample = { .co2 = 1000, .pm25 = 20, .temperature = -5.25f, .humidity = 30.0f, .valid = true };
+    uint8_t frame[M701_FRAME_SIZE];
+    host_build_m701_frame(&sample, frame);
+    
+    // 校验字节或数据字节被改动：不回调，计一次校验错误
+    for (size_t i = 2; i < M701_FRAME_SIZE; i++) {
+        uint8_t bad[M701_FRAME_SIZE];
+        memcpy(bad, frame, sizeof(frame));
+        bad[i] ^= 0x10;
+        collect_ctx_t collect = { 0 };
+        sensor_frame_stats_t stats = { 0 };
+        scan_once(bad, sizeof(bad), &collect, &stats);
+        CHECK(collect.count == 0);
+        CHECK(stats.checksum_errors == 1);
+        CHECK(!sensor_frame_checksum_sum8(bad, sizeof(bad)));
+    }
+    
+    // 坏帧之后的真帧照常解析
+    uint8_t data[M701_FRAME_SIZE * 2];
+    memcpy(data, frame, sizeof(frame));
+    data[M701_FRAME_SIZE - 1] ^= 0xFF;
+    memcpy(data + M701_FRAME_SIZE, frame, sizeof(frame));
+    m701_sensor_data_t parsed;
+    collect_ctx_t collect = { .samples = &parsed, .max = 1 };
+    sensor_frame_stats_t stats = { 0 };
+    CHECK(scan_once(data, sizeof(data), &collect, &stats) == 0);
+    CHECK(collect.count == 1);
+    CHECK(stats.checksum_errors == 1);
+    CHECK(sample_equal(&sample, &parsed));
+    
+    // 任意位置截断：剩余字节留在窗口，补齐后恰好解析一次
+    for (size_t cut = 1; cut < M701_FRAME_SIZE; cut++) {
+        uint8_t window[WINDOW_SIZE];
+        collect_ctx_t split = { .samples = &parsed, .max = 1 };
+        memcpy(window, frame, cut);
+        size_t remain = sensor_frame_scan(s_formats, 1, window, cut, collect_frame, &split, NULL);
+        CHECK(split.count == 0);
+        CHECK(remain == cut);
+        memcpy(window + remain, frame + cut, sizeof(frame) - cut);
+        remain = sensor_frame_scan(s_formats, 1, window, sizeof(frame), collect_frame, &split, NULL);
+        CHECK(split.count == 1);
+        CHECK(remain == 0);
+    }
+}
+
+/**
+ * @brief LED字符串/二进制帧解析与打包往返、帧准备
+ */
+static void test_led_frames(void)
+{
+    enum { LEDS = 300 };
+    uint8_t leds[LEDS], decoded[LEDS];
+    uint8_t packet[BLE_LED_BIN_HEADER_LEN + BLE_LED_BIN_PAYLOAD_LEN(LEDS)];
+    uint32_t rng = 0xBEEF;
+    
+    for (int n = 0; n < 200; n++) {
+        for (int i = 0; i < LEDS; i++) {
+            leds[i] = host_rand(&rng) & 0x07;
+        }
+        uint16_t offset = host_rand(&rng) % LEDS;
+        uint16_t count = 1 + host_rand(&rng) % (LEDS - offset);
+        memset(decoded, 0xEE, sizeof(decoded));
+        
+        uint16_t len = ble_protocol_pack_led_binary(leds, offset, count, packet);
+        CHECK(len == BLE_LED_BIN_HEADER_LEN + BLE_LED_BIN_PAYLOAD_LEN(count));
+        CHECK(ble_protocol_parse_led_binary(packet, len, decoded, LEDS));
+        CHECK(memcmp(decoded + offset, leds + offset, count) == 0);
+        CHECK(offset == 0 || decoded[offset - 1] == 0xEE);
+        CHECK(offset + count == LEDS || decoded[offset + count] == 0xEE);
+        
+        // 长度不符或区间越界的帧被拒绝
+        CHECK(!ble_protocol_parse_led_binary(packet, len - 1, decoded, LEDS));
+        CHECK(!ble_protocol_parse_led_binary(packet, len, decoded, offset + count - 1));
+    }
+    
+    // 字符串：不足部分熄灭，非法字符拒绝
+    const char *str = "01234567";
+    CHECK(ble_protocol_parse_led_string((const uint8_t *)str, 8, decoded, 60));
+    CHECK(decoded[0] == 0 && decoded[7] == 7 && decoded[8] == 0 && decoded[59] == 0);
+    CHECK(!ble_protocol_parse_led_string((const uint8_t *)"0128", 4, decoded, 60));
+    
+    // 帧准备：越界索引替换，亮度缩放
+    uint8_t raw[4] = { 0, 7, 8, 255 };
+    ws2812_frame_sanitize(raw, raw, 4, 8);
+    CHECK(raw[0] == 0 && raw[1] == 7 && raw[2] == WS2812_FRAME_INVALID_COLOR && raw[3] == WS2812_FRAME_INVALID_COLOR);
+    CHECK(ws2812_frame_scale_color(0xFF8040, 255) == 0xFF8040);
+    CHECK(ws2812_frame_scale_color(0xFF8040, 0) == 0);
+    CHECK(ws2812_frame_scale_color(0xFF8040, 128) == 0x804020);
+    
+    float angle;
+    CHECK(ble_protocol_parse_servo((const uint8_t *)"135.5", 5, &angle) && angle == 135.5f);
+    CHECK(!ble_protocol_parse_servo((const uint8_t *)"300", 3, &angle));
+}
+
+int main(void)
+{
+    test_codec_roundtrip();
+    test_fake_headers();
+    test_checksum_reject();
+    test_led_frames();
+    
+    if (s_failures) {
+        printf("%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    printf("all host tests passed\n");
+    return 0;
+}